@@ -6,405 +6,1099 @@
 #include <cctype>
 #include <cmath> // Include for fabs, fabsl (global), isinf etc.
 #include <cerrno>
+#include <cstdarg>   // va_list for formatting diagnostics
 #include <stdexcept>
 #include <vector>
 #include <numeric>   // std::accumulate
 #include <algorithm> // std::sort, std::reverse, std::find, std::max_element, std::min_element, std::shuffle, std::copy, std::all_of, std::find_if_not
-#include <random>    // std::random_device, std::mt19937, std::uniform_int_distribution, std::uniform_real_distribution
-#include <chrono>    // std::chrono::high_resolution_clock, std::chrono::duration
+#include <random>    // std::random_device, std::mt19937_64, std::uniform_int_distribution, std::uniform_real_distribution
+#include <chrono>    // std::chrono::steady_clock, std::chrono::duration
 #include <set>       // For array_unique_int
-#include <sstream>   // For string splitting and joining, string to num conversion
+#include <string_view> // Zero-copy splitting
+#include <charconv>  // std::to_chars for StringBuilder
+#include <thread>    // std::thread for parallel shuffle
+#include <atomic>    // std::atomic task counter for parallel helpers
+#include <mutex>     // Profiling ring registry
+#include <condition_variable> // Waking the background trace flush
+#include <system_error> // std::system_error if a worker thread cannot start
+#include <new>       // Replacement operator new/delete for allocation tracking
+
+// SIMD byte scanning: SSE2 is part of the x86-64 baseline; SSSE3/AVX2 kernels are compiled
+// with per-function target attributes and picked at runtime, so no -mavx2 is needed.
+#if defined(__x86_64__) || defined(_M_X64)
+#define ATOMIX_X86_64 1
+#include <immintrin.h>
+#endif
+#if defined(ATOMIX_X86_64) && (defined(__GNUC__) || defined(__clang__))
+#define ATOMIX_SIMD_DISPATCH 1
+#define ATOMIX_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define ATOMIX_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h> // _BitScanForward, __cpuid, __rdtsc
+#endif
+#if defined(ATOMIX_X86_64) && (defined(__GNUC__) || defined(__clang__))
+#include <cpuid.h>  // __get_cpuid for the invariant-TSC check
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+#define ATOMIX_POSIX 1
+#include <unistd.h>   // read, isatty for batch input
+#include <poll.h>     // poll for timed input
+#include <fcntl.h>    // open for MappedFileSource
+#include <sys/mman.h> // mmap
+#include <sys/stat.h> // fstat
+#endif
+#if defined(__linux__)
+#define ATOMIX_PERF_EVENTS 1
+#include <linux/perf_event.h> // perf_event_attr for PerfCounterGroup
+#include <sys/syscall.h>      // SYS_perf_event_open: glibc has no wrapper
+#include <sys/ioctl.h>        // PERF_EVENT_IOC_* to start and stop the group
+#endif
 
 // --- Global Random Engine ---
-static std::mt19937 global_random_engine;
+static std::mt19937_64 global_random_engine; // 64-bit output: one call per Ziggurat draw
 static bool random_initialized = false;
 
-// --- Input Functions ---
+// --- Parallel Helpers (Internal) ---
 
-// ... (get_string, get_char, get_int, get_long, get_float remain the same) ...
-std::string get_string(const char *prompt)
-{
-    if (prompt != nullptr)
-    {
-        std::cout << prompt << std::flush;
+// Runs task(i) for every i in [0, task_count) on up to num_threads threads (0 = all cores).
+// Tasks are claimed through an atomic counter and each task derives its own state from
+// its index, so results never depend on how many threads ran or which thread ran what.
+template <typename Task>
+static void run_parallel_tasks(size_t task_count, unsigned int num_threads, const Task& task) {
+    if (num_threads == 0) {
+        num_threads = std::thread::hardware_concurrency();
+        if (num_threads == 0) num_threads = 1;
     }
-
-    std::string line;
-    if (std::getline(std::cin, line))
-    {
-        return line;
+    if (num_threads > task_count) {
+        num_threads = static_cast<unsigned int>(task_count);
     }
-    else
-    {
-        if (std::cin.eof())
-        {
-            // Return empty string on EOF, let caller decide how to handle
-        }
-        else if (std::cin.fail())
-        {
-            std::cerr << "Error: Input error in get_string." << std::endl;
-            std::cin.clear(); // Attempt to clear error flags
-            // Consume the rest of the bad line if possible
-            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    if (num_threads <= 1) {
+        for (size_t i = 0; i < task_count; ++i) {
+            task(i);
         }
-        return ""; // Return empty string on error too
+        return;
     }
-}
-
-char get_char(const char *prompt)
-{
-    const char *current_prompt = prompt;
-    while (true)
-    {
-        std::string line = get_string(current_prompt);
-        if (line.empty() && (std::cin.eof() || std::cin.fail()))
-        {
-            std::cerr << "\nInput error or EOF encountered. Cannot get character." << std::endl;
-            return '\0'; // Indicate failure
-        }
 
-        if (line.length() == 1)
-        {
-            return line[0];
+    std::atomic<size_t> next_task(0);
+    auto worker = [&]() {
+        size_t i;
+        while ((i = next_task.fetch_add(1, std::memory_order_relaxed)) < task_count) {
+            task(i);
         }
+    };
 
-        if (current_prompt == nullptr)
-        {
-            current_prompt = "Retry: ";
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads - 1);
+    for (unsigned int t = 0; t + 1 < num_threads; ++t) {
+        try {
+            threads.emplace_back(worker);
+        } catch (const std::system_error&) {
+            break; // Out of threads: the remaining work runs on the threads we have
         }
-        std::cout << "Invalid input. Please enter exactly one character." << std::endl;
+    }
+    worker();
+    for (std::thread& th : threads) {
+        th.join();
     }
 }
 
-int get_int(const char *prompt)
-{
-    const char *current_prompt = prompt;
-    while (true)
-    {
-        std::string line = get_string(current_prompt);
-        if (line.empty() && (std::cin.eof() || std::cin.fail())) {
-            std::cerr << "\nInput error or EOF encountered. Cannot get integer." << std::endl;
-            return 0; // Indicate failure or default
-        }
+// SplitMix64 finaliser: turns (seed, stream index) into well-mixed independent seeds
+static unsigned long long mix_seed(unsigned long long seed, unsigned long long stream) {
+    unsigned long long z = seed + 0x9E3779B97F4A7C15ULL * (stream + 1);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
 
-        if (line.empty()) {
-            if (current_prompt == nullptr) current_prompt = "Retry: ";
-             std::cout << "Invalid input. Please enter an integer." << std::endl;
-             continue;
+// Unbiased integer in [0, bound) (Lemire's multiply-shift with rejection)
+static inline unsigned long long bounded_random(std::mt19937_64& rng, unsigned long long bound) {
+#if defined(__SIZEOF_INT128__)
+    unsigned __int128 m = static_cast<unsigned __int128>(rng()) * bound;
+    unsigned long long low = static_cast<unsigned long long>(m);
+    if (low < bound) {
+        unsigned long long threshold = (0 - bound) % bound;
+        while (low < threshold) {
+            m = static_cast<unsigned __int128>(rng()) * bound;
+            low = static_cast<unsigned long long>(m);
         }
+    }
+    return static_cast<unsigned long long>(m >> 64);
+#else
+    unsigned long long limit = std::numeric_limits<unsigned long long>::max() -
+                               std::numeric_limits<unsigned long long>::max() % bound;
+    unsigned long long r;
+    do {
+        r = rng();
+    } while (r >= limit);
+    return r % bound;
+#endif
+}
 
-        try
-        {
-            size_t pos;
-            long n = std::stol(line, &pos); // Use long for wider range check
-
-            // Check for trailing non-whitespace characters
-            while (pos < line.length() && std::isspace(static_cast<unsigned char>(line[pos])))
-            {
-                pos++;
-            }
+// Plain Fisher-Yates on a private engine (portable and reproducible, unlike std::shuffle)
+template <typename T>
+static void fisher_yates_shuffle(T *data, size_t size, std::mt19937_64& rng) {
+    for (size_t i = size; i > 1; --i) {
+        size_t j = static_cast<size_t>(bounded_random(rng, i));
+        std::swap(data[i - 1], data[j]);
+    }
+}
 
-            if (pos != line.length())
-            {
-                 if (current_prompt == nullptr) current_prompt = "Retry: ";
-                std::cout << "Invalid input. Trailing characters found after integer." << std::endl;
-                continue;
-            }
+const size_t PARALLEL_SHUFFLE_MIN_SIZE = 1 << 18;      // Below this a serial pass is faster
+const size_t PARALLEL_SHUFFLE_BUCKET_TARGET = 1 << 16; // Elements per bucket (stays in L2)
+const size_t PARALLEL_SHUFFLE_MAX_BUCKETS = 1024;      // Caps the scatter fan-out
+const size_t PARALLEL_SHUFFLE_CHUNKS = 64;             // Independent label streams
+
+// Replays the bucket labels of one chunk. Labels are bucket_bits-wide slices of 64-bit
+// draws from a stream seeded by (seed, chunk), so the count and scatter passes agree.
+template <typename Visit>
+static void for_each_bucket_label(unsigned long long seed, size_t chunk, size_t begin, size_t end,
+                                  unsigned int bucket_bits, const Visit& visit) {
+    const unsigned int labels_per_draw = 64 / bucket_bits;
+    const unsigned long long label_mask = (1ULL << bucket_bits) - 1;
+    std::mt19937_64 rng(mix_seed(seed, chunk));
+    unsigned long long bits = 0;
+    unsigned int left = 0;
+    for (size_t i = begin; i < end; ++i) {
+        if (left == 0) {
+            bits = rng();
+            left = labels_per_draw;
+        }
+        visit(i, static_cast<size_t>(bits & label_mask));
+        bits >>= bucket_bits;
+        --left;
+    }
+}
 
-            // Check if the value fits within an int
-            if (n < std::numeric_limits<int>::min() || n > std::numeric_limits<int>::max())
-            {
-                if (current_prompt == nullptr) current_prompt = "Retry: ";
-                std::cout << "Input out of range for standard integer type (int). Please enter a value between " << std::numeric_limits<int>::min() << " and " << std::numeric_limits<int>::max() << "." << std::endl;
-                continue;
-            }
+// Bucketed scatter-then-shuffle (Rao-Sandelius). Every element goes to a uniformly random
+// bucket, then each bucket is Fisher-Yates shuffled; concatenating the buckets gives a
+// uniform permutation. All RNG streams are derived from the seed and a task index, so the
+// output depends only on the seed, not on the thread count.
+template <typename T>
+static void parallel_shuffle(T *data, size_t size, unsigned long long seed, unsigned int num_threads) {
+    if (data == nullptr || size < 2) {
+        return;
+    }
+    if (size < PARALLEL_SHUFFLE_MIN_SIZE) {
+        std::mt19937_64 rng(mix_seed(seed, 0));
+        fisher_yates_shuffle(data, size, rng);
+        return;
+    }
 
-            return static_cast<int>(n);
-        }
-        catch (const std::invalid_argument& e)
-        {
-            if (current_prompt == nullptr) current_prompt = "Retry: ";
-            std::cout << "Invalid input. Not a valid integer." << std::endl;
-        }
-        catch (const std::out_of_range& e)
-        {
-             if (current_prompt == nullptr) current_prompt = "Retry: ";
-            std::cout << "Input out of range for internal parsing type. Please enter a valid integer within int limits." << std::endl;
+    // Power-of-two bucket count so a label is a plain slice of random bits (no modulo bias)
+    unsigned int bucket_bits = 1;
+    while ((static_cast<size_t>(1) << bucket_bits) < PARALLEL_SHUFFLE_MAX_BUCKETS &&
+           (size >> bucket_bits) > PARALLEL_SHUFFLE_BUCKET_TARGET) {
+        ++bucket_bits;
+    }
+    const size_t bucket_count = static_cast<size_t>(1) << bucket_bits;
+    const size_t chunk_count = PARALLEL_SHUFFLE_CHUNKS;
+    const size_t chunk_size = (size + chunk_count - 1) / chunk_count;
+
+    // Pass 1: per-chunk bucket histograms
+    std::vector<size_t> offsets(chunk_count * bucket_count, 0);
+    run_parallel_tasks(chunk_count, num_threads, [&](size_t chunk) {
+        size_t begin = std::min(size, chunk * chunk_size);
+        size_t end = std::min(size, begin + chunk_size);
+        size_t *row = &offsets[chunk * bucket_count];
+        for_each_bucket_label(seed, chunk, begin, end, bucket_bits,
+                              [row](size_t, size_t bucket) { ++row[bucket]; });
+    });
+
+    // Exclusive prefix sum in (bucket, chunk) order: each chunk owns a slice of each bucket
+    std::vector<size_t> bucket_start(bucket_count + 1, 0);
+    size_t running = 0;
+    for (size_t b = 0; b < bucket_count; ++b) {
+        bucket_start[b] = running;
+        for (size_t c = 0; c < chunk_count; ++c) {
+            size_t n = offsets[c * bucket_count + b];
+            offsets[c * bucket_count + b] = running;
+            running += n;
         }
     }
+    bucket_start[bucket_count] = running;
+
+    // Pass 2: scatter into the scratch buffer
+    std::vector<T> scratch(size);
+    run_parallel_tasks(chunk_count, num_threads, [&](size_t chunk) {
+        size_t begin = std::min(size, chunk * chunk_size);
+        size_t end = std::min(size, begin + chunk_size);
+        size_t *cursor = &offsets[chunk * bucket_count];
+        for_each_bucket_label(seed, chunk, begin, end, bucket_bits, [&](size_t i, size_t bucket) {
+            scratch[cursor[bucket]++] = std::move(data[i]);
+        });
+    });
+
+    // Pass 3: shuffle every bucket on its own stream and move it back in place
+    run_parallel_tasks(bucket_count, num_threads, [&](size_t bucket) {
+        size_t begin = bucket_start[bucket];
+        size_t end = bucket_start[bucket + 1];
+        std::mt19937_64 rng(mix_seed(seed, chunk_count + bucket));
+        fisher_yates_shuffle(scratch.data() + begin, end - begin, rng);
+        std::move(scratch.begin() + begin, scratch.begin() + end, data + begin);
+    });
 }
 
-long get_long(const char *prompt)
-{
-    const char *current_prompt = prompt;
-    while (true)
-    {
-        std::string line = get_string(current_prompt);
-         if (line.empty() && (std::cin.eof() || std::cin.fail())) {
-            std::cerr << "\nInput error or EOF encountered. Cannot get long integer." << std::endl;
-            return 0L;
-        }
+// --- Diagnostics ---
+// Hot functions report failures here instead of to std::cerr, which would take the stream
+// lock and flush inside the caller's loop. The report is formatted into a fixed buffer and
+// pushed to the calling thread's ring. Rings are registered under a mutex when a thread first
+// reports. The writer thread drains them under that mutex; the reporter never takes it again.
+
+// Fixed-capacity single-producer/single-consumer queue; push fails when it is full
+template <typename T, size_t Capacity>
+class SpscRing {
+    static_assert((Capacity & (Capacity - 1)) == 0, "SpscRing capacity must be a power of two");
+
+public:
+    bool push(const T& item) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) == Capacity) return false;
+        items_[head & (Capacity - 1)] = item;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
 
-        if (line.empty()) {
-            if (current_prompt == nullptr) current_prompt = "Retry: ";
-            std::cout << "Invalid input. Please enter a long integer." << std::endl;
-            continue;
+    // Calls visit(item) for everything pushed so far, then frees those slots
+    template <typename Visit>
+    size_t drain(Visit visit) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        size_t head = head_.load(std::memory_order_acquire);
+        for (size_t i = tail; i != head; ++i) {
+            visit(items_[i & (Capacity - 1)]);
         }
+        tail_.store(head, std::memory_order_release);
+        return head - tail;
+    }
 
-        try {
-            size_t pos;
-            // Use stoll for long long to detect overflow for long if needed, though stol handles long directly
-            long long n_ll = std::stoll(line, &pos);
+private:
+    alignas(64) std::atomic<size_t> head_{0}; // Separate cache lines: producer and consumer don't share
+    alignas(64) std::atomic<size_t> tail_{0};
+    T items_[Capacity];
+};
 
-            while (pos < line.length() && std::isspace(static_cast<unsigned char>(line[pos]))) {
-                pos++;
-            }
+const size_t DIAGNOSTIC_RING_ENTRIES = 256; // 32 KB per reporting thread
 
-            if (pos != line.length()) {
-                if (current_prompt == nullptr) current_prompt = "Retry: ";
-                std::cout << "Invalid input. Trailing characters found after long integer." << std::endl;
-                continue;
-            }
+struct DiagnosticRing {
+    SpscRing<Diagnostic, DIAGNOSTIC_RING_ENTRIES> entries;
+    std::atomic<bool> thread_exited{false};
+};
 
-            // Check if the value fits within a long
-            if (n_ll < std::numeric_limits<long>::min() || n_ll > std::numeric_limits<long>::max())
-            {
-                if (current_prompt == nullptr) current_prompt = "Retry: ";
-                std::cout << "Input out of range for long integer type. Please enter a value between " << std::numeric_limits<long>::min() << " and " << std::numeric_limits<long>::max() << "." << std::endl;
-                continue;
-            }
+struct DiagnosticRegistry {
+    std::mutex mutex; // Guards rings and writer start-up, and serializes drains
+    std::vector<std::shared_ptr<DiagnosticRing>> rings;
+
+    std::thread writer;
+    std::mutex stop_mutex;
+    std::condition_variable stop_signal;
+    bool stopping = false;
 
+    ~DiagnosticRegistry();
+};
 
-            return static_cast<long>(n_ll);
-        } catch (const std::invalid_argument& e) {
-            if (current_prompt == nullptr) current_prompt = "Retry: ";
-            std::cout << "Invalid input. Not a valid long integer." << std::endl;
-        } catch (const std::out_of_range& e) {
-            if (current_prompt == nullptr) current_prompt = "Retry: ";
-            std::cout << "Input out of range. Please enter a valid long integer between " << std::numeric_limits<long>::min() << " and " << std::numeric_limits<long>::max() << "." << std::endl;
+static size_t write_queued_diagnostics(DiagnosticRegistry& registry) {
+    std::string text;
+    size_t written = 0;
+    {
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for (size_t i = 0; i < registry.rings.size();) {
+            DiagnosticRing& ring = *registry.rings[i];
+            bool exited = ring.thread_exited.load(std::memory_order_acquire); // Before the drain: nothing can follow it
+            written += ring.entries.drain([&](const Diagnostic& d) {
+                text += format_diagnostic(d);
+                text += '\n';
+            });
+            if (exited) {
+                registry.rings.erase(registry.rings.begin() + static_cast<std::ptrdiff_t>(i));
+            } else {
+                ++i;
+            }
         }
     }
+    if (!text.empty()) std::cerr.write(text.data(), static_cast<std::streamsize>(text.size())).flush();
+    return written;
 }
 
-float get_float(const char *prompt)
-{
-    const char *current_prompt = prompt;
-    while (true)
-    {
-        std::string line = get_string(current_prompt);
-        if (line.empty() && (std::cin.eof() || std::cin.fail())) {
-            std::cerr << "\nInput error or EOF encountered. Cannot get float." << std::endl;
-            return 0.0f;
-        }
+static void diagnostic_writer_loop(DiagnosticRegistry* registry) {
+    std::unique_lock<std::mutex> lock(registry->stop_mutex);
+    while (!registry->stop_signal.wait_for(lock, std::chrono::milliseconds(50), [registry] { return registry->stopping; })) {
+        lock.unlock();
+        write_queued_diagnostics(*registry);
+        lock.lock();
+    }
+}
 
-        if (line.empty()) {
-            if (current_prompt == nullptr) current_prompt = "Retry: ";
-            std::cout << "Invalid input. Please enter a floating-point number." << std::endl;
-            continue;
+DiagnosticRegistry::~DiagnosticRegistry() {
+    if (writer.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(stop_mutex);
+            stopping = true;
         }
+        stop_signal.notify_one();
+        writer.join();
+    }
+    write_queued_diagnostics(*this);
+}
 
-        try {
-            size_t pos;
-            // Use stod first to potentially handle wider ranges before narrowing
-            double d = std::stod(line, &pos);
+static DiagnosticRegistry& diagnostic_registry() {
+    static DiagnosticRegistry registry;
+    return registry;
+}
 
-            while (pos < line.length() && std::isspace(static_cast<unsigned char>(line[pos]))) {
-                pos++;
-            }
+static std::atomic<DiagnosticSink> diagnostic_sink{nullptr};
+static std::atomic<size_t> diagnostic_drops{0};
+static thread_local ErrorCode thread_last_error = ErrorCode::None;
 
-            if (pos != line.length()) {
-                if (current_prompt == nullptr) current_prompt = "Retry: ";
-                std::cout << "Invalid input. Trailing characters found after floating-point number." << std::endl;
-                continue;
-            }
+struct ThreadDiagnosticRing {
+    std::shared_ptr<DiagnosticRing> ring;
+    ~ThreadDiagnosticRing() {
+        if (ring) ring->thread_exited.store(true, std::memory_order_release);
+    }
+};
 
-            // Check if the value fits within float limits (approximate check)
-            if (d > std::numeric_limits<float>::max() || d < -std::numeric_limits<float>::max()) {
-                 if (d != 0.0 && !std::isinf(d) && (std::fabs(d) < std::numeric_limits<float>::min())) {
-                    // Handle underflow - treat as 0? Or reprompt? Reprompting is safer.
-                     if (current_prompt == nullptr) current_prompt = "Retry: ";
-                    std::cout << "Input magnitude too small for float type (underflow)." << std::endl;
-                    continue;
-                 } else if (!std::isinf(d)) { // Check for overflow only if not already infinite
-                    if (current_prompt == nullptr) current_prompt = "Retry: ";
-                    std::cout << "Input out of range for float type (overflow)." << std::endl;
-                    continue;
-                 }
+static DiagnosticRing& this_thread_diagnostic_ring() {
+    thread_local ThreadDiagnosticRing local;
+    if (!local.ring) {
+        local.ring = std::make_shared<DiagnosticRing>();
+        DiagnosticRegistry& registry = diagnostic_registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.rings.push_back(local.ring);
+        if (!registry.writer.joinable()) {
+            try {
+                registry.writer = std::thread(diagnostic_writer_loop, &registry);
+            } catch (const std::system_error&) {
+                // No writer: the rings are still written by flush_diagnostics() and at exit
             }
-
-
-            return static_cast<float>(d);
-        } catch (const std::invalid_argument& e) {
-            if (current_prompt == nullptr) current_prompt = "Retry: ";
-            std::cout << "Invalid input. Not a valid floating-point number." << std::endl;
-        } catch (const std::out_of_range& e) {
-             // This catch might be for stod if the number is too large/small for double
-            if (current_prompt == nullptr) current_prompt = "Retry: ";
-            std::cout << "Input out of range for internal parsing or float type. Please enter a valid float." << std::endl;
         }
     }
+    return *local.ring;
 }
 
+// Out of line and marked cold so the failure branches add only a call to the hot loops
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((cold, noinline, format(printf, 4, 5)))
+#endif
+static void report_diagnostic(ErrorCode code, DiagnosticLevel level, const char* function, const char* format, ...) {
+    thread_last_error = code;
+    Diagnostic diagnostic;
+    diagnostic.code = code;
+    diagnostic.level = level;
+    diagnostic.function = function;
+    va_list args;
+    va_start(args, format);
+    std::vsnprintf(diagnostic.message, sizeof(diagnostic.message), format, args);
+    va_end(args);
+    DiagnosticSink sink = diagnostic_sink.load(std::memory_order_acquire);
+    if (sink != nullptr) {
+        sink(diagnostic);
+        return;
+    }
+    if (!this_thread_diagnostic_ring().entries.push(diagnostic)) {
+        diagnostic_drops.fetch_add(1, std::memory_order_relaxed);
+    }
+}
 
-double get_double(const char *prompt)
-{
-    const char *current_prompt = prompt;
-    while (true)
-    {
-        std::string line = get_string(current_prompt);
-        if (line.empty() && (std::cin.eof() || std::cin.fail())) {
-            std::cerr << "\nInput error or EOF encountered. Cannot get double." << std::endl;
-            return 0.0;
-        }
+// Argument checks that fail on a null pointer or an empty input only set last_error(): such
+// calls are common and cheap to retry, so a message for each would be noise
+static inline void set_last_error(ErrorCode code) {
+    thread_last_error = code;
+}
 
-        if (line.empty()) {
-            if (current_prompt == nullptr) current_prompt = "Retry: ";
-            std::cout << "Invalid input. Please enter a double-precision number." << std::endl;
-            continue;
-        }
+void set_diagnostic_sink(DiagnosticSink sink) {
+    diagnostic_sink.store(sink, std::memory_order_release);
+}
 
-        try {
-            size_t pos;
-            // Use stold for potentially wider range check if needed, though stod handles double
-            long double ld = std::stold(line, &pos);
+ErrorCode last_error() {
+    return thread_last_error;
+}
 
-            while (pos < line.length() && std::isspace(static_cast<unsigned char>(line[pos]))) {
-                pos++;
-            }
+void clear_last_error() {
+    thread_last_error = ErrorCode::None;
+}
 
-            if (pos != line.length()) {
-                if (current_prompt == nullptr) current_prompt = "Retry: ";
-                std::cout << "Invalid input. Trailing characters found after double-precision number." << std::endl;
-                continue;
-            }
+const char* error_code_name(ErrorCode code) {
+    switch (code) {
+        case ErrorCode::None: return "None";
+        case ErrorCode::NullArgument: return "NullArgument";
+        case ErrorCode::InvalidArgument: return "InvalidArgument";
+        case ErrorCode::OutOfRange: return "OutOfRange";
+        case ErrorCode::Overflow: return "Overflow";
+        case ErrorCode::AllocationFailed: return "AllocationFailed";
+        case ErrorCode::CapacityExceeded: return "CapacityExceeded";
+    }
+    return "Unknown";
+}
 
-             // Check if the value fits within double limits (approximate check)
-            if (ld > std::numeric_limits<double>::max() || ld < -std::numeric_limits<double>::max()) {
-                 // *** Use fabsl (global scope) instead of std::fabsl ***
-                 if (ld != 0.0l && !std::isinf(ld) && (fabsl(ld) < std::numeric_limits<double>::min())) {
-                     if (current_prompt == nullptr) current_prompt = "Retry: ";
-                    std::cout << "Input magnitude too small for double type (underflow)." << std::endl;
-                    continue;
-                 } else if (!std::isinf(ld)) {
-                    if (current_prompt == nullptr) current_prompt = "Retry: ";
-                    std::cout << "Input out of range for double type (overflow)." << std::endl;
-                    continue;
-                 }
-            }
+std::string format_diagnostic(const Diagnostic& diagnostic) {
+    std::string text = (diagnostic.level == DiagnosticLevel::Warning) ? "Warning in " : "Error in ";
+    text += diagnostic.function;
+    text += ": ";
+    text += diagnostic.message;
+    return text;
+}
 
+void flush_diagnostics() {
+    write_queued_diagnostics(diagnostic_registry());
+}
 
-            return static_cast<double>(ld);
-        } catch (const std::invalid_argument& e) {
-            if (current_prompt == nullptr) current_prompt = "Retry: ";
-            std::cout << "Invalid input. Not a valid double-precision number." << std::endl;
-        } catch (const std::out_of_range& e) {
-            if (current_prompt == nullptr) current_prompt = "Retry: ";
-            std::cout << "Input out of range. Please enter a valid double-precision number within double limits." << std::endl;
-        }
-    }
+size_t diagnostics_dropped() {
+    return diagnostic_drops.load(std::memory_order_relaxed);
 }
 
-// ... (get_int_range, get_string_non_empty remain the same) ...
-int get_int_range(const char *prompt, int min_val, int max_val) {
-    if (min_val > max_val) {
-        std::cerr << "Error in get_int_range: min_val (" << min_val
-                  << ") cannot be greater than max_val (" << max_val << ")." << std::endl;
-        // Or swap them? For now, return min_val as an error indicator might be confusing.
-        // Let's throw or return a sentinel? Sticking to return for now.
-        return min_val; // Or perhaps throw std::invalid_argument
-    }
+// --- Numeric Parsing Core (Internal) ---
+// Shared by the get_* input functions and the string_to_* converters. Works on a view of
+// the input: no trimmed copy, no exceptions, and std::from_chars does the conversion.
+// Accepts surrounding whitespace and a leading '+' (as std::sto* did); floating point also
+// accepts "inf"/"infinity" but rejects NaN and hexadecimal floats.
 
-    const char *current_prompt = prompt;
-    std::string range_prompt_suffix = " (between " + std::to_string(min_val) + " and " + std::to_string(max_val) + "): ";
-    std::string full_prompt;
+enum class NumberStatus { Ok, Empty, Invalid, Trailing, Overflow, Underflow };
 
-    if (prompt) {
-        full_prompt = std::string(prompt) + range_prompt_suffix;
-    } else {
-        full_prompt = "Enter an integer" + range_prompt_suffix;
-    }
+static inline bool is_space_byte(char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r'); // " \t\n\v\f\r"
+}
 
+// Inline loops: find_first_not_of runs a memchr per byte, which dominates on short fields
+static inline std::string_view trim_view(std::string_view str) {
+    size_t first = 0;
+    size_t last = str.size();
+    while (first < last && is_space_byte(str[first])) ++first;
+    while (last > first && is_space_byte(str[last - 1])) --last;
+    return str.substr(first, last - first);
+}
 
-    while (true) {
-        int value = get_int(full_prompt.c_str()); // Use existing get_int for validation
+// Skips an explicit '+'; from_chars only accepts '-'. Returns false for "+" or "+-..."
+static bool skip_plus_sign(const char*& first, const char* last) {
+    if (*first != '+') return true;
+    ++first;
+    return first != last && *first != '-';
+}
 
-        // Check if get_int failed due to EOF/error
-        if (std::cin.eof() || std::cin.fail()) {
-             // get_int already printed an error, just return something
-             return min_val; // Or a specific error code if preferred
+template <typename T>
+static NumberStatus parse_integer(std::string_view str, T& out) {
+    std::string_view text = trim_view(str);
+    if (text.empty()) return NumberStatus::Empty;
+    const char* first = text.data();
+    const char* last = first + text.size();
+    if (!skip_plus_sign(first, last)) return NumberStatus::Invalid;
+
+    T value;
+    std::from_chars_result result = std::from_chars(first, last, value);
+    if (result.ec == std::errc::invalid_argument) return NumberStatus::Invalid;
+    if (result.ptr != last) return NumberStatus::Trailing;
+    if (result.ec == std::errc::result_out_of_range) return NumberStatus::Overflow;
+    out = value;
+    return NumberStatus::Ok;
+}
+
+// An out-of-range value overflowed if its magnitude is at least 1 and underflowed otherwise.
+// The decimal order of the first nonzero digit tells which without copying or re-parsing.
+static NumberStatus classify_out_of_range(const char* first, const char* last) {
+    const long long order_limit = 1000000000LL; // Far past any floating-point range
+    const char* p = first;
+    if (p != last && *p == '-') ++p;
+    long long order = 0;
+    bool nonzero = false;
+    while (p != last && *p == '0') ++p;
+    while (p != last && *p >= '0' && *p <= '9') { // Integer digits after the leading zeros
+        nonzero = true;
+        if (order < order_limit) ++order;
+        ++p;
+    }
+    if (nonzero) {
+        order -= 1;
+    } else if (p != last && *p == '.') {
+        ++p;
+        order = -1;
+        while (p != last && *p == '0') { // Fraction zeros before the first nonzero digit
+            if (order > -order_limit) --order;
+            ++p;
+        }
+        nonzero = (p != last && *p >= '1' && *p <= '9');
+    }
+    if (!nonzero) return NumberStatus::Underflow;
+    while (p != last && *p != 'e' && *p != 'E') ++p;
+    if (p != last) {
+        ++p;
+        bool negative = (p != last && *p == '-');
+        if (p != last && (*p == '-' || *p == '+')) ++p;
+        long long exponent = 0;
+        for (; p != last && *p >= '0' && *p <= '9'; ++p) {
+            if (exponent < order_limit) exponent = exponent * 10 + (*p - '0');
         }
+        order += negative ? -exponent : exponent;
+    }
+    return (order >= 0) ? NumberStatus::Overflow : NumberStatus::Underflow;
+}
 
+template <typename T>
+static NumberStatus parse_floating(std::string_view str, T& out) {
+    std::string_view text = trim_view(str);
+    if (text.empty()) return NumberStatus::Empty;
+    const char* first = text.data();
+    const char* last = first + text.size();
+    if (!skip_plus_sign(first, last)) return NumberStatus::Invalid;
+
+    T value;
+    std::from_chars_result result = std::from_chars(first, last, value);
+    if (result.ec == std::errc::invalid_argument) return NumberStatus::Invalid;
+    if (result.ptr != last) return NumberStatus::Trailing;
+    if (result.ec == std::errc::result_out_of_range) return classify_out_of_range(first, last);
+    if (std::isnan(value)) return NumberStatus::Invalid;
+    out = value;
+    return NumberStatus::Ok;
+}
 
-        if (value >= min_val && value <= max_val) {
-            return value;
-        } else {
-            std::cout << "Input out of range. Please enter a value between "
-                      << min_val << " and " << max_val << "." << std::endl;
-            // Prepare for retry - get_int might have set current_prompt to "Retry: "
-            // We want our specific range prompt again.
-            if (prompt) {
-                full_prompt = std::string(prompt) + range_prompt_suffix;
-            } else {
-                 full_prompt = "Retry: Enter an integer" + range_prompt_suffix;
-            }
+// --- Input Functions ---
+// Batch and timed input go through a LineReader: one growing buffer of raw bytes where a
+// line is a view, so reading costs one memchr per line and one read() per 64 KB instead of
+// a locked, character-at-a-time getline. poll() before each read() gives the timeouts.
+
+const size_t STDIN_BLOCK_SIZE = 1 << 16;
 
+static InputMode requested_input_mode = InputMode::Auto;
+static InputMode effective_input_mode = InputMode::Auto; // Auto until first resolved
+static LineReader stdin_reader(0);
+static bool stdin_reader_used = false; // Set by the first timed read; from then on it may hold lines getline would miss
+
+void set_input_mode(InputMode mode) {
+    requested_input_mode = mode;
+    effective_input_mode = InputMode::Auto;
+}
+
+InputMode get_input_mode() {
+    if (effective_input_mode == InputMode::Auto) {
+        effective_input_mode = requested_input_mode;
+        if (effective_input_mode == InputMode::Auto) {
+#if defined(ATOMIX_POSIX)
+            effective_input_mode = isatty(STDIN_FILENO) ? InputMode::Interactive : InputMode::Batch;
+#else
+            effective_input_mode = InputMode::Interactive;
+#endif
         }
     }
+    return effective_input_mode;
 }
 
-std::string get_string_non_empty(const char *prompt) {
-    const char *current_prompt = prompt;
-    while (true) {
-        std::string line = get_string(current_prompt);
+// Milliseconds left until deadline, rounded up so a wait never ends early
+static int wait_until(InputDeadline deadline) {
+    auto now = std::chrono::steady_clock::now();
+    if (deadline <= now) return 0;
+    auto left = std::chrono::ceil<std::chrono::milliseconds>(deadline - now).count();
+    return static_cast<int>(std::min<long long>(left, std::numeric_limits<int>::max()));
+}
 
-        if (line.empty() && (std::cin.eof() || std::cin.fail())) {
-            std::cerr << "\nInput error or EOF encountered. Cannot get non-empty string." << std::endl;
-            return ""; // Return empty on error/EOF
-        }
+// Waits up to wait_ms (-1 = forever) for data, then appends one read's worth to the buffer
+InputStatus LineReader::fill(int wait_ms) {
+    // Keep the partial line, moved to the front, and append after it
+    if (begin_ > 0) {
+        std::memmove(data_.data(), data_.data() + begin_, end_ - begin_);
+        end_ -= begin_;
+        scanned_ -= begin_;
+        begin_ = 0;
+    }
+    if (data_.size() - end_ < STDIN_BLOCK_SIZE) {
+        data_.resize(end_ + STDIN_BLOCK_SIZE);
+    }
+#if defined(ATOMIX_POSIX)
+    struct pollfd ready = {fd_, POLLIN, 0};
+    int polled;
+    do {
+        polled = ::poll(&ready, 1, wait_ms);
+    } while (polled < 0 && errno == EINTR);
+    if (polled < 0) return InputStatus::Error;
+    if (polled == 0) return InputStatus::Timeout;
+    ssize_t got;
+    do {
+        got = ::read(fd_, data_.data() + end_, data_.size() - end_);
+    } while (got < 0 && errno == EINTR);
+    if (got < 0) {
+        return (errno == EAGAIN || errno == EWOULDBLOCK) ? InputStatus::Timeout : InputStatus::Error;
+    }
+#else
+    (void)wait_ms;
+    if (fd_ != 0) return InputStatus::Error;
+    std::cin.read(data_.data() + end_, static_cast<std::streamsize>(data_.size() - end_));
+    std::streamsize got = std::cin.gcount();
+    std::cin.clear(); // The EOF state is set by get_line_view when no line is left
+#endif
+    if (got == 0) return InputStatus::Eof;
+    end_ += static_cast<size_t>(got);
+    return InputStatus::Ok;
+}
 
-        if (!line.empty()) {
-            return line;
+InputStatus LineReader::next_line(std::string_view& line, int wait_ms, bool until_deadline, InputDeadline deadline) {
+    while (true) {
+        const void* newline = (scanned_ < end_) ? std::memchr(data_.data() + scanned_, '\n', end_ - scanned_) : nullptr;
+        if (newline != nullptr) {
+            size_t stop = static_cast<size_t>(static_cast<const char*>(newline) - data_.data());
+            line = std::string_view(data_.data() + begin_, stop - begin_);
+            begin_ = scanned_ = stop + 1;
+            return InputStatus::Ok;
         }
-
-        if (current_prompt == nullptr) {
-            current_prompt = "Retry: ";
+        scanned_ = end_;
+        InputStatus status = fill(until_deadline ? wait_until(deadline) : wait_ms);
+        if (status == InputStatus::Eof && begin_ < end_) {
+            line = std::string_view(data_.data() + begin_, end_ - begin_); // Last line has no '\n'
+            begin_ = scanned_ = end_;
+            return InputStatus::Ok;
         }
-        std::cout << "Input cannot be empty. Please enter some text." << std::endl;
+        if (status != InputStatus::Ok) return status;
     }
 }
 
-// --- Integer Array Functions ---
-// ... (array_max, min, sum, hash table helpers, pair funcs, sort, print, contains, index_of, average, count, copy, reverse, shuffle, unique, concat remain the same) ...
-bool array_max(const int *arr, size_t size, int *max_val) {
-    if (arr == nullptr || max_val == nullptr || size == 0) {
-        return false;
-    }
+InputStatus LineReader::read_line(std::string_view& line) {
+    return next_line(line, -1, false, InputDeadline());
+}
 
-    *max_val = arr[0];
-    for (size_t i = 1; i < size; ++i) {
-        if (arr[i] > *max_val) {
-            *max_val = arr[i];
+InputStatus LineReader::read_line(std::string_view& line, InputDeadline deadline) {
+    return next_line(line, 0, true, deadline);
+}
+
+InputStatus LineReader::poll_line(std::string_view& line) {
+    return next_line(line, 0, false, InputDeadline());
+}
+
+bool StdinSource::interactive() const {
+    return get_input_mode() == InputMode::Interactive;
+}
+
+bool StdinSource::read_line(std::string_view& line) {
+    if (!interactive() || stdin_reader_used) {
+        InputStatus status = stdin_reader.read_line(line);
+        if (status == InputStatus::Error) {
+            std::cerr << "Error: Input error in get_string." << std::endl;
         }
+        return status == InputStatus::Ok;
+    }
+    static std::string buffer;
+    if (std::getline(std::cin, buffer))
+    {
+        line = buffer;
+        return true;
     }
+    if (std::cin.eof())
+    {
+        return false; // Let the caller decide how to handle EOF
+    }
+    std::cerr << "Error: Input error in get_string." << std::endl;
+    std::cin.clear(); // Attempt to clear error flags
+    // Consume the rest of the bad line if possible
+    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    line = std::string_view(); // Reported as an empty line, so callers retry
     return true;
 }
 
-bool array_min(const int *arr, size_t size, int *min_val) {
-    if (arr == nullptr || min_val == nullptr || size == 0) {
+InputStatus StdinSource::read_line_until(std::string_view& line, InputDeadline deadline) {
+    stdin_reader_used = true;
+    return stdin_reader.read_line(line, deadline);
+}
+
+bool MemorySource::read_line(std::string_view& line) {
+    if (pos_ >= data_.size()) {
         return false;
     }
+    size_t newline = data_.find('\n', pos_);
+    size_t stop = (newline == std::string_view::npos) ? data_.size() : newline;
+    line = data_.substr(pos_, stop - pos_);
+    pos_ = (newline == std::string_view::npos) ? data_.size() : newline + 1;
+    return true;
+}
 
-    *min_val = arr[0];
-    for (size_t i = 1; i < size; ++i) {
-        if (arr[i] < *min_val) {
-            *min_val = arr[i];
+MappedFileSource::MappedFileSource(const std::string& path) {
+#if defined(ATOMIX_POSIX)
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        struct stat info;
+        if (::fstat(fd, &info) == 0) {
+            open_ = true;
+            if (info.st_size > 0) {
+                void* mapping = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+                if (mapping != MAP_FAILED) {
+                    mapping_ = mapping;
+                    mapped_size_ = static_cast<size_t>(info.st_size);
+                    ::madvise(mapping_, mapped_size_, MADV_SEQUENTIAL); // Lines are read front to back
+                    data_ = std::string_view(static_cast<const char*>(mapping_), mapped_size_);
+                }
+            }
+        }
+        ::close(fd);
+        if (open_ && mapping_ != nullptr) {
+            return;
         }
     }
-    return true;
+#endif
+    // Not mapped (no mmap, an empty file or a pipe): read the file whole instead
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        open_ = false;
+        std::cerr << "Error in MappedFileSource: cannot open '" << path << "'." << std::endl;
+        return;
+    }
+    char block[1 << 16];
+    size_t got;
+    while ((got = std::fread(block, 1, sizeof(block), file)) > 0) {
+        contents_.insert(contents_.end(), block, block + got);
+    }
+    std::fclose(file);
+    open_ = true;
+    data_ = std::string_view(contents_.data(), contents_.size());
 }
 
-bool array_sum(const int *arr, size_t size, long long *sum) {
+MappedFileSource::~MappedFileSource() {
+#if defined(ATOMIX_POSIX)
+    if (mapping_ != nullptr) {
+        ::munmap(mapping_, mapped_size_);
+    }
+#endif
+}
+
+static StdinSource stdin_source;
+static InputSource* current_input_source = &stdin_source;
+
+void set_input_source(InputSource* source) {
+    current_input_source = (source != nullptr) ? source : &stdin_source;
+    std::cin.clear(); // A new source starts without the last one's EOF
+}
+
+InputSource& get_input_source() {
+    return *current_input_source;
+}
+
+std::string_view get_line_view(const char *prompt)
+{
+    InputSource& source = *current_input_source;
+    if (prompt != nullptr)
+    {
+        if (source.interactive()) {
+            std::cout << prompt << std::flush;
+        } else {
+            std::cout << prompt; // Nobody is waiting to read it, so no flush
+        }
+    }
+
+    std::string_view line;
+    if (source.read_line(line)) {
+        return line;
+    }
+    std::cin.setstate(std::ios::eofbit | std::ios::failbit); // What std::getline reports at EOF
+    return std::string_view();
+}
+
+std::string get_string(const char *prompt)
+{
+    return std::string(get_line_view(prompt));
+}
+
+char get_char(const char *prompt)
+{
+    const char *current_prompt = prompt;
+    while (true)
+    {
+        std::string_view line = get_line_view(current_prompt);
+        if (line.empty() && (std::cin.eof() || std::cin.fail()))
+        {
+            std::cerr << "\nInput error or EOF encountered. Cannot get character." << std::endl;
+            return '\0'; // Indicate failure
+        }
+
+        if (line.length() == 1)
+        {
+            return line[0];
+        }
+
+        if (current_prompt == nullptr)
+        {
+            current_prompt = "Retry: ";
+        }
+        std::cout << "Invalid input. Please enter exactly one character." << std::endl;
+    }
+}
+
+// Parse a line for the get_* number readers; on failure, explain why (they then retry)
+static bool accept_int(std::string_view line, int& n) {
+    NumberStatus status = parse_integer(line, n);
+    if (status == NumberStatus::Ok) {
+        return true;
+    }
+    if (status == NumberStatus::Empty) {
+        std::cout << "Invalid input. Please enter an integer." << std::endl;
+    } else if (status == NumberStatus::Trailing) {
+        std::cout << "Invalid input. Trailing characters found after integer." << std::endl;
+    } else if (status == NumberStatus::Overflow) {
+        std::cout << "Input out of range for standard integer type (int). Please enter a value between " << std::numeric_limits<int>::min() << " and " << std::numeric_limits<int>::max() << "." << std::endl;
+    } else {
+        std::cout << "Invalid input. Not a valid integer." << std::endl;
+    }
+    return false;
+}
+
+static bool accept_long(std::string_view line, long& n) {
+    NumberStatus status = parse_integer(line, n);
+    if (status == NumberStatus::Ok) {
+        return true;
+    }
+    if (status == NumberStatus::Empty) {
+        std::cout << "Invalid input. Please enter a long integer." << std::endl;
+    } else if (status == NumberStatus::Trailing) {
+        std::cout << "Invalid input. Trailing characters found after long integer." << std::endl;
+    } else if (status == NumberStatus::Overflow) {
+        std::cout << "Input out of range. Please enter a valid long integer between " << std::numeric_limits<long>::min() << " and " << std::numeric_limits<long>::max() << "." << std::endl;
+    } else {
+        std::cout << "Invalid input. Not a valid long integer." << std::endl;
+    }
+    return false;
+}
+
+static bool accept_float(std::string_view line, float& f) {
+    NumberStatus status = parse_floating(line, f);
+    if (status == NumberStatus::Ok) {
+        return true;
+    }
+    if (status == NumberStatus::Empty) {
+        std::cout << "Invalid input. Please enter a floating-point number." << std::endl;
+    } else if (status == NumberStatus::Trailing) {
+        std::cout << "Invalid input. Trailing characters found after floating-point number." << std::endl;
+    } else if (status == NumberStatus::Underflow) {
+        std::cout << "Input magnitude too small for float type (underflow)." << std::endl;
+    } else if (status == NumberStatus::Overflow) {
+        std::cout << "Input out of range for float type (overflow)." << std::endl;
+    } else {
+        std::cout << "Invalid input. Not a valid floating-point number." << std::endl;
+    }
+    return false;
+}
+
+static bool accept_double(std::string_view line, double& d) {
+    NumberStatus status = parse_floating(line, d);
+    if (status == NumberStatus::Ok) {
+        return true;
+    }
+    if (status == NumberStatus::Empty) {
+        std::cout << "Invalid input. Please enter a double-precision number." << std::endl;
+    } else if (status == NumberStatus::Trailing) {
+        std::cout << "Invalid input. Trailing characters found after double-precision number." << std::endl;
+    } else if (status == NumberStatus::Underflow) {
+        std::cout << "Input magnitude too small for double type (underflow)." << std::endl;
+    } else if (status == NumberStatus::Overflow) {
+        std::cout << "Input out of range for double type (overflow)." << std::endl;
+    } else {
+        std::cout << "Invalid input. Not a valid double-precision number." << std::endl;
+    }
+    return false;
+}
+
+// The retry loop shared by get_int, get_long, get_float and get_double
+template <typename T>
+static T get_number(const char *prompt, bool (*accept)(std::string_view, T&), const char *eof_message)
+{
+    const char *current_prompt = prompt;
+    while (true)
+    {
+        std::string_view line = get_line_view(current_prompt);
+        if (line.empty() && (std::cin.eof() || std::cin.fail())) {
+            std::cerr << eof_message << std::endl;
+            return T(0); // Indicate failure or default
+        }
+
+        T value = T(0);
+        if (accept(line, value)) {
+            return value;
+        }
+        if (current_prompt == nullptr) current_prompt = "Retry: ";
+    }
+}
+
+int get_int(const char *prompt)
+{
+    return get_number<int>(prompt, accept_int, "\nInput error or EOF encountered. Cannot get integer.");
+}
+
+long get_long(const char *prompt)
+{
+    return get_number<long>(prompt, accept_long, "\nInput error or EOF encountered. Cannot get long integer.");
+}
+
+float get_float(const char *prompt)
+{
+    return get_number<float>(prompt, accept_float, "\nInput error or EOF encountered. Cannot get float.");
+}
+
+double get_double(const char *prompt)
+{
+    return get_number<double>(prompt, accept_double, "\nInput error or EOF encountered. Cannot get double.");
+}
+
+// --- Timed input: the same loops against a deadline ---
+
+InputStatus get_line_view(std::string_view *line, InputDeadline deadline, const char *prompt)
+{
+    InputSource& source = get_input_source();
+    if (prompt != nullptr) {
+        std::cout << prompt << std::flush; // Someone may be waiting on it
+    }
+    std::string_view text;
+    InputStatus status = source.read_line_until(text, deadline);
+    if (status == InputStatus::Ok) {
+        *line = text;
+    } else if (status == InputStatus::Eof) {
+        std::cin.setstate(std::ios::eofbit | std::ios::failbit);
+    }
+    return status;
+}
+
+InputStatus get_string(std::string *out, InputDeadline deadline, const char *prompt)
+{
+    std::string_view line;
+    InputStatus status = get_line_view(&line, deadline, prompt);
+    if (status == InputStatus::Ok) {
+        out->assign(line.data(), line.size());
+    }
+    return status;
+}
+
+template <typename T>
+static InputStatus get_number_until(T *out, InputDeadline deadline, const char *prompt, bool (*accept)(std::string_view, T&))
+{
+    const char *current_prompt = prompt;
+    while (true) {
+        std::string_view line;
+        InputStatus status = get_line_view(&line, deadline, current_prompt);
+        if (status != InputStatus::Ok) {
+            return status;
+        }
+        T value = T(0);
+        if (accept(line, value)) {
+            *out = value;
+            return InputStatus::Ok;
+        }
+        if (current_prompt == nullptr) current_prompt = "Retry: ";
+    }
+}
+
+InputStatus get_int(int *out, InputDeadline deadline, const char *prompt)
+{
+    return get_number_until(out, deadline, prompt, accept_int);
+}
+
+InputStatus get_long(long *out, InputDeadline deadline, const char *prompt)
+{
+    return get_number_until(out, deadline, prompt, accept_long);
+}
+
+InputStatus get_float(float *out, InputDeadline deadline, const char *prompt)
+{
+    return get_number_until(out, deadline, prompt, accept_float);
+}
+
+InputStatus get_double(double *out, InputDeadline deadline, const char *prompt)
+{
+    return get_number_until(out, deadline, prompt, accept_double);
+}
+
+// ... (get_int_range, get_string_non_empty remain the same) ...
+int get_int_range(const char *prompt, int min_val, int max_val) {
+    if (min_val > max_val) {
+        std::cerr << "Error in get_int_range: min_val (" << min_val
+                  << ") cannot be greater than max_val (" << max_val << ")." << std::endl;
+        // Or swap them? For now, return min_val as an error indicator might be confusing.
+        // Let's throw or return a sentinel? Sticking to return for now.
+        return min_val; // Or perhaps throw std::invalid_argument
+    }
+
+    const char *current_prompt = prompt;
+    std::string range_prompt_suffix = " (between " + std::to_string(min_val) + " and " + std::to_string(max_val) + "): ";
+    std::string full_prompt;
+
+    if (prompt) {
+        full_prompt = std::string(prompt) + range_prompt_suffix;
+    } else {
+        full_prompt = "Enter an integer" + range_prompt_suffix;
+    }
+
+
+    while (true) {
+        int value = get_int(full_prompt.c_str()); // Use existing get_int for validation
+
+        // Check if get_int failed due to EOF/error
+        if (std::cin.eof() || std::cin.fail()) {
+             // get_int already printed an error, just return something
+             return min_val; // Or a specific error code if preferred
+        }
+
+
+        if (value >= min_val && value <= max_val) {
+            return value;
+        } else {
+            std::cout << "Input out of range. Please enter a value between "
+                      << min_val << " and " << max_val << "." << std::endl;
+            // Prepare for retry - get_int might have set current_prompt to "Retry: "
+            // We want our specific range prompt again.
+            if (prompt) {
+                full_prompt = std::string(prompt) + range_prompt_suffix;
+            } else {
+                 full_prompt = "Retry: Enter an integer" + range_prompt_suffix;
+            }
+
+        }
+    }
+}
+
+std::string get_string_non_empty(const char *prompt) {
+    const char *current_prompt = prompt;
+    while (true) {
+        std::string line = get_string(current_prompt);
+
+        if (line.empty() && (std::cin.eof() || std::cin.fail())) {
+            std::cerr << "\nInput error or EOF encountered. Cannot get non-empty string." << std::endl;
+            return ""; // Return empty on error/EOF
+        }
+
+        if (!line.empty()) {
+            return line;
+        }
+
+        if (current_prompt == nullptr) {
+            current_prompt = "Retry: ";
+        }
+        std::cout << "Input cannot be empty. Please enter some text." << std::endl;
+    }
+}
+
+// --- Integer Array Functions ---
+// ... (array_max, min, sum, hash table helpers, pair funcs, sort, print, contains, index_of, average, count, copy, reverse, shuffle, unique, concat remain the same) ...
+bool array_max(const int *arr, size_t size, int *max_val) {
+    if (arr == nullptr || max_val == nullptr || size == 0) {
+        set_last_error((arr == nullptr || max_val == nullptr) ? ErrorCode::NullArgument : ErrorCode::InvalidArgument);
+        return false;
+    }
+
+    *max_val = arr[0];
+    for (size_t i = 1; i < size; ++i) {
+        if (arr[i] > *max_val) {
+            *max_val = arr[i];
+        }
+    }
+    return true;
+}
+
+bool array_min(const int *arr, size_t size, int *min_val) {
+    if (arr == nullptr || min_val == nullptr || size == 0) {
+        set_last_error((arr == nullptr || min_val == nullptr) ? ErrorCode::NullArgument : ErrorCode::InvalidArgument);
+        return false;
+    }
+
+    *min_val = arr[0];
+    for (size_t i = 1; i < size; ++i) {
+        if (arr[i] < *min_val) {
+            *min_val = arr[i];
+        }
+    }
+    return true;
+}
+
+bool array_sum(const int *arr, size_t size, long long *sum) {
     if (sum == nullptr) {
+        set_last_error(ErrorCode::NullArgument);
         return false;
     }
     *sum = 0; // Initialize sum
@@ -413,6 +1107,7 @@ bool array_sum(const int *arr, size_t size, long long *sum) {
     }
      if (arr == nullptr) {
         // Sum of null array (with non-zero size implied) is undefined/error
+        set_last_error(ErrorCode::NullArgument);
         return false;
     }
 
@@ -422,7 +1117,7 @@ bool array_sum(const int *arr, size_t size, long long *sum) {
         // Check for potential overflow before adding
         if ((arr[i] > 0 && current_sum > std::numeric_limits<long long>::max() - arr[i]) ||
             (arr[i] < 0 && current_sum < std::numeric_limits<long long>::min() - arr[i])) {
-            std::cerr << "Warning: Potential integer overflow detected during array_sum." << std::endl;
+            report_diagnostic(ErrorCode::Overflow, DiagnosticLevel::Warning, "array_sum", "the sum overflows long long at index %zu.", i);
             // *sum = current_sum; // Return sum up to the point of overflow? Or just fail? Failing seems safer.
             return false; // Indicate overflow failure
         }
@@ -456,14 +1151,12 @@ static HashTable* ht_create(size_t initial_size) {
 
     HashTable *ht = static_cast<HashTable*>(std::malloc(sizeof(HashTable)));
     if (!ht) {
-        perror("Failed to allocate memory for HashTable");
         return nullptr;
     }
 
     // Use calloc to zero-initialize buckets (all pointers will be NULL)
     ht->buckets = static_cast<HashNode**>(std::calloc(initial_size, sizeof(HashNode*)));
     if (!ht->buckets) {
-        perror("Failed to allocate memory for HashTable buckets");
         std::free(ht);
         return nullptr;
     }
@@ -513,7 +1206,6 @@ static bool ht_insert(HashTable *ht, int key) {
     size_t index = hash_func(key, ht->table_size);
     HashNode *new_node = static_cast<HashNode*>(std::malloc(sizeof(HashNode)));
     if (!new_node) {
-        perror("Failed to allocate memory for HashNode");
         return false; // Insertion failed
     }
 
@@ -528,6 +1220,7 @@ static bool ht_insert(HashTable *ht, int key) {
 
 bool array_has_pair_sum(const int *arr, size_t size, int target) {
     if (arr == nullptr || size < 2) {
+        if (arr == nullptr && size > 0) set_last_error(ErrorCode::NullArgument);
         return false;
     }
 
@@ -535,7 +1228,7 @@ bool array_has_pair_sum(const int *arr, size_t size, int target) {
     size_t ht_size = (size > 0) ? size : 16; // Estimate hash table size
     HashTable *ht = ht_create(ht_size);
     if (!ht) {
-        std::cerr << "Error: Failed to create hash table in array_has_pair_sum." << std::endl;
+        report_diagnostic(ErrorCode::AllocationFailed, DiagnosticLevel::Error, "array_has_pair_sum", "failed to create the hash table.");
         return false; // Indicate error
     }
 
@@ -549,7 +1242,7 @@ bool array_has_pair_sum(const int *arr, size_t size, int target) {
             // If complement is out of range, it can't be in the int array
             // Still need to insert the current element for future checks
             if (!ht_insert(ht, arr[i])) {
-                 std::cerr << "Error: Failed to insert into hash table in array_has_pair_sum." << std::endl;
+                 report_diagnostic(ErrorCode::AllocationFailed, DiagnosticLevel::Error, "array_has_pair_sum", "failed to insert into the hash table.");
                  // Clean up and indicate failure
                  found = false; // Ensure found is false
                  break; // Exit loop on hash table error
@@ -581,7 +1274,7 @@ bool array_has_pair_sum(const int *arr, size_t size, int target) {
 
         // Insert the current element into the hash table for subsequent checks
         if (!ht_insert(ht, arr[i])) {
-            std::cerr << "Error: Failed to insert into hash table in array_has_pair_sum." << std::endl;
+            report_diagnostic(ErrorCode::AllocationFailed, DiagnosticLevel::Error, "array_has_pair_sum", "failed to insert into the hash table.");
             found = false; // Ensure found is false
             break; // Exit loop on hash table error
         }
@@ -593,13 +1286,14 @@ bool array_has_pair_sum(const int *arr, size_t size, int target) {
 
 bool array_has_pair_product(const int *arr, size_t size, int target) {
      if (arr == nullptr || size < 2) {
+        if (arr == nullptr && size > 0) set_last_error(ErrorCode::NullArgument);
         return false;
     }
 
     size_t ht_size = (size > 0) ? size : 16;
     HashTable *ht = ht_create(ht_size);
     if (!ht) {
-        std::cerr << "Error: Failed to create hash table in array_has_pair_product." << std::endl;
+        report_diagnostic(ErrorCode::AllocationFailed, DiagnosticLevel::Error, "array_has_pair_product", "failed to create the hash table.");
         return false;
     }
 
@@ -613,7 +1307,7 @@ bool array_has_pair_product(const int *arr, size_t size, int target) {
         } else {
             // Insert non-zero elements into hash table
             if (!ht_insert(ht, arr[i])) {
-                std::cerr << "Error: Failed to insert into hash table in array_has_pair_product (pass 1)." << std::endl;
+                report_diagnostic(ErrorCode::AllocationFailed, DiagnosticLevel::Error, "array_has_pair_product", "failed to insert into the hash table.");
                 ht_destroy(ht);
                 return false;
             }
@@ -678,6 +1372,7 @@ bool array_has_pair_product(const int *arr, size_t size, int target) {
 
 bool array_has_pair_difference(const int *arr, size_t size, int target) {
      if (arr == nullptr || size < 2) {
+        if (arr == nullptr && size > 0) set_last_error(ErrorCode::NullArgument);
         return false;
     }
     // Allow target == 0 (means finding duplicate elements)
@@ -685,7 +1380,7 @@ bool array_has_pair_difference(const int *arr, size_t size, int target) {
     size_t ht_size = (size > 0) ? size : 16;
     HashTable *ht = ht_create(ht_size);
     if (!ht) {
-        std::cerr << "Error: Failed to create hash table in array_has_pair_difference." << std::endl;
+        report_diagnostic(ErrorCode::AllocationFailed, DiagnosticLevel::Error, "array_has_pair_difference", "failed to create the hash table.");
         return false;
     }
 
@@ -724,7 +1419,7 @@ bool array_has_pair_difference(const int *arr, size_t size, int target) {
 
         // Insert current value into the hash table for future checks
         if (!ht_insert(ht, current_val)) {
-            std::cerr << "Error: Failed to insert into hash table in array_has_pair_difference." << std::endl;
+            report_diagnostic(ErrorCode::AllocationFailed, DiagnosticLevel::Error, "array_has_pair_difference", "failed to insert into the hash table.");
             found = false; // Ensure found is false
             break; // Exit loop on hash table error
         }
@@ -736,6 +1431,7 @@ bool array_has_pair_difference(const int *arr, size_t size, int target) {
 
 void sort_array(int arr[], size_t size) {
     if (arr == nullptr || size < 2) {
+        if (arr == nullptr && size > 0) set_last_error(ErrorCode::NullArgument);
         return; // Nothing to sort
     }
     // Use std::sort (more robust than the original counting sort)
@@ -759,6 +1455,7 @@ void print_array(const int arr[], size_t size) {
 
 bool array_contains_int(const int *arr, size_t size, int value) {
     if (arr == nullptr || size == 0) {
+        if (arr == nullptr && size > 0) set_last_error(ErrorCode::NullArgument);
         return false;
     }
     for (size_t i = 0; i < size; ++i) {
@@ -771,13 +1468,14 @@ bool array_contains_int(const int *arr, size_t size, int value) {
 
 int array_index_of_int(const int *arr, size_t size, int value) {
      if (arr == nullptr || size == 0) {
+        if (arr == nullptr && size > 0) set_last_error(ErrorCode::NullArgument);
         return -1;
     }
     for (size_t i = 0; i < size; ++i) {
         if (arr[i] == value) {
             // Check for potential overflow if size_t > max int, though unlikely
             if (i > static_cast<size_t>(std::numeric_limits<int>::max())) {
-                 std::cerr << "Warning: Index found (" << i << ") exceeds maximum representable int value. Returning -1." << std::endl;
+                 report_diagnostic(ErrorCode::Overflow, DiagnosticLevel::Warning, "array_index_of_int", "index %zu does not fit in int; returning -1.", i);
                  return -1;
             }
             return static_cast<int>(i);
@@ -788,6 +1486,7 @@ int array_index_of_int(const int *arr, size_t size, int value) {
 
 bool array_average(const int *arr, size_t size, double *average) {
     if (arr == nullptr || average == nullptr || size == 0) {
+        set_last_error((arr == nullptr || average == nullptr) ? ErrorCode::NullArgument : ErrorCode::InvalidArgument);
         if(average) *average = 0.0; // Define average of empty/null array as 0?
         return false; // Indicate invalid input or empty array
     }
@@ -805,6 +1504,7 @@ bool array_average(const int *arr, size_t size, double *average) {
 
 size_t array_count_occurrence(const int *arr, size_t size, int value) {
     if (arr == nullptr || size == 0) {
+        if (arr == nullptr && size > 0) set_last_error(ErrorCode::NullArgument);
         return 0;
     }
     size_t count = 0;
@@ -818,6 +1518,7 @@ size_t array_count_occurrence(const int *arr, size_t size, int value) {
 
 int* array_copy_int(const int *arr, size_t size) {
     if (arr == nullptr) {
+        set_last_error(ErrorCode::NullArgument);
         return nullptr;
     }
     if (size == 0) {
@@ -828,7 +1529,7 @@ int* array_copy_int(const int *arr, size_t size) {
 
     int* new_arr = new (std::nothrow) int[size];
     if (new_arr == nullptr) {
-        perror("Failed to allocate memory for array copy");
+        report_diagnostic(ErrorCode::AllocationFailed, DiagnosticLevel::Error, "array_copy_int", "failed to allocate %zu ints.", size);
         return nullptr;
     }
     std::memcpy(new_arr, arr, size * sizeof(int));
@@ -838,6 +1539,7 @@ int* array_copy_int(const int *arr, size_t size) {
 
 void array_reverse_int(int *arr, size_t size) {
     if (arr == nullptr || size < 2) {
+        if (arr == nullptr && size > 0) set_last_error(ErrorCode::NullArgument);
         return; // Nothing to reverse
     }
     std::reverse(arr, arr + size);
@@ -845,22 +1547,33 @@ void array_reverse_int(int *arr, size_t size) {
 
 void array_shuffle_int(int *arr, size_t size) {
      if (arr == nullptr || size < 2) {
+        if (arr == nullptr && size > 0) set_last_error(ErrorCode::NullArgument);
         return; // Nothing to shuffle
     }
     if (!random_initialized) {
         initialize_random(); // Ensure seeded if not already done
     }
+    if (size >= PARALLEL_SHUFFLE_MIN_SIZE) {
+        parallel_shuffle(arr, size, global_random_engine(), 0); // Seed drawn from the global engine
+        return;
+    }
     std::shuffle(arr, arr + size, global_random_engine);
 }
 
+void array_parallel_shuffle_int(int *arr, size_t size, unsigned long long seed, unsigned int num_threads) {
+    if (arr == nullptr && size > 0) set_last_error(ErrorCode::NullArgument);
+    parallel_shuffle(arr, size, seed, num_threads);
+}
+
 int* array_unique_int(const int *arr, size_t size, size_t *unique_size) {
      if (unique_size == nullptr) {
-        std::cerr << "Error: unique_size pointer cannot be null." << std::endl;
+        report_diagnostic(ErrorCode::NullArgument, DiagnosticLevel::Error, "array_unique_int", "unique_size pointer cannot be null.");
         return nullptr;
      }
      *unique_size = 0; // Initialize output size
 
      if (arr == nullptr) {
+         set_last_error(ErrorCode::NullArgument);
          return nullptr; // Cannot process null array
      }
      if (size == 0) {
@@ -873,7 +1586,7 @@ int* array_unique_int(const int *arr, size_t size, size_t *unique_size) {
     *unique_size = unique_set.size();
     int* result = new (std::nothrow) int[*unique_size];
     if (!result) {
-        perror("Failed to allocate memory for unique array");
+        report_diagnostic(ErrorCode::AllocationFailed, DiagnosticLevel::Error, "array_unique_int", "failed to allocate %zu ints.", *unique_size);
         *unique_size = 0;
         return nullptr;
     }
@@ -885,14 +1598,18 @@ int* array_unique_int(const int *arr, size_t size, size_t *unique_size) {
 
 int* array_concat_int(const int *arr1, size_t size1, const int *arr2, size_t size2, size_t *new_size) {
      if (new_size == nullptr) {
-          std::cerr << "Error: new_size pointer cannot be null." << std::endl;
+          report_diagnostic(ErrorCode::NullArgument, DiagnosticLevel::Error, "array_concat_int", "new_size pointer cannot be null.");
          return nullptr;
      }
      *new_size = 0;
 
      // Check for potential overflow when calculating total size
      if (size1 > std::numeric_limits<size_t>::max() - size2) {
-         std::cerr << "Error: Combined size exceeds maximum possible size_t value." << std::endl;
+         report_diagnostic(ErrorCode::Overflow, DiagnosticLevel::Error, "array_concat_int", "combined size exceeds the maximum size_t value.");
+         return nullptr;
+     }
+     if ((arr1 == nullptr && size1 > 0) || (arr2 == nullptr && size2 > 0)) {
+         set_last_error(ErrorCode::NullArgument);
          return nullptr;
      }
      size_t total_size = size1 + size2;
@@ -905,7 +1622,7 @@ int* array_concat_int(const int *arr1, size_t size1, const int *arr2, size_t siz
 
      int* result = new (std::nothrow) int[total_size];
      if (!result) {
-         perror("Failed to allocate memory for concatenated array");
+         report_diagnostic(ErrorCode::AllocationFailed, DiagnosticLevel::Error, "array_concat_int", "failed to allocate %zu ints.", total_size);
          *new_size = 0;
          return nullptr;
      }
@@ -930,6 +1647,7 @@ int* array_concat_int(const int *arr1, size_t size1, const int *arr2, size_t siz
 // ... (max, min, sum, average, sort, contains, index_of, count, copy, print, reverse, shuffle, concat for float remain the same, they use the inline func from header) ...
 bool array_max_float(const std::vector<float>& vec, float* max_val) {
     if (vec.empty() || max_val == nullptr) {
+        set_last_error((max_val == nullptr) ? ErrorCode::NullArgument : ErrorCode::InvalidArgument);
         return false;
     }
     *max_val = *std::max_element(vec.begin(), vec.end());
@@ -938,6 +1656,7 @@ bool array_max_float(const std::vector<float>& vec, float* max_val) {
 
 bool array_min_float(const std::vector<float>& vec, float* min_val) {
      if (vec.empty() || min_val == nullptr) {
+        set_last_error((min_val == nullptr) ? ErrorCode::NullArgument : ErrorCode::InvalidArgument);
         return false;
     }
     *min_val = *std::min_element(vec.begin(), vec.end());
@@ -946,6 +1665,7 @@ bool array_min_float(const std::vector<float>& vec, float* min_val) {
 
 bool array_sum_float(const std::vector<float>& vec, double* sum) {
     if (sum == nullptr) {
+        set_last_error(ErrorCode::NullArgument);
         return false;
     }
     // Use double for accumulation to minimize precision errors
@@ -955,6 +1675,7 @@ bool array_sum_float(const std::vector<float>& vec, double* sum) {
 
 bool array_average_float(const std::vector<float>& vec, double* average) {
     if (vec.empty() || average == nullptr) {
+        set_last_error((average == nullptr) ? ErrorCode::NullArgument : ErrorCode::InvalidArgument);
         if (average) *average = 0.0;
         return false;
     }
@@ -985,7 +1706,7 @@ long long array_index_of_float(const std::vector<float>& vec, float value, float
         if (floats_are_close(vec[i], value, epsilon)) { // Uses inline from header
              // Check potential overflow before casting size_t to long long (extremely unlikely)
             if (i > static_cast<size_t>(std::numeric_limits<long long>::max())) {
-                 std::cerr << "Warning: Index found (" << i << ") exceeds maximum representable long long value. Returning -1." << std::endl;
+                 report_diagnostic(ErrorCode::Overflow, DiagnosticLevel::Warning, "array_index_of_float", "index %zu does not fit in long long; returning -1.", i);
                  return -1LL;
             }
             return static_cast<long long>(i);
@@ -1026,9 +1747,17 @@ void array_reverse_float(std::vector<float>& vec) {
 void array_shuffle_float(std::vector<float>& vec) {
      if (vec.size() < 2) return;
      if (!random_initialized) initialize_random();
+     if (vec.size() >= PARALLEL_SHUFFLE_MIN_SIZE) {
+         parallel_shuffle(vec.data(), vec.size(), global_random_engine(), 0);
+         return;
+     }
      std::shuffle(vec.begin(), vec.end(), global_random_engine);
 }
 
+void array_parallel_shuffle_float(std::vector<float>& vec, unsigned long long seed, unsigned int num_threads) {
+    parallel_shuffle(vec.data(), vec.size(), seed, num_threads);
+}
+
 std::vector<float> array_concat_float(const std::vector<float>& vec1, const std::vector<float>& vec2) {
     std::vector<float> result = vec1; // Start with a copy of vec1
     result.insert(result.end(), vec2.begin(), vec2.end()); // Append vec2
@@ -1043,6 +1772,7 @@ std::vector<float> array_concat_float(const std::vector<float>& vec1, const std:
 // ... (max, min, sum, average, sort, contains, index_of, count, copy, print, reverse, shuffle, concat for double remain the same) ...
 bool array_max_double(const std::vector<double>& vec, double* max_val) {
     if (vec.empty() || max_val == nullptr) {
+        set_last_error((max_val == nullptr) ? ErrorCode::NullArgument : ErrorCode::InvalidArgument);
         return false;
     }
     *max_val = *std::max_element(vec.begin(), vec.end());
@@ -1051,6 +1781,7 @@ bool array_max_double(const std::vector<double>& vec, double* max_val) {
 
 bool array_min_double(const std::vector<double>& vec, double* min_val) {
      if (vec.empty() || min_val == nullptr) {
+        set_last_error((min_val == nullptr) ? ErrorCode::NullArgument : ErrorCode::InvalidArgument);
         return false;
     }
     *min_val = *std::min_element(vec.begin(), vec.end());
@@ -1059,6 +1790,7 @@ bool array_min_double(const std::vector<double>& vec, double* min_val) {
 
 bool array_sum_double(const std::vector<double>& vec, double* sum) {
     if (sum == nullptr) {
+        set_last_error(ErrorCode::NullArgument);
         return false;
     }
     *sum = std::accumulate(vec.begin(), vec.end(), 0.0);
@@ -1067,6 +1799,7 @@ bool array_sum_double(const std::vector<double>& vec, double* sum) {
 
 bool array_average_double(const std::vector<double>& vec, double* average) {
     if (vec.empty() || average == nullptr) {
+        set_last_error((average == nullptr) ? ErrorCode::NullArgument : ErrorCode::InvalidArgument);
         if (average) *average = 0.0;
         return false;
     }
@@ -1096,7 +1829,7 @@ long long array_index_of_double(const std::vector<double>& vec, double value, do
     for (size_t i = 0; i < vec.size(); ++i) {
         if (doubles_are_close(vec[i], value, epsilon)) { // Uses inline from header
              if (i > static_cast<size_t>(std::numeric_limits<long long>::max())) {
-                 std::cerr << "Warning: Index found (" << i << ") exceeds maximum representable long long value. Returning -1." << std::endl;
+                 report_diagnostic(ErrorCode::Overflow, DiagnosticLevel::Warning, "array_index_of_double", "index %zu does not fit in long long; returning -1.", i);
                  return -1LL;
             }
             return static_cast<long long>(i);
@@ -1137,9 +1870,17 @@ void array_reverse_double(std::vector<double>& vec) {
 void array_shuffle_double(std::vector<double>& vec) {
     if (vec.size() < 2) return;
     if (!random_initialized) initialize_random();
+    if (vec.size() >= PARALLEL_SHUFFLE_MIN_SIZE) {
+        parallel_shuffle(vec.data(), vec.size(), global_random_engine(), 0);
+        return;
+    }
     std::shuffle(vec.begin(), vec.end(), global_random_engine);
 }
 
+void array_parallel_shuffle_double(std::vector<double>& vec, unsigned long long seed, unsigned int num_threads) {
+    parallel_shuffle(vec.data(), vec.size(), seed, num_threads);
+}
+
 std::vector<double> array_concat_double(const std::vector<double>& vec1, const std::vector<double>& vec2) {
     std::vector<double> result = vec1;
     result.insert(result.end(), vec2.begin(), vec2.end());
@@ -1152,6 +1893,7 @@ std::vector<double> array_concat_double(const std::vector<double>& vec1, const s
 // Existing C-style find_string
 int find_string(char * const arr_of_strings[], size_t size, const char *target_string) {
     if (arr_of_strings == nullptr || target_string == nullptr) {
+        set_last_error(ErrorCode::NullArgument);
         return -1;
     }
 
@@ -1159,7 +1901,7 @@ int find_string(char * const arr_of_strings[], size_t size, const char *target_s
         // Ensure the pointer in the array is not null before comparing
         if (arr_of_strings[i] != nullptr && std::strcmp(arr_of_strings[i], target_string) == 0) {
              if (i > static_cast<size_t>(std::numeric_limits<int>::max())) {
-                 std::cerr << "Warning: Index found (" << i << ") exceeds maximum representable int value. Returning -1." << std::endl;
+                 report_diagnostic(ErrorCode::Overflow, DiagnosticLevel::Warning, "find_string", "index %zu does not fit in int; returning -1.", i);
                  return -1;
             }
             return static_cast<int>(i);
@@ -1171,6 +1913,7 @@ int find_string(char * const arr_of_strings[], size_t size, const char *target_s
 // New std::vector<std::string> functions
 bool array_max_string(const std::vector<std::string>& vec, std::string* max_val) {
     if (vec.empty() || max_val == nullptr) {
+        set_last_error((max_val == nullptr) ? ErrorCode::NullArgument : ErrorCode::InvalidArgument);
         return false;
     }
     // std::max_element uses operator<, which is lexicographical for std::string
@@ -1180,377 +1923,3580 @@ bool array_max_string(const std::vector<std::string>& vec, std::string* max_val)
 
 bool array_min_string(const std::vector<std::string>& vec, std::string* min_val) {
     if (vec.empty() || min_val == nullptr) {
+        set_last_error((min_val == nullptr) ? ErrorCode::NullArgument : ErrorCode::InvalidArgument);
+        return false;
+    }
+    *min_val = *std::min_element(vec.begin(), vec.end());
+    return true;
+}
+
+void array_sort_string(std::vector<std::string>& vec) {
+    std::sort(vec.begin(), vec.end()); // Lexicographical sort
+}
+
+bool array_contains_string(const std::vector<std::string>& vec, const std::string& value) {
+    // std::find uses operator== for std::string
+    return std::find(vec.begin(), vec.end(), value) != vec.end();
+}
+
+long long array_index_of_string(const std::vector<std::string>& vec, const std::string& value) {
+    auto it = std::find(vec.begin(), vec.end(), value);
+    if (it != vec.end()) {
+        size_t index = std::distance(vec.begin(), it);
+        if (index > static_cast<size_t>(std::numeric_limits<long long>::max())) {
+            report_diagnostic(ErrorCode::Overflow, DiagnosticLevel::Warning, "array_index_of_string", "index %zu does not fit in long long; returning -1.", index);
+            return -1LL;
+        }
+        return static_cast<long long>(index);
+    }
+    return -1LL; // Not found
+}
+
+size_t array_count_occurrence_string(const std::vector<std::string>& vec, const std::string& value) {
+    // std::count uses operator==
+    return std::count(vec.begin(), vec.end(), value);
+}
+
+std::vector<std::string> array_copy_string(const std::vector<std::string>& vec) {
+    return vec; // Vector copy constructor performs deep copy of strings
+}
+
+void array_print_string(const std::vector<std::string>& vec) {
+    std::cout << "[";
+    for (size_t i = 0; i < vec.size(); ++i) {
+        // Consider quoting strings if they might contain commas or brackets?
+        std::cout << "\"" << vec[i] << "\""; // Basic quoting
+        if (i < vec.size() - 1) {
+            std::cout << ", ";
+        }
+    }
+    std::cout << "]" << std::endl;
+}
+
+void array_reverse_string(std::vector<std::string>& vec) {
+    std::reverse(vec.begin(), vec.end());
+}
+
+void array_shuffle_string(std::vector<std::string>& vec) {
+    if (vec.size() < 2) return;
+    if (!random_initialized) initialize_random();
+    if (vec.size() >= PARALLEL_SHUFFLE_MIN_SIZE) {
+        parallel_shuffle(vec.data(), vec.size(), global_random_engine(), 0);
+        return;
+    }
+    std::shuffle(vec.begin(), vec.end(), global_random_engine);
+}
+
+void array_parallel_shuffle_string(std::vector<std::string>& vec, unsigned long long seed, unsigned int num_threads) {
+    parallel_shuffle(vec.data(), vec.size(), seed, num_threads);
+}
+
+std::vector<std::string> array_concat_string(const std::vector<std::string>& vec1, const std::vector<std::string>& vec2) {
+    std::vector<std::string> result = vec1;
+    result.insert(result.end(), vec2.begin(), vec2.end());
+    return result;
+}
+
+// --- SIMD Byte Scanning (Internal) ---
+// Kernels return the offset of the first match in [p, p + n) or npos. Set kernels use
+// the nibble lookup built by ByteSet: byte b matches when lo[b & 15] & hi[b >> 4] != 0.
+
+const size_t SCAN_NPOS = std::string_view::npos;
+
+static inline unsigned lowest_set_bit(unsigned mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+
+static size_t scalar_find_byte(const char *p, size_t n, char c) {
+    const void *hit = std::memchr(p, c, n);
+    return hit ? static_cast<size_t>(static_cast<const char*>(hit) - p) : SCAN_NPOS;
+}
+
+static size_t scalar_find_in_set(const unsigned char *lo, const unsigned char *hi, const char *p, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        unsigned char b = static_cast<unsigned char>(p[i]);
+        if (lo[b & 15] & hi[b >> 4]) {
+            return i;
+        }
+    }
+    return SCAN_NPOS;
+}
+
+#if defined(ATOMIX_X86_64)
+static size_t sse2_find_byte(const char *p, size_t n, char c) {
+    if (n < 16) {
+        return scalar_find_byte(p, n, c);
+    }
+    const __m128i needle = _mm_set1_epi8(c);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, needle)));
+        if (mask) {
+            return i + lowest_set_bit(mask);
+        }
+    }
+    if (i < n) {
+        // Overlapping final load; drop the bytes already checked
+        size_t base = n - 16;
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + base));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, needle)));
+        mask &= ~0u << (i - base);
+        if (mask) {
+            return base + lowest_set_bit(mask);
+        }
+    }
+    return SCAN_NPOS;
+}
+#endif
+
+#if defined(ATOMIX_SIMD_DISPATCH)
+ATOMIX_TARGET_AVX2 static size_t avx2_find_byte(const char *p, size_t n, char c) {
+    if (n < 32) {
+        return sse2_find_byte(p, n, c);
+    }
+    const __m256i needle = _mm256_set1_epi8(c);
+    // Delimiters are usually close: test one vector before entering the unrolled loop
+    unsigned first = static_cast<unsigned>(_mm256_movemask_epi8(
+        _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)), needle)));
+    if (first) {
+        return lowest_set_bit(first);
+    }
+    size_t i = 32;
+    // 64 bytes per iteration: one branch for two vectors
+    for (; i + 64 <= n; i += 64) {
+        __m256i a = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i)), needle);
+        __m256i b = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i + 32)), needle);
+        if (!_mm256_testz_si256(_mm256_or_si256(a, b), _mm256_or_si256(a, b))) {
+            unsigned mask_a = static_cast<unsigned>(_mm256_movemask_epi8(a));
+            if (mask_a) {
+                return i + lowest_set_bit(mask_a);
+            }
+            return i + 32 + lowest_set_bit(static_cast<unsigned>(_mm256_movemask_epi8(b)));
+        }
+    }
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, needle)));
+        if (mask) {
+            return i + lowest_set_bit(mask);
+        }
+    }
+    if (i < n) {
+        size_t base = n - 32;
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + base));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, needle)));
+        mask &= ~0u << (i - base);
+        if (mask) {
+            return base + lowest_set_bit(mask);
+        }
+    }
+    return SCAN_NPOS;
+}
+
+ATOMIX_TARGET_SSSE3 static inline unsigned ssse3_set_mask(__m128i lo_table, __m128i hi_table, const char *p) {
+    const __m128i low_mask = _mm_set1_epi8(0x0F);
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i lo_hit = _mm_shuffle_epi8(lo_table, _mm_and_si128(v, low_mask));
+    __m128i hi_hit = _mm_shuffle_epi8(hi_table, _mm_and_si128(_mm_srli_epi16(v, 4), low_mask));
+    __m128i none = _mm_cmpeq_epi8(_mm_and_si128(lo_hit, hi_hit), _mm_setzero_si128());
+    return static_cast<unsigned>(_mm_movemask_epi8(none)) ^ 0xFFFFu;
+}
+
+ATOMIX_TARGET_SSSE3 static size_t ssse3_find_in_set(const unsigned char *lo, const unsigned char *hi, const char *p, size_t n) {
+    if (n < 16) {
+        return scalar_find_in_set(lo, hi, p, n);
+    }
+    const __m128i lo_table = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lo));
+    const __m128i hi_table = _mm_loadu_si128(reinterpret_cast<const __m128i*>(hi));
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        unsigned mask = ssse3_set_mask(lo_table, hi_table, p + i);
+        if (mask) {
+            return i + lowest_set_bit(mask);
+        }
+    }
+    if (i < n) {
+        size_t base = n - 16;
+        unsigned mask = ssse3_set_mask(lo_table, hi_table, p + base) & (~0u << (i - base));
+        if (mask) {
+            return base + lowest_set_bit(mask);
+        }
+    }
+    return SCAN_NPOS;
+}
+
+ATOMIX_TARGET_AVX2 static inline unsigned avx2_set_mask(__m256i lo_table, __m256i hi_table, const char *p) {
+    const __m256i low_mask = _mm256_set1_epi8(0x0F);
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    __m256i lo_hit = _mm256_shuffle_epi8(lo_table, _mm256_and_si256(v, low_mask));
+    __m256i hi_hit = _mm256_shuffle_epi8(hi_table, _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask));
+    __m256i none = _mm256_cmpeq_epi8(_mm256_and_si256(lo_hit, hi_hit), _mm256_setzero_si256());
+    return ~static_cast<unsigned>(_mm256_movemask_epi8(none));
+}
+
+ATOMIX_TARGET_AVX2 static size_t avx2_find_in_set(const unsigned char *lo, const unsigned char *hi, const char *p, size_t n) {
+    if (n < 32) {
+        return ssse3_find_in_set(lo, hi, p, n);
+    }
+    // vpshufb looks up within each 128-bit lane, so both lanes get a copy of the table
+    const __m256i lo_table = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(lo)));
+    const __m256i hi_table = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(hi)));
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        unsigned mask = avx2_set_mask(lo_table, hi_table, p + i);
+        if (mask) {
+            return i + lowest_set_bit(mask);
+        }
+    }
+    if (i < n) {
+        size_t base = n - 32;
+        unsigned mask = avx2_set_mask(lo_table, hi_table, p + base) & (~0u << (i - base));
+        if (mask) {
+            return base + lowest_set_bit(mask);
+        }
+    }
+    return SCAN_NPOS;
+}
+#endif
+
+typedef size_t (*FindByteKernel)(const char*, size_t, char);
+typedef size_t (*FindInSetKernel)(const unsigned char*, const unsigned char*, const char*, size_t);
+
+static FindByteKernel select_find_byte_kernel() {
+#if defined(ATOMIX_SIMD_DISPATCH)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return avx2_find_byte;
+#endif
+#if defined(ATOMIX_X86_64)
+    return sse2_find_byte;
+#else
+    return scalar_find_byte;
+#endif
+}
+
+static FindInSetKernel select_find_in_set_kernel() {
+#if defined(ATOMIX_SIMD_DISPATCH)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return avx2_find_in_set;
+    if (__builtin_cpu_supports("ssse3")) return ssse3_find_in_set;
+#endif
+    return scalar_find_in_set;
+}
+
+// Each pointer starts at a resolver that picks the kernel on first call and patches
+// itself in, so later calls are a single indirect jump with no init guard.
+static size_t resolve_find_byte(const char *p, size_t n, char c);
+static size_t resolve_find_in_set(const unsigned char *lo, const unsigned char *hi, const char *p, size_t n);
+static std::atomic<FindByteKernel> find_byte_kernel(resolve_find_byte);
+static std::atomic<FindInSetKernel> find_in_set_kernel(resolve_find_in_set);
+
+static size_t resolve_find_byte(const char *p, size_t n, char c) {
+    FindByteKernel kernel = select_find_byte_kernel();
+    find_byte_kernel.store(kernel, std::memory_order_relaxed);
+    return kernel(p, n, c);
+}
+
+static size_t resolve_find_in_set(const unsigned char *lo, const unsigned char *hi, const char *p, size_t n) {
+    FindInSetKernel kernel = select_find_in_set_kernel();
+    find_in_set_kernel.store(kernel, std::memory_order_relaxed);
+    return kernel(lo, hi, p, n);
+}
+
+static inline size_t simd_find_byte(const char *p, size_t n, char c) {
+    return find_byte_kernel.load(std::memory_order_relaxed)(p, n, c);
+}
+
+static inline size_t simd_find_in_set(const unsigned char *lo, const unsigned char *hi, const char *p, size_t n) {
+    return find_in_set_kernel.load(std::memory_order_relaxed)(lo, hi, p, n);
+}
+
+// --- SIMD Case Folding (Internal) ---
+// ASCII only: bytes >= 0x80 pass through untouched, so UTF-8 input stays valid.
+
+static inline char ascii_lower(char c) { return (static_cast<unsigned char>(c - 'A') < 26) ? static_cast<char>(c | 0x20) : c; }
+static inline char ascii_upper(char c) { return (static_cast<unsigned char>(c - 'a') < 26) ? static_cast<char>(c & ~0x20) : c; }
+
+static void scalar_case_convert(const char *src, char *dst, size_t n, bool to_upper) {
+    for (size_t i = 0; i < n; ++i) {
+        dst[i] = to_upper ? ascii_upper(src[i]) : ascii_lower(src[i]);
+    }
+}
+
+static bool scalar_case_equal(const char *a, const char *b, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        if (ascii_lower(a[i]) != ascii_lower(b[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+#if defined(ATOMIX_X86_64)
+// Flips bit 5 of every byte in [first, first + 25]: (v - first) <= 25 unsigned
+static inline __m128i sse2_flip_case(__m128i v, __m128i first, __m128i span, __m128i bit) {
+    __m128i offset = _mm_sub_epi8(v, first);
+    __m128i in_range = _mm_cmpeq_epi8(_mm_min_epu8(offset, span), offset);
+    return _mm_xor_si128(v, _mm_and_si128(in_range, bit));
+}
+
+static void sse2_case_convert(const char *src, char *dst, size_t n, bool to_upper) {
+    const __m128i first = _mm_set1_epi8(to_upper ? 'a' : 'A');
+    const __m128i span = _mm_set1_epi8(25);
+    const __m128i bit = _mm_set1_epi8(0x20);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), sse2_flip_case(v, first, span, bit));
+    }
+    scalar_case_convert(src + i, dst + i, n - i, to_upper);
+}
+
+static bool sse2_case_equal(const char *a, const char *b, size_t n) {
+    const __m128i first = _mm_set1_epi8('A');
+    const __m128i span = _mm_set1_epi8(25);
+    const __m128i bit = _mm_set1_epi8(0x20);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i va = sse2_flip_case(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i)), first, span, bit);
+        __m128i vb = sse2_flip_case(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i)), first, span, bit);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)) != 0xFFFF) {
+            return false;
+        }
+    }
+    return scalar_case_equal(a + i, b + i, n - i);
+}
+#endif
+
+#if defined(ATOMIX_SIMD_DISPATCH)
+ATOMIX_TARGET_AVX2 static inline __m256i avx2_flip_case(__m256i v, __m256i first, __m256i span, __m256i bit) {
+    __m256i offset = _mm256_sub_epi8(v, first);
+    __m256i in_range = _mm256_cmpeq_epi8(_mm256_min_epu8(offset, span), offset);
+    return _mm256_xor_si256(v, _mm256_and_si256(in_range, bit));
+}
+
+ATOMIX_TARGET_AVX2 static void avx2_case_convert(const char *src, char *dst, size_t n, bool to_upper) {
+    const __m256i first = _mm256_set1_epi8(to_upper ? 'a' : 'A');
+    const __m256i span = _mm256_set1_epi8(25);
+    const __m256i bit = _mm256_set1_epi8(0x20);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), avx2_flip_case(v, first, span, bit));
+    }
+    sse2_case_convert(src + i, dst + i, n - i, to_upper);
+}
+
+ATOMIX_TARGET_AVX2 static bool avx2_case_equal(const char *a, const char *b, size_t n) {
+    const __m256i first = _mm256_set1_epi8('A');
+    const __m256i span = _mm256_set1_epi8(25);
+    const __m256i bit = _mm256_set1_epi8(0x20);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i va = avx2_flip_case(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)), first, span, bit);
+        __m256i vb = avx2_flip_case(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)), first, span, bit);
+        if (static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(va, vb))) != 0xFFFFFFFFu) {
+            return false;
+        }
+    }
+    return sse2_case_equal(a + i, b + i, n - i);
+}
+#endif
+
+typedef void (*CaseConvertKernel)(const char*, char*, size_t, bool);
+typedef bool (*CaseEqualKernel)(const char*, const char*, size_t);
+
+static CaseConvertKernel select_case_convert_kernel() {
+#if defined(ATOMIX_SIMD_DISPATCH)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return avx2_case_convert;
+#endif
+#if defined(ATOMIX_X86_64)
+    return sse2_case_convert;
+#else
+    return scalar_case_convert;
+#endif
+}
+
+static CaseEqualKernel select_case_equal_kernel() {
+#if defined(ATOMIX_SIMD_DISPATCH)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return avx2_case_equal;
+#endif
+#if defined(ATOMIX_X86_64)
+    return sse2_case_equal;
+#else
+    return scalar_case_equal;
+#endif
+}
+
+static void resolve_case_convert(const char *src, char *dst, size_t n, bool to_upper);
+static bool resolve_case_equal(const char *a, const char *b, size_t n);
+static std::atomic<CaseConvertKernel> case_convert_kernel(resolve_case_convert);
+static std::atomic<CaseEqualKernel> case_equal_kernel(resolve_case_equal);
+
+static void resolve_case_convert(const char *src, char *dst, size_t n, bool to_upper) {
+    CaseConvertKernel kernel = select_case_convert_kernel();
+    case_convert_kernel.store(kernel, std::memory_order_relaxed);
+    kernel(src, dst, n, to_upper);
+}
+
+static bool resolve_case_equal(const char *a, const char *b, size_t n) {
+    CaseEqualKernel kernel = select_case_equal_kernel();
+    case_equal_kernel.store(kernel, std::memory_order_relaxed);
+    return kernel(a, b, n);
+}
+
+static inline void simd_case_convert(const char *src, char *dst, size_t n, bool to_upper) {
+    case_convert_kernel.load(std::memory_order_relaxed)(src, dst, n, to_upper);
+}
+
+static inline bool simd_case_equal(const char *a, const char *b, size_t n) {
+    return case_equal_kernel.load(std::memory_order_relaxed)(a, b, n);
+}
+
+// UTF-8 mode: case pairs whose two forms encode to two bytes each, so conversion never
+// changes the length. Covers Latin-1, Latin Extended-A, Greek and Cyrillic; anything
+// else (including ß, İ, ſ and final sigma's special rules) is left as is.
+static unsigned int utf8_case_map(unsigned int cp, bool to_upper) {
+    if (cp >= 0xC0 && cp <= 0xFE && cp != 0xD7 && cp != 0xF7 && cp != 0xDF) {   // Latin-1
+        return to_upper ? (cp & ~0x20u) : (cp | 0x20u);
+    }
+    if (cp == 0xFF && to_upper) return 0x178;                                   // ÿ -> Ÿ
+    if (cp == 0x178 && !to_upper) return 0xFF;
+    if ((cp >= 0x100 && cp <= 0x12F) || (cp >= 0x132 && cp <= 0x137) ||
+        (cp >= 0x14A && cp <= 0x177)) {                                         // Latin Ext-A, even = upper
+        return to_upper ? (cp & ~1u) : (cp | 1u);
+    }
+    if ((cp >= 0x139 && cp <= 0x148) || (cp >= 0x179 && cp <= 0x17E)) {        // Latin Ext-A, odd = upper
+        return to_upper ? (cp - ((cp & 1u) ? 0 : 1)) : (cp + ((cp & 1u) ? 1 : 0));
+    }
+    if (cp == 0x386 && !to_upper) return 0x3AC;                                         // Greek tonos
+    if (cp == 0x3AC && to_upper) return 0x386;
+    if (cp >= 0x388 && cp <= 0x38A) return to_upper ? cp : cp + 0x25;
+    if (cp >= 0x3AD && cp <= 0x3AF) return to_upper ? cp - 0x25 : cp;
+    if (cp == 0x38C && !to_upper) return 0x3CC;
+    if (cp == 0x3CC && to_upper) return 0x38C;
+    if ((cp == 0x38E || cp == 0x38F) && !to_upper) return cp + 0x3F;
+    if ((cp == 0x3CD || cp == 0x3CE) && to_upper) return cp - 0x3F;
+    if (cp >= 0x391 && cp <= 0x3A9 && cp != 0x3A2) return to_upper ? cp : cp + 0x20;   // Greek capitals
+    if (cp >= 0x3B1 && cp <= 0x3C9) {                                                   // Greek small
+        if (!to_upper) return cp;
+        return (cp == 0x3C2) ? 0x3A3 : cp - 0x20;                                       // ς -> Σ
+    }
+    if (cp >= 0x400 && cp <= 0x40F) return to_upper ? cp : cp + 0x50;            // Cyrillic Ѐ..Џ
+    if (cp >= 0x410 && cp <= 0x42F) return to_upper ? cp : cp + 0x20;            // Cyrillic А..Я
+    if (cp >= 0x430 && cp <= 0x44F) return to_upper ? cp - 0x20 : cp;            // Cyrillic а..я
+    if (cp >= 0x450 && cp <= 0x45F) return to_upper ? cp - 0x50 : cp;            // Cyrillic ѐ..џ
+    return cp;
+}
+
+// Rewrites the two-byte sequences in buf that have a case pair (ASCII already done)
+static void utf8_case_convert_inplace(char *buf, size_t len, bool to_upper) {
+    // Lead bytes of every mapped code point: U+00C0..U+017F and U+0391..U+045F
+    static const ByteSet leads(std::string_view("\xC3\xC4\xC5\xCE\xCF\xD0\xD1", 7));
+    std::string_view view(buf, len);
+    size_t pos = leads.find_first_in(view);
+    while (pos != std::string_view::npos && pos + 1 < len) {
+        unsigned char lead = static_cast<unsigned char>(buf[pos]);
+        unsigned char cont = static_cast<unsigned char>(buf[pos + 1]);
+        if ((cont & 0xC0) == 0x80) {
+            unsigned int cp = ((lead & 0x1Fu) << 6) | (cont & 0x3Fu);
+            unsigned int mapped = utf8_case_map(cp, to_upper);
+            buf[pos] = static_cast<char>(0xC0 | (mapped >> 6));
+            buf[pos + 1] = static_cast<char>(0x80 | (mapped & 0x3F));
+            pos += 2;
+        } else {
+            pos += 1; // Malformed sequence: leave it alone
+        }
+        pos = leads.find_first_in(view, pos);
+    }
+}
+
+static void case_convert(const char *src, char *dst, size_t len, bool to_upper, CaseMode mode) {
+    simd_case_convert(src, dst, len, to_upper);
+    if (mode == CaseMode::Utf8) {
+        utf8_case_convert_inplace(dst, len, to_upper);
+    }
+}
+
+// --- Substring Search (Internal) ---
+// Needles of one byte use the byte kernel. Short needles use a SIMD filter that keeps
+// positions where both the first and the last needle byte match, then verifies with
+// memcmp. Longer needles use Two-Way, which is linear in the worst case and skips
+// ahead with a last-occurrence shift table.
+
+const size_t SHORT_NEEDLE_MAX = 32;
+
+static size_t scalar_find_short(const char *h, size_t hn, const char *n, size_t len) {
+    const char first = n[0];
+    const char last = n[len - 1];
+    for (size_t i = 0; i + len <= hn; ++i) {
+        if (h[i] == first && h[i + len - 1] == last && std::memcmp(h + i + 1, n + 1, len - 2) == 0) {
+            return i;
+        }
+    }
+    return SCAN_NPOS;
+}
+
+#if defined(ATOMIX_X86_64)
+static size_t sse2_find_short(const char *h, size_t hn, const char *n, size_t len) {
+    const __m128i first = _mm_set1_epi8(n[0]);
+    const __m128i last = _mm_set1_epi8(n[len - 1]);
+    size_t i = 0;
+    for (; i + len - 1 + 16 <= hn; i += 16) {
+        __m128i block_first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(h + i));
+        __m128i block_last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(h + i + len - 1));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(block_first, first), _mm_cmpeq_epi8(block_last, last))));
+        while (mask) {
+            unsigned bit = lowest_set_bit(mask);
+            if (std::memcmp(h + i + bit + 1, n + 1, len - 2) == 0) {
+                return i + bit;
+            }
+            mask &= mask - 1;
+        }
+    }
+    size_t rest = scalar_find_short(h + i, hn - i, n, len);
+    return (rest == SCAN_NPOS) ? SCAN_NPOS : i + rest;
+}
+#endif
+
+#if defined(ATOMIX_SIMD_DISPATCH)
+ATOMIX_TARGET_AVX2 static size_t avx2_find_short(const char *h, size_t hn, const char *n, size_t len) {
+    const __m256i first = _mm256_set1_epi8(n[0]);
+    const __m256i last = _mm256_set1_epi8(n[len - 1]);
+    size_t i = 0;
+    for (; i + len - 1 + 32 <= hn; i += 32) {
+        __m256i block_first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(h + i));
+        __m256i block_last = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(h + i + len - 1));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(block_first, first), _mm256_cmpeq_epi8(block_last, last))));
+        while (mask) {
+            unsigned bit = lowest_set_bit(mask);
+            if (std::memcmp(h + i + bit + 1, n + 1, len - 2) == 0) {
+                return i + bit;
+            }
+            mask &= mask - 1;
+        }
+    }
+    size_t rest = sse2_find_short(h + i, hn - i, n, len);
+    return (rest == SCAN_NPOS) ? SCAN_NPOS : i + rest;
+}
+#endif
+
+typedef size_t (*FindShortKernel)(const char*, size_t, const char*, size_t);
+
+static FindShortKernel select_find_short_kernel() {
+#if defined(ATOMIX_SIMD_DISPATCH)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return avx2_find_short;
+#endif
+#if defined(ATOMIX_X86_64)
+    return sse2_find_short;
+#else
+    return scalar_find_short;
+#endif
+}
+
+static size_t resolve_find_short(const char *h, size_t hn, const char *n, size_t len);
+static std::atomic<FindShortKernel> find_short_kernel(resolve_find_short);
+
+static size_t resolve_find_short(const char *h, size_t hn, const char *n, size_t len) {
+    FindShortKernel kernel = select_find_short_kernel();
+    find_short_kernel.store(kernel, std::memory_order_relaxed);
+    return kernel(h, hn, n, len);
+}
+
+// Two-Way setup: critical factorization (maximal suffix under both byte orders), period,
+// and shift[c] = 1 + last index of c in the needle (0 when c does not occur).
+static void two_way_prepare(const unsigned char *n, size_t len, size_t *shift,
+                            size_t& critical_pos, size_t& period, size_t& memory) {
+    std::fill(shift, shift + 256, size_t(0));
+    for (size_t i = 0; i < len; ++i) {
+        shift[n[i]] = i + 1;
+    }
+    size_t max_suffix[2];
+    size_t max_period[2];
+    for (int order = 0; order < 2; ++order) {
+        size_t ip = static_cast<size_t>(-1), jp = 0, k = 1, p = 1;
+        while (jp + k < len) {
+            unsigned char a = n[ip + k];
+            unsigned char b = n[jp + k];
+            if (a == b) {
+                if (k == p) {
+                    jp += p;
+                    k = 1;
+                } else {
+                    ++k;
+                }
+            } else if ((order == 0) ? (a > b) : (a < b)) {
+                jp += k;
+                k = 1;
+                p = jp - ip;
+            } else {
+                ip = jp++;
+                k = p = 1;
+            }
+        }
+        max_suffix[order] = ip;
+        max_period[order] = p;
+    }
+    // The later of the two suffixes is the critical position (ip may be -1, hence the + 1)
+    size_t ms = (max_suffix[1] + 1 > max_suffix[0] + 1) ? max_suffix[1] : max_suffix[0];
+    size_t p = (max_suffix[1] + 1 > max_suffix[0] + 1) ? max_period[1] : max_period[0];
+    if (std::memcmp(n, n + p, ms + 1) != 0) {
+        // Not periodic: any shift up to the larger half is safe and nothing is remembered
+        period = std::max(ms, len - ms - 1) + 1;
+        memory = 0;
+    } else {
+        period = p;
+        memory = len - p;
+    }
+    critical_pos = ms;
+}
+
+static size_t two_way_search(const unsigned char *h, size_t hn, const unsigned char *n, size_t len, const size_t *shift,
+                             size_t critical_pos, size_t period, size_t memory) {
+    size_t pos = 0;
+    size_t mem = 0; // Prefix already known to match after a periodic shift
+    while (hn - pos >= len) {
+        const unsigned char *window = h + pos;
+        // Last byte first: jump so the window's last byte lines up with its last occurrence
+        size_t skip = len - shift[window[len - 1]];
+        if (skip) {
+            pos += std::max(skip, mem);
+            mem = 0;
+            continue;
+        }
+        size_t k = std::max(critical_pos + 1, mem);
+        while (k < len && n[k] == window[k]) ++k;
+        if (k < len) {
+            pos += k - critical_pos;
+            mem = 0;
+            continue;
+        }
+        k = critical_pos + 1;
+        while (k > mem && n[k - 1] == window[k - 1]) --k;
+        if (k <= mem) {
+            return pos;
+        }
+        pos += period;
+        mem = memory;
+    }
+    return SCAN_NPOS;
+}
+
+// Two-Way tables for one needle, prepared once when the needle is searched repeatedly
+struct TwoWayTable {
+    size_t shift[256];
+    size_t critical_pos;
+    size_t period;
+    size_t memory;
+};
+
+// Search of [h, h + hn) for needle; long needles need their prepared table, short ones
+// pass nullptr. Returns an offset or SCAN_NPOS.
+static size_t prepared_search(const char *h, size_t hn, const char *n, size_t len, const TwoWayTable *table) {
+    if (len == 0) return 0;
+    if (len > hn) return SCAN_NPOS;
+    if (len == 1) return simd_find_byte(h, hn, n[0]);
+    if (len <= SHORT_NEEDLE_MAX) return find_short_kernel.load(std::memory_order_relaxed)(h, hn, n, len);
+    return two_way_search(reinterpret_cast<const unsigned char*>(h), hn, reinterpret_cast<const unsigned char*>(n), len,
+                          table->shift, table->critical_pos, table->period, table->memory);
+}
+
+static void prepare_two_way_table(std::string_view needle, TwoWayTable& table) {
+    if (needle.size() > SHORT_NEEDLE_MAX) {
+        two_way_prepare(reinterpret_cast<const unsigned char*>(needle.data()), needle.size(), table.shift,
+                        table.critical_pos, table.period, table.memory);
+    }
+}
+
+// One-shot search of [h, h + hn) for needle; returns an offset or SCAN_NPOS
+static size_t substring_search(const char *h, size_t hn, const char *n, size_t len) {
+    if (len <= SHORT_NEEDLE_MAX) {
+        return prepared_search(h, hn, n, len, nullptr);
+    }
+    TwoWayTable table;
+    prepare_two_way_table(std::string_view(n, len), table);
+    return prepared_search(h, hn, n, len, &table);
+}
+
+// --- String Manipulation Functions ---
+// ... (copy, equals, trim remain the same) ...
+std::string string_copy(const std::string& str) {
+    return str; // std::string assignment/copy constructor handles this
+}
+
+bool string_equals(const std::string& str1, const std::string& str2) {
+    return str1 == str2;
+}
+
+std::string string_trim(const std::string& str) {
+    const char* whitespace = " \t\n\r\f\v";
+    size_t first = str.find_first_not_of(whitespace);
+    if (first == std::string::npos) {
+        return ""; // String is all whitespace
+    }
+    size_t last = str.find_last_not_of(whitespace);
+    return str.substr(first, (last - first + 1));
+}
+
+
+bool string_is_int(std::string_view str) {
+    long long value;
+    return parse_integer(str, value) == NumberStatus::Ok; // Whole (trimmed) string must be a long long
+}
+
+// ... (is_alpha, is_digit, is_alnum, is_space, is_empty, concat, substring, find_char, find_substring, replace_char, to_lower, to_upper, split, join, starts_with, ends_with, to_float remain the same) ...
+bool string_is_alpha(const std::string& str) {
+    if (str.empty()) return false; // Or true depending on definition? Usually false.
+    return std::all_of(str.begin(), str.end(), ::isalpha);
+}
+
+bool string_is_digit(const std::string& str) {
+     if (str.empty()) return false;
+    return std::all_of(str.begin(), str.end(), ::isdigit);
+}
+
+bool string_is_alnum(const std::string& str) {
+     if (str.empty()) return false;
+    return std::all_of(str.begin(), str.end(), ::isalnum);
+}
+
+bool string_is_space(const std::string& str) {
+     if (str.empty()) return false; // Or true? Let's say false.
+    return std::all_of(str.begin(), str.end(), ::isspace);
+}
+
+bool string_is_empty(const std::string& str) {
+    return str.empty();
+}
+
+std::string string_concat(const std::string& str1, const std::string& str2) {
+    std::string result;
+    result.reserve(str1.size() + str2.size()); // One allocation instead of copy-then-grow
+    result.append(str1).append(str2);
+    return result;
+}
+
+std::string string_substring(const std::string& str, size_t start, size_t length) {
+    // std::string::substr handles bounds checking (throws out_of_range if start > size)
+    // and automatically adjusts length if it goes past the end.
+    try {
+       return str.substr(start, length);
+    } catch (const std::out_of_range& oor) {
+        report_diagnostic(ErrorCode::OutOfRange, DiagnosticLevel::Error, "string_substring", "start position (%zu) is out of range for a string of length %zu.",
+                          start, str.length());
+        return ""; // Return empty string on error
+    }
+
+}
+
+long long string_find_char(const std::string& str, char c, size_t start_pos) {
+    if (start_pos >= str.size()) {
+        return -1LL;
+    }
+    size_t pos = simd_find_byte(str.data() + start_pos, str.size() - start_pos, c);
+    if (pos == SCAN_NPOS) {
+        return -1LL;
+    }
+    pos += start_pos;
+     if (pos > static_cast<size_t>(std::numeric_limits<long long>::max())) {
+            report_diagnostic(ErrorCode::Overflow, DiagnosticLevel::Warning, "string_find_char", "index %zu does not fit in long long; returning -1.", pos);
+            return -1LL;
+     }
+    return static_cast<long long>(pos);
+}
+
+long long string_find_any_of(std::string_view str, std::string_view chars, size_t start_pos) {
+    size_t pos = ByteSet(chars).find_first_in(str, start_pos);
+    if (pos == std::string_view::npos) {
+        return -1LL;
+    }
+    return static_cast<long long>(pos);
+}
+
+long long string_find_substring(const std::string& haystack, const std::string& needle, size_t start_pos) {
+    if (start_pos > haystack.size()) {
+        return -1LL;
+    }
+    size_t pos = substring_search(haystack.data() + start_pos, haystack.size() - start_pos, needle.data(), needle.size());
+    if (pos == SCAN_NPOS) {
+        return -1LL;
+    }
+    pos += start_pos;
+      if (pos > static_cast<size_t>(std::numeric_limits<long long>::max())) {
+            report_diagnostic(ErrorCode::Overflow, DiagnosticLevel::Warning, "string_find_substring", "index %zu does not fit in long long; returning -1.", pos);
+            return -1LL;
+     }
+    return static_cast<long long>(pos);
+}
+
+std::vector<size_t> string_find_all(std::string_view haystack, std::string_view needle, bool overlapping) {
+    return Searcher(needle).find_all(haystack, overlapping);
+}
+
+size_t string_count_substring(std::string_view haystack, std::string_view needle, bool overlapping) {
+    return Searcher(needle).count(haystack, overlapping);
+}
+
+std::string string_replace_char(const std::string& str, char find, char replace) {
+    std::string result = str;
+    std::replace(result.begin(), result.end(), find, replace);
+    return result;
+}
+
+// Replacement driver shared by the replace-all variants: one counting scan, then one
+// writing scan, so the output is sized exactly before anything is written.
+static size_t count_occurrences(std::string_view str, std::string_view from, const TwoWayTable *table) {
+    size_t count = 0;
+    size_t pos = 0;
+    while (pos <= str.size()) {
+        size_t hit = prepared_search(str.data() + pos, str.size() - pos, from.data(), from.size(), table);
+        if (hit == SCAN_NPOS) break;
+        ++count;
+        pos += hit + from.size();
+    }
+    return count;
+}
+
+// Writes str with every occurrence replaced into out (which must hold the full result);
+// out may equal str.data() when to is not longer than from
+static void write_replaced(std::string_view str, std::string_view from, std::string_view to,
+                           const TwoWayTable *table, char *out) {
+    size_t pos = 0;
+    while (pos <= str.size()) {
+        size_t hit = prepared_search(str.data() + pos, str.size() - pos, from.data(), from.size(), table);
+        if (hit == SCAN_NPOS) break;
+        std::memmove(out, str.data() + pos, hit);
+        out += hit;
+        std::memcpy(out, to.data(), to.size());
+        out += to.size();
+        pos += hit + from.size();
+    }
+    std::memmove(out, str.data() + pos, str.size() - pos);
+}
+
+std::string string_replace_all(std::string_view str, std::string_view from, std::string_view to) {
+    if (from.empty()) {
+        return std::string(str);
+    }
+    TwoWayTable table;
+    prepare_two_way_table(from, table);
+    size_t count = count_occurrences(str, from, &table);
+    std::string result(str.size() - count * from.size() + count * to.size(), '\0');
+    write_replaced(str, from, to, &table, &result[0]);
+    return result;
+}
+
+size_t string_replace_all_into(std::string_view str, std::string_view from, std::string_view to,
+                               char* out, size_t out_capacity) {
+    if (from.empty()) {
+        if (out != nullptr && out_capacity >= str.size()) std::memcpy(out, str.data(), str.size());
+        return str.size();
+    }
+    TwoWayTable table;
+    prepare_two_way_table(from, table);
+    size_t count = count_occurrences(str, from, &table);
+    size_t required = str.size() - count * from.size() + count * to.size();
+    if (out != nullptr && out_capacity >= required) {
+        write_replaced(str, from, to, &table, out);
+    }
+    return required;
+}
+
+size_t string_replace_all_inplace(std::string& str, std::string_view from, std::string_view to) {
+    if (from.empty()) {
+        return 0;
+    }
+    TwoWayTable table;
+    prepare_two_way_table(from, table);
+    size_t count = count_occurrences(str, from, &table);
+    if (count == 0) {
+        return 0;
+    }
+    if (to.size() <= from.size()) {
+        // The write position never passes the read position, so compact in place
+        write_replaced(str, from, to, &table, &str[0]);
+        str.resize(str.size() - count * (from.size() - to.size()));
+    } else {
+        std::string result(str.size() + count * (to.size() - from.size()), '\0');
+        write_replaced(str, from, to, &table, &result[0]);
+        str.swap(result);
+    }
+    return count;
+}
+
+std::string string_to_lower(const std::string& str, CaseMode mode) {
+    std::string result = str;
+    string_to_lower_inplace(result, mode);
+    return result;
+}
+
+std::string string_to_upper(const std::string& str, CaseMode mode) {
+    std::string result = str;
+    string_to_upper_inplace(result, mode);
+    return result;
+}
+
+void string_to_lower_inplace(std::string& str, CaseMode mode) {
+    case_convert(str.data(), &str[0], str.size(), false, mode);
+}
+
+void string_to_upper_inplace(std::string& str, CaseMode mode) {
+    case_convert(str.data(), &str[0], str.size(), true, mode);
+}
+
+void string_to_lower_inplace(char* buf, size_t len, CaseMode mode) {
+    if (buf == nullptr) {
+        if (len > 0) set_last_error(ErrorCode::NullArgument);
+        return;
+    }
+    case_convert(buf, buf, len, false, mode);
+}
+
+void string_to_upper_inplace(char* buf, size_t len, CaseMode mode) {
+    if (buf == nullptr) {
+        if (len > 0) set_last_error(ErrorCode::NullArgument);
+        return;
+    }
+    case_convert(buf, buf, len, true, mode);
+}
+
+size_t string_to_lower_into(std::string_view src, char* out, size_t out_capacity, CaseMode mode) {
+    if (out == nullptr || out_capacity < src.size()) {
+        set_last_error((out == nullptr) ? ErrorCode::NullArgument : ErrorCode::InvalidArgument);
+        return 0;
+    }
+    case_convert(src.data(), out, src.size(), false, mode);
+    return src.size();
+}
+
+size_t string_to_upper_into(std::string_view src, char* out, size_t out_capacity, CaseMode mode) {
+    if (out == nullptr || out_capacity < src.size()) {
+        set_last_error((out == nullptr) ? ErrorCode::NullArgument : ErrorCode::InvalidArgument);
+        return 0;
+    }
+    case_convert(src.data(), out, src.size(), true, mode);
+    return src.size();
+}
+
+void string_to_lower_into(std::string_view src, std::string& out, CaseMode mode) {
+    out.resize(src.size()); // Reuses out's capacity
+    case_convert(src.data(), &out[0], src.size(), false, mode);
+}
+
+void string_to_upper_into(std::string_view src, std::string& out, CaseMode mode) {
+    out.resize(src.size());
+    case_convert(src.data(), &out[0], src.size(), true, mode);
+}
+
+bool string_equals_ignore_case(std::string_view str1, std::string_view str2) {
+    return str1.size() == str2.size() && simd_case_equal(str1.data(), str2.data(), str1.size());
+}
+
+bool string_starts_with_ignore_case(std::string_view str, std::string_view prefix) {
+    return str.size() >= prefix.size() && simd_case_equal(str.data(), prefix.data(), prefix.size());
+}
+
+long long string_find_ignore_case(std::string_view haystack, std::string_view needle, size_t start_pos) {
+    if (start_pos > haystack.size() || needle.size() > haystack.size() - start_pos) {
+        return -1LL;
+    }
+    if (needle.empty()) {
+        return static_cast<long long>(start_pos);
+    }
+    // Scan for either case of the first needle byte, then verify the rest
+    const char first_pair[2] = {ascii_lower(needle[0]), ascii_upper(needle[0])};
+    const ByteSet first(std::string_view(first_pair, 2));
+    const size_t last_start = haystack.size() - needle.size();
+    size_t pos = first.find_first_in(haystack, start_pos);
+    while (pos != std::string_view::npos && pos <= last_start) {
+        if (simd_case_equal(haystack.data() + pos + 1, needle.data() + 1, needle.size() - 1)) {
+            return static_cast<long long>(pos);
+        }
+        pos = first.find_first_in(haystack, pos + 1);
+    }
+    return -1LL;
+}
+
+std::vector<std::string> string_split(const std::string& str, char delimiter) {
+    std::vector<std::string> tokens;
+    if (str.empty()) {
+        return tokens; // No tokens for an empty string
+    }
+    for (std::string_view token : string_split_range(str, delimiter)) {
+        tokens.emplace_back(token);
+    }
+    // Keep the historical std::getline behaviour: a trailing delimiter does not
+    // produce a trailing empty token
+    if (str.back() == delimiter) {
+        tokens.pop_back();
+    }
+    return tokens;
+}
+
+// --- Substring Search ---
+
+Searcher::Searcher(std::string_view needle) : needle_(needle) {
+    if (needle_.size() > SHORT_NEEDLE_MAX) {
+        std::shared_ptr<TwoWayTable> table = std::make_shared<TwoWayTable>();
+        prepare_two_way_table(needle_, *table);
+        table_ = table;
+    }
+}
+
+size_t Searcher::find(std::string_view haystack, size_t start_pos) const {
+    if (start_pos > haystack.size()) {
+        return std::string_view::npos;
+    }
+    size_t hit = prepared_search(haystack.data() + start_pos, haystack.size() - start_pos,
+                                 needle_.data(), needle_.size(), table_.get());
+    return (hit == SCAN_NPOS) ? std::string_view::npos : start_pos + hit;
+}
+
+std::vector<size_t> Searcher::find_all(std::string_view haystack, bool overlapping) const {
+    std::vector<size_t> matches;
+    if (needle_.empty()) {
+        return matches; // An empty needle would match everywhere; report nothing
+    }
+    const size_t step = overlapping ? 1 : needle_.size();
+    for (size_t pos = find(haystack); pos != std::string_view::npos; pos = find(haystack, pos + step)) {
+        matches.push_back(pos);
+    }
+    return matches;
+}
+
+size_t Searcher::count(std::string_view haystack, bool overlapping) const {
+    if (needle_.empty()) {
+        return 0;
+    }
+    const size_t step = overlapping ? 1 : needle_.size();
+    size_t total = 0;
+    for (size_t pos = find(haystack); pos != std::string_view::npos; pos = find(haystack, pos + step)) {
+        ++total;
+    }
+    return total;
+}
+
+// --- Multi-Pattern Matching ---
+
+MultiPatternMatcher::MultiPatternMatcher(const std::vector<std::string>& patterns)
+    : class_count_(1), byte_class_{} {
+    // Byte classes: every byte used by some pattern gets its own class, the rest share 0
+    bool used[256] = {};
+    for (const std::string& pattern : patterns) {
+        for (char ch : pattern) used[static_cast<unsigned char>(ch)] = true;
+    }
+    unsigned int next_class = std::count(used, used + 256, true) == 256 ? 0 : 1;
+    for (int b = 0; b < 256; ++b) {
+        if (used[b]) byte_class_[b] = static_cast<unsigned char>(next_class++);
+    }
+    class_count_ = next_class;
+    const size_t width = class_count_;
+
+    // Trie: rows indexed by state, 0 means no edge (no trie edge leads back to the root)
+    std::vector<unsigned int> rows(width, 0);
+    first_output_.assign(1, NO_STATE);
+    pattern_lengths_.resize(patterns.size());
+    next_output_.assign(patterns.size(), NO_STATE);
+    for (size_t id = 0; id < patterns.size(); ++id) {
+        const std::string& pattern = patterns[id];
+        pattern_lengths_[id] = pattern.size();
+        if (pattern.empty()) continue;
+        size_t state = 0;
+        for (char ch : pattern) {
+            size_t slot = state * width + byte_class_[static_cast<unsigned char>(ch)];
+            if (rows[slot] == 0) {
+                if (first_output_.size() >= (MATCH_FLAG - 1) / width) {
+                    report_diagnostic(ErrorCode::CapacityExceeded, DiagnosticLevel::Error, "MultiPatternMatcher", "the patterns exceed the supported table size.");
+                    *this = MultiPatternMatcher();
+                    return;
+                }
+                rows[slot] = static_cast<unsigned int>(first_output_.size());
+                first_output_.push_back(NO_STATE);
+                rows.resize(rows.size() + width, 0);
+            }
+            state = rows[slot];
+        }
+        // Prepend; walking the list later reports ids in descending order for duplicates
+        next_output_[id] = first_output_[state];
+        first_output_[state] = static_cast<unsigned int>(id);
+    }
+
+    // Breadth-first: failure links, dictionary links, and missing edges filled from the
+    // failure state's (already complete) row
+    const size_t states = first_output_.size();
+    std::vector<unsigned int> fail(states, 0);
+    dict_link_.assign(states, NO_STATE);
+    std::vector<unsigned int> queue;
+    queue.reserve(states);
+    for (size_t c = 0; c < width; ++c) {
+        if (rows[c] != 0) queue.push_back(rows[c]); // Depth 1: fail to the root; root misses stay at 0
+    }
+    for (size_t head = 0; head < queue.size(); ++head) {
+        unsigned int u = queue[head];
+        unsigned int f = fail[u];
+        for (size_t c = 0; c < width; ++c) {
+            unsigned int& edge = rows[u * width + c];
+            if (edge != 0) {
+                unsigned int v = edge;
+                unsigned int vf = (u == 0) ? 0 : rows[f * width + c];
+                fail[v] = vf;
+                dict_link_[v] = (first_output_[vf] != NO_STATE) ? vf : dict_link_[vf];
+                queue.push_back(v);
+            } else {
+                edge = rows[f * width + c];
+            }
+        }
+    }
+
+    // Renumber in breadth-first order: scanning spends most steps in shallow states, and
+    // this packs their rows together at the front of the table.
+    std::vector<unsigned int> order(1, 0);
+    order.insert(order.end(), queue.begin(), queue.end());
+    std::vector<unsigned int> renumber(states);
+    for (size_t i = 0; i < states; ++i) renumber[order[i]] = static_cast<unsigned int>(i);
+    std::vector<unsigned int> outputs(states);
+    std::vector<unsigned int> links(states);
+    for (size_t i = 0; i < states; ++i) {
+        outputs[i] = first_output_[order[i]];
+        links[i] = (dict_link_[order[i]] == NO_STATE) ? NO_STATE : renumber[dict_link_[order[i]]];
+    }
+    first_output_.swap(outputs);
+    dict_link_.swap(links);
+
+    // Premultiply and flag transitions into states that report something
+    transitions_.resize(rows.size());
+    for (size_t i = 0; i < states; ++i) {
+        const unsigned int* row = &rows[order[i] * width];
+        for (size_t c = 0; c < width; ++c) {
+            unsigned int target = renumber[row[c]];
+            bool reports = first_output_[target] != NO_STATE || dict_link_[target] != NO_STATE;
+            transitions_[i * width + c] = static_cast<unsigned int>(target * width) | (reports ? MATCH_FLAG : 0u);
+        }
+    }
+}
+
+std::vector<PatternMatch> MultiPatternMatcher::find_all(std::string_view haystack) const {
+    std::vector<PatternMatch> matches;
+    scan(haystack, [&matches](const PatternMatch& match) { matches.push_back(match); });
+    return matches;
+}
+
+bool MultiPatternMatcher::contains_any(std::string_view haystack) const {
+    const unsigned int* table = transitions_.data();
+    unsigned int state = 0;
+    for (char ch : haystack) {
+        state = table[state + byte_class_[static_cast<unsigned char>(ch)]];
+        if (state & MATCH_FLAG) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void MultiPatternMatcher::scan_chunk(StreamState& stream, std::string_view chunk, std::vector<PatternMatch>& out) const {
+    auto append = [&out](const PatternMatch& match) { out.push_back(match); };
+    scan_stream(stream, chunk, append);
+}
+
+// --- Batch Rewriting ---
+
+StringRewriter::StringRewriter(const std::vector<std::pair<std::string, std::string>>& rules) {
+    std::vector<std::string> patterns;
+    patterns.reserve(rules.size());
+    replacements_.reserve(rules.size());
+    for (const auto& rule : rules) {
+        patterns.push_back(rule.first);
+        replacements_.push_back(rule.second);
+    }
+    matcher_ = MultiPatternMatcher(patterns);
+    pattern_lengths_.reserve(patterns.size());
+    for (const std::string& pattern : patterns) pattern_lengths_.push_back(pattern.size());
+}
+
+// Leftmost-longest: among matches starting at the same offset the longest wins (then the
+// earliest rule), and matches overlapping an already chosen one are dropped.
+void StringRewriter::select_matches(std::string_view str, std::vector<PatternMatch>& chosen) const {
+    std::vector<PatternMatch> all = matcher_.find_all(str);
+    std::sort(all.begin(), all.end(), [this](const PatternMatch& a, const PatternMatch& b) {
+        if (a.offset != b.offset) return a.offset < b.offset;
+        if (pattern_lengths_[a.pattern_id] != pattern_lengths_[b.pattern_id]) {
+            return pattern_lengths_[a.pattern_id] > pattern_lengths_[b.pattern_id];
+        }
+        return a.pattern_id < b.pattern_id;
+    });
+    chosen.clear();
+    size_t next_free = 0;
+    for (const PatternMatch& match : all) {
+        if (match.offset >= next_free) {
+            chosen.push_back(match);
+            next_free = match.offset + pattern_lengths_[match.pattern_id];
+        }
+    }
+}
+
+size_t StringRewriter::output_size(std::string_view str, const std::vector<PatternMatch>& chosen) const {
+    size_t size = str.size();
+    for (const PatternMatch& match : chosen) {
+        size = size - pattern_lengths_[match.pattern_id] + replacements_[match.pattern_id].size();
+    }
+    return size;
+}
+
+void StringRewriter::write_output(std::string_view str, const std::vector<PatternMatch>& chosen, char* out) const {
+    size_t pos = 0;
+    for (const PatternMatch& match : chosen) {
+        const std::string& replacement = replacements_[match.pattern_id];
+        std::memmove(out, str.data() + pos, match.offset - pos);
+        out += match.offset - pos;
+        std::memcpy(out, replacement.data(), replacement.size());
+        out += replacement.size();
+        pos = match.offset + pattern_lengths_[match.pattern_id];
+    }
+    std::memmove(out, str.data() + pos, str.size() - pos);
+}
+
+std::string StringRewriter::rewrite(std::string_view str) const {
+    std::vector<PatternMatch> chosen;
+    select_matches(str, chosen);
+    std::string result(output_size(str, chosen), '\0');
+    write_output(str, chosen, &result[0]);
+    return result;
+}
+
+size_t StringRewriter::rewrite_into(std::string_view str, char* out, size_t out_capacity) const {
+    std::vector<PatternMatch> chosen;
+    select_matches(str, chosen);
+    size_t required = output_size(str, chosen);
+    if (out != nullptr && out_capacity >= required) {
+        write_output(str, chosen, out);
+    }
+    return required;
+}
+
+size_t StringRewriter::rewrite_inplace(std::string& str) const {
+    std::vector<PatternMatch> chosen;
+    select_matches(str, chosen);
+    if (chosen.empty()) {
+        return 0;
+    }
+    bool grows = false;
+    for (const PatternMatch& match : chosen) {
+        grows = grows || replacements_[match.pattern_id].size() > pattern_lengths_[match.pattern_id];
+    }
+    size_t required = output_size(str, chosen);
+    if (!grows) {
+        write_output(str, chosen, &str[0]);
+        str.resize(required);
+    } else {
+        std::string result(required, '\0');
+        write_output(str, chosen, &result[0]);
+        str.swap(result);
+    }
+    return chosen.size();
+}
+
+// --- String Building ---
+
+// Formats value with std::to_chars into a stack array, then appends the digits in one copy
+template <typename T>
+static void append_number(std::string& buffer, T value) {
+    char digits[32]; // Enough for any 64-bit integer and the shortest round-trip double
+    std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), value);
+    buffer.append(digits, static_cast<size_t>(result.ptr - digits));
+}
+
+StringBuilder& StringBuilder::append(int value) { append_number(buffer_, value); return *this; }
+StringBuilder& StringBuilder::append(unsigned int value) { append_number(buffer_, value); return *this; }
+StringBuilder& StringBuilder::append(long value) { append_number(buffer_, value); return *this; }
+StringBuilder& StringBuilder::append(unsigned long value) { append_number(buffer_, value); return *this; }
+StringBuilder& StringBuilder::append(long long value) { append_number(buffer_, value); return *this; }
+StringBuilder& StringBuilder::append(unsigned long long value) { append_number(buffer_, value); return *this; }
+StringBuilder& StringBuilder::append(float value) { append_number(buffer_, value); return *this; }
+StringBuilder& StringBuilder::append(double value) { append_number(buffer_, value); return *this; }
+
+// --- Bulk Column Parsing ---
+// Fields end at the delimiter or '\n'. Blank lines are skipped, and the empty field after
+// a final separator does not count. Parallel mode cuts the buffer just after separators
+// (no field can straddle a cut), counts the fields of each chunk, then parses every chunk
+// straight into its slice of the output.
+
+const size_t PARALLEL_PARSE_MIN_SIZE = 1 << 20; // Smaller buffers parse faster on one thread
+const size_t PARSE_CHUNK_BYTES = 1 << 18;
+const size_t MAX_PARSE_CHUNKS = 1024;
+
+#if (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__) || defined(_MSC_VER)
+#define ATOMIX_LITTLE_ENDIAN 1
+#endif
+
+#if defined(ATOMIX_LITTLE_ENDIAN)
+// SWAR digit parsing: eight ASCII digits loaded as one 64-bit word are validated and
+// combined with three multiplies instead of eight dependent multiply-adds
+static inline bool is_eight_digits(unsigned long long chunk) {
+    return (((chunk & 0xF0F0F0F0F0F0F0F0ULL) |
+             (((chunk + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) == 0x3333333333333333ULL);
+}
+
+static inline unsigned long long parse_eight_digits(unsigned long long chunk) {
+    chunk -= 0x3030303030303030ULL;
+    chunk = (chunk * 10) + (chunk >> 8);
+    chunk = (((chunk & 0x000000FF000000FFULL) * 0x000F424000000064ULL) +
+             (((chunk >> 16) & 0x000000FF000000FFULL) * 0x0000271000000001ULL)) >> 32;
+    return chunk & 0xFFFFFFFFULL;
+}
+
+// The 8 bytes ending at end, with the first 8 - digits bytes replaced by '0' so that a
+// short number reads as a zero-padded eight-digit one. Reads before the field, so the
+// caller guarantees end - 8 is inside the buffer.
+static inline unsigned long long load_digits_right_aligned(const char* end, size_t digits) {
+    static const unsigned long long pad_masks[9] = {
+        0xFFFFFFFFFFFFFFFFULL, 0x00FFFFFFFFFFFFFFULL, 0x0000FFFFFFFFFFFFULL, 0x000000FFFFFFFFFFULL,
+        0x00000000FFFFFFFFULL, 0x0000000000FFFFFFULL, 0x000000000000FFFFULL, 0x00000000000000FFULL, 0};
+    unsigned long long word;
+    std::memcpy(&word, end - 8, 8);
+    const unsigned long long pad = pad_masks[digits];
+    return (word & ~pad) | (0x3030303030303030ULL & pad);
+}
+#endif
+
+// value has at most 18 digits, so it fits in long long and the range checks are exact
+template <typename T>
+static inline bool store_integer(unsigned long long value, bool negative, T& out) {
+    long long signed_value = negative ? -static_cast<long long>(value) : static_cast<long long>(value);
+    if (signed_value < static_cast<long long>(std::numeric_limits<T>::min()) ||
+        signed_value > static_cast<long long>(std::numeric_limits<T>::max())) {
+        return false;
+    }
+    out = static_cast<T>(signed_value);
+    return true;
+}
+
+// readable_from is the start of the whole buffer: fields of up to 16 digits that are not
+// at its very start are parsed with two right-aligned word loads and no per-digit branches
+template <typename T>
+static bool parse_integer_field(std::string_view field, T& out, const char* readable_from) {
+    if (field.empty()) return false;
+    // Most fields carry no padding; skip the trim loops for them
+    bool padded = is_space_byte(field.front()) || is_space_byte(field.back());
+    std::string_view text = padded ? trim_view(field) : field;
+    const char* p = text.data();
+    const char* end = p + text.size();
+    if (p == end) return false;
+    const bool negative = (*p == '-'); // Branch-free: signs are often random across a column
+    p += (*p == '-') | (*p == '+');
+    const size_t digits = static_cast<size_t>(end - p);
+#if defined(ATOMIX_LITTLE_ENDIAN)
+    if (digits - 1 < 16 && end - readable_from >= 16) {
+        const size_t low_digits = std::min<size_t>(digits, 8);
+        unsigned long long low = load_digits_right_aligned(end, low_digits);
+        unsigned long long high = load_digits_right_aligned(end - 8, digits - low_digits);
+        if (!is_eight_digits(low) || !is_eight_digits(high)) return false;
+        return store_integer(parse_eight_digits(high) * 100000000ULL + parse_eight_digits(low), negative, out);
+    }
+#endif
+    if (digits == 0 || digits > 18) {
+        return digits != 0 && parse_integer(field, out) == NumberStatus::Ok; // Rare: let from_chars handle it
+    }
+    unsigned long long value = 0;
+    for (; p != end; ++p) {
+        unsigned int digit = static_cast<unsigned int>(static_cast<unsigned char>(*p) - '0');
+        if (digit > 9) return false;
+        value = value * 10 + digit;
+    }
+    return store_integer(value, negative, out);
+}
+
+template <typename T>
+static bool parse_floating_field(std::string_view field, T& out) {
+    NumberStatus status = parse_floating(field, out); // from_chars: fast_float-based in current libraries
+    if (status == NumberStatus::Underflow) {
+        out = T(0);
+        return true;
+    }
+    return status == NumberStatus::Ok;
+}
+
+// A whitespace-only field that fills a whole line
+static inline bool is_blank_line(std::string_view buffer, size_t start, size_t end, bool ends_line) {
+    if (!ends_line || (start > 0 && buffer[start - 1] != '\n')) return false;
+    return trim_view(buffer.substr(start, end - start)).empty();
+}
+
+// Bit i is set when p[i] is a separator. Numeric fields are short, so one 64-byte bitmap
+// serves several fields instead of one search call per field.
+static inline unsigned long long separator_mask(const char* p, size_t n, char delimiter) {
+    unsigned long long mask = 0;
+#if defined(ATOMIX_X86_64)
+    if (n == 64) {
+        const __m128i delim = _mm_set1_epi8(delimiter);
+        const __m128i newline = _mm_set1_epi8('\n');
+        for (int k = 0; k < 4; ++k) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16 * k));
+            __m128i hit = _mm_or_si128(_mm_cmpeq_epi8(v, delim), _mm_cmpeq_epi8(v, newline));
+            mask |= static_cast<unsigned long long>(static_cast<unsigned>(_mm_movemask_epi8(hit))) << (16 * k);
+        }
+        return mask;
+    }
+#endif
+    for (size_t i = 0; i < n; ++i) {
+        if (p[i] == delimiter || p[i] == '\n') mask |= 1ULL << i;
+    }
+    return mask;
+}
+
+static inline unsigned lowest_set_bit64(unsigned long long mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanForward64(&index, mask);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctzll(mask));
+#endif
+}
+
+// Visits the fields of buffer[begin, end) as (start, end) byte ranges; begin must be 0 or
+// just after a separator
+template <typename Visit>
+static void for_each_field(std::string_view buffer, char delimiter, size_t begin, size_t end, Visit visit) {
+    const char* data = buffer.data();
+    size_t field_start = begin;
+    for (size_t block = begin; block < end; block += 64) {
+        unsigned long long mask = separator_mask(data + block, std::min<size_t>(64, end - block), delimiter);
+        while (mask != 0) {
+            size_t sep = block + lowest_set_bit64(mask);
+            mask &= mask - 1;
+            if (!is_blank_line(buffer, field_start, sep, data[sep] == '\n')) {
+                visit(field_start, sep);
+            }
+            field_start = sep + 1;
+        }
+    }
+    if (field_start < end && !is_blank_line(buffer, field_start, end, true)) {
+        visit(field_start, end);
+    }
+}
+
+template <typename T, typename FieldParser>
+static size_t parse_column(std::string_view buffer, char delimiter, std::vector<T>& out,
+                           std::vector<ColumnParseError>* errors, unsigned int num_threads, FieldParser parse_field) {
+    const char separator_chars[2] = {delimiter, '\n'};
+    const ByteSet separators(std::string_view(separator_chars, 2)); // Only to place chunk cuts
+    out.clear();
+    if (errors != nullptr) errors->clear();
+
+    size_t chunk_count = 1;
+    if (num_threads != 1 && buffer.size() >= PARALLEL_PARSE_MIN_SIZE) {
+        chunk_count = std::min(buffer.size() / PARSE_CHUNK_BYTES, MAX_PARSE_CHUNKS);
+    }
+    std::vector<size_t> bounds(1, 0);
+    for (size_t c = 1; c < chunk_count; ++c) {
+        size_t target = std::max(buffer.size() / chunk_count * c, bounds.back());
+        size_t sep = separators.find_first_in(buffer, target);
+        if (sep == std::string_view::npos) break;
+        bounds.push_back(sep + 1);
+    }
+    bounds.push_back(buffer.size());
+    const size_t chunks = bounds.size() - 1;
+
+    std::vector<size_t> first_field(chunks + 1, 0); // Output index of each chunk's first field
+    std::vector<std::vector<ColumnParseError>> chunk_errors(chunks);
+    std::vector<size_t> chunk_failures(chunks, 0);
+    // Parses chunk c, handing each (index, value) to store; failed fields hold T()
+    auto parse_chunk = [&](size_t c, auto store) {
+        size_t index = first_field[c];
+        size_t failures = 0;
+        for_each_field(buffer, delimiter, bounds[c], bounds[c + 1], [&](size_t start, size_t end) {
+            std::string_view field = buffer.substr(start, end - start);
+            T value = T();
+            if (!parse_field(field, value)) {
+                value = T();
+                ++failures;
+                if (errors != nullptr) chunk_errors[c].push_back(ColumnParseError{index, start, field});
+            }
+            store(index++, value);
+        });
+        chunk_failures[c] = failures;
+    };
+
+    if (chunks == 1) {
+        // Serial: appending is cheaper than a separate counting pass
+        parse_chunk(0, [&out](size_t, T value) { out.push_back(value); });
+    } else {
+        // Pass 1 counts each chunk's fields so pass 2 can write its slice in place
+        run_parallel_tasks(chunks, num_threads, [&](size_t c) {
+            size_t count = 0;
+            for_each_field(buffer, delimiter, bounds[c], bounds[c + 1], [&count](size_t, size_t) { ++count; });
+            first_field[c + 1] = count;
+        });
+        for (size_t c = 0; c < chunks; ++c) first_field[c + 1] += first_field[c];
+        out.resize(first_field[chunks]);
+        T* dest = out.data();
+        run_parallel_tasks(chunks, num_threads, [&](size_t c) {
+            parse_chunk(c, [dest](size_t index, T value) { dest[index] = value; });
+        });
+    }
+
+    size_t failures = 0;
+    for (size_t c = 0; c < chunks; ++c) {
+        failures += chunk_failures[c];
+        if (errors != nullptr) errors->insert(errors->end(), chunk_errors[c].begin(), chunk_errors[c].end());
+    }
+    return out.size() - failures;
+}
+
+size_t parse_int_column(std::string_view buffer, char delimiter, std::vector<int>& out,
+                        std::vector<ColumnParseError>* errors, unsigned int num_threads) {
+    return parse_column(buffer, delimiter, out, errors, num_threads,
+                        [begin = buffer.data()](std::string_view field, int& value) {
+                            return parse_integer_field(field, value, begin);
+                        });
+}
+
+size_t parse_long_column(std::string_view buffer, char delimiter, std::vector<long>& out,
+                         std::vector<ColumnParseError>* errors, unsigned int num_threads) {
+    return parse_column(buffer, delimiter, out, errors, num_threads,
+                        [begin = buffer.data()](std::string_view field, long& value) {
+                            return parse_integer_field(field, value, begin);
+                        });
+}
+
+size_t parse_float_column(std::string_view buffer, char delimiter, std::vector<float>& out,
+                          std::vector<ColumnParseError>* errors, unsigned int num_threads) {
+    return parse_column(buffer, delimiter, out, errors, num_threads,
+                        [](std::string_view field, float& value) { return parse_floating_field(field, value); }); // Inlined, unlike a function pointer
+}
+
+size_t parse_double_column(std::string_view buffer, char delimiter, std::vector<double>& out,
+                           std::vector<ColumnParseError>* errors, unsigned int num_threads) {
+    return parse_column(buffer, delimiter, out, errors, num_threads,
+                        [](std::string_view field, double& value) { return parse_floating_field(field, value); }); // Inlined, unlike a function pointer
+}
+
+// --- Bulk Input ---
+// Tokens are found 64 bytes at a time: a bitmap of separator bytes (anything up to ' ',
+// which covers all whitespace, plus the delimiter) is XORed with itself shifted by one, and
+// each set bit is a token start or end. Numbers then go through the column parsers above.
+
+// Bit i is set when p[i] is whitespace (or another control byte) or the delimiter
+static inline unsigned long long token_separator_mask(const char* p, size_t n, char delimiter) {
+    unsigned long long mask = 0;
+    size_t i = 0;
+#if defined(ATOMIX_X86_64)
+    // Whole 16-byte chunks go through SSE2, so short lines only pay for their last few bytes
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i delim = _mm_set1_epi8(delimiter);
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        __m128i blank = _mm_cmpeq_epi8(_mm_min_epu8(v, space), v); // Unsigned v <= ' '
+        __m128i hit = _mm_or_si128(blank, _mm_cmpeq_epi8(v, delim));
+        mask |= static_cast<unsigned long long>(static_cast<unsigned>(_mm_movemask_epi8(hit))) << i;
+    }
+#endif
+    for (; i < n; ++i) {
+        if (static_cast<unsigned char>(p[i]) <= ' ' || p[i] == delimiter) mask |= 1ULL << i;
+    }
+    return mask;
+}
+
+// Calls visit(start, end) for each token of text until it returns false; false if stopped
+template <typename Visit>
+static bool for_each_token(std::string_view text, char delimiter, Visit visit) {
+    unsigned long long before = 1; // Bit 0: the byte before the block was a separator
+    size_t token_start = 0;
+    for (size_t block = 0; block < text.size(); block += 64) {
+        size_t n = std::min<size_t>(64, text.size() - block);
+        unsigned long long separators = token_separator_mask(text.data() + block, n, delimiter);
+        if (n < 64) separators |= ~0ULL << n; // Past the end counts as separator
+        unsigned long long edges = separators ^ ((separators << 1) | before);
+        before = separators >> 63;
+        while (edges != 0) {
+            size_t pos = block + lowest_set_bit64(edges);
+            if ((separators >> (pos - block)) & 1) {
+                if (pos > text.size()) pos = text.size();
+                if (!visit(token_start, pos)) return false;
+            } else {
+                token_start = pos;
+            }
+            edges &= edges - 1;
+        }
+    }
+    if (!before) {
+        return visit(token_start, text.size()); // Token runs to the end of a 64-byte multiple
+    }
+    return true;
+}
+
+template <typename T, typename Parse>
+static size_t read_values(T* out, std::vector<T>* vec, size_t count, char delimiter, T min_val, T max_val,
+                          Parse parse, const char* function_name) {
+    const bool until_end = (count == 0 && vec != nullptr);
+    size_t stored = 0;
+    bool failed = false;
+    while ((until_end || stored < count) && !failed) {
+        std::string_view line = get_line_view();
+        if (line.empty() && (std::cin.eof() || std::cin.fail())) {
+            if (!until_end) {
+                std::cerr << "Error in " << function_name << ": input ended after " << stored << " of " << count << " values." << std::endl;
+            }
+            break;
+        }
+        for_each_token(line, delimiter, [&](size_t start, size_t end) {
+            if (!until_end && stored == count) return false;
+            std::string_view token = line.substr(start, end - start);
+            T value = T(0);
+            if (!parse(token, value, line.data())) {
+                std::cerr << "Error in " << function_name << ": '" << token << "' is not a valid number." << std::endl;
+                failed = true;
+                return false;
+            }
+            if (value < min_val || value > max_val) {
+                std::cerr << "Error in " << function_name << ": " << token << " is outside [" << min_val << ", " << max_val << "]." << std::endl;
+                failed = true;
+                return false;
+            }
+            if (vec != nullptr) {
+                vec->push_back(value);
+            } else {
+                out[stored] = value;
+            }
+            ++stored;
+            return true;
+        });
+    }
+    return stored;
+}
+
+// Lambdas rather than function pointers, so the parser inlines into the token loop
+static const auto parse_int_token = [](std::string_view token, int& value, const char* readable_from) {
+    return parse_integer_field(token, value, readable_from);
+};
+
+static const auto parse_long_token = [](std::string_view token, long& value, const char* readable_from) {
+    return parse_integer_field(token, value, readable_from);
+};
+
+static const auto parse_double_token = [](std::string_view token, double& value, const char*) {
+    return parse_floating_field(token, value);
+};
+
+size_t get_ints(std::vector<int>& out, size_t count, char delimiter, int min_val, int max_val) {
+    out.clear();
+    out.reserve(count);
+    return read_values<int>(nullptr, &out, count, delimiter, min_val, max_val, parse_int_token, "get_ints");
+}
+
+size_t get_ints(int *out, size_t count, char delimiter, int min_val, int max_val) {
+    return read_values<int>(out, nullptr, count, delimiter, min_val, max_val, parse_int_token, "get_ints");
+}
+
+size_t get_longs(std::vector<long>& out, size_t count, char delimiter, long min_val, long max_val) {
+    out.clear();
+    out.reserve(count);
+    return read_values<long>(nullptr, &out, count, delimiter, min_val, max_val, parse_long_token, "get_longs");
+}
+
+size_t get_longs(long *out, size_t count, char delimiter, long min_val, long max_val) {
+    return read_values<long>(out, nullptr, count, delimiter, min_val, max_val, parse_long_token, "get_longs");
+}
+
+size_t get_doubles(std::vector<double>& out, size_t count, char delimiter, double min_val, double max_val) {
+    out.clear();
+    out.reserve(count);
+    return read_values<double>(nullptr, &out, count, delimiter, min_val, max_val, parse_double_token, "get_doubles");
+}
+
+size_t get_doubles(double *out, size_t count, char delimiter, double min_val, double max_val) {
+    return read_values<double>(out, nullptr, count, delimiter, min_val, max_val, parse_double_token, "get_doubles");
+}
+
+// --- Delimited Record Reading ---
+// Record boundaries are found 64 bytes at a time: a prefix XOR of the quote bitmap marks
+// the bytes inside quotes (an escaped "" toggles twice and cancels out), and the newlines
+// outside them end records. The scan resumes where the previous chunk left it, so each byte
+// is scanned once. That pass is serial and cheap; the records are then handed out in runs
+// that parse in parallel, each writing its rows in place.
+
+const size_t RECORDS_PER_TASK = 4096;
+
+// Bit i is set when p[i] == c
+static inline unsigned long long byte_mask(const char* p, size_t n, char c) {
+    unsigned long long mask = 0;
+#if defined(ATOMIX_X86_64)
+    if (n == 64) {
+        const __m128i needle = _mm_set1_epi8(c);
+        for (int k = 0; k < 4; ++k) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16 * k));
+            unsigned bits = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, needle)));
+            mask |= static_cast<unsigned long long>(bits) << (16 * k);
+        }
+        return mask;
+    }
+#endif
+    for (size_t i = 0; i < n; ++i) {
+        if (p[i] == c) mask |= 1ULL << i;
+    }
+    return mask;
+}
+
+// Bit i becomes the XOR of bits 0..i
+static inline unsigned long long prefix_xor(unsigned long long x) {
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+// Appends the offset of every '\n' outside quotes in data[from, end) to ends; in_quotes
+// holds the quote state at from on entry and at the end of data on return
+static void find_record_ends(std::string_view data, size_t from, char quote, unsigned long long& in_quotes,
+                             std::vector<size_t>& ends) {
+    for (size_t block = from; block < data.size(); block += 64) {
+        const char* p = data.data() + block;
+        size_t n = std::min<size_t>(64, data.size() - block);
+        unsigned long long quoted = prefix_xor(byte_mask(p, n, quote)) ^ in_quotes;
+        unsigned long long newlines = byte_mask(p, n, '\n') & ~quoted;
+        in_quotes = 0 - ((quoted >> (n - 1)) & 1);
+        while (newlines != 0) {
+            ends.push_back(block + lowest_set_bit64(newlines));
+            newlines &= newlines - 1;
+        }
+    }
+}
+
+struct RawField {
+    std::string_view text; // Between the quotes for a quoted field
+    bool escaped;          // Still holds "" pairs
+    bool malformed;        // Unterminated quote, text after the closing quote, or a quote in unquoted text
+};
+
+// Splits one record (without its newline) into fields
+static void split_record(std::string_view record, char delimiter, char quote, std::vector<RawField>& fields) {
+    fields.clear();
+    size_t pos = 0;
+    while (true) {
+        RawField field = {std::string_view(), false, false};
+        size_t next;
+        if (pos < record.size() && record[pos] == quote) {
+            size_t close = pos + 1;
+            while ((close = record.find(quote, close)) != std::string_view::npos &&
+                   close + 1 < record.size() && record[close + 1] == quote) {
+                field.escaped = true;
+                close += 2;
+            }
+            if (close == std::string_view::npos) {
+                close = record.size();
+                field.malformed = true;
+            }
+            field.text = record.substr(pos + 1, close - pos - 1);
+            next = record.find(delimiter, close + 1);
+            size_t field_end = (next == std::string_view::npos) ? record.size() : next;
+            field.malformed = field.malformed || field_end > close + 1;
+        } else {
+            next = record.find(delimiter, pos);
+            field.text = record.substr(pos, ((next == std::string_view::npos) ? record.size() : next) - pos);
+            field.malformed = field.text.find(quote) != std::string_view::npos; // The record scan took it as opening quotes
+        }
+        fields.push_back(field);
+        if (next == std::string_view::npos) break;
+        pos = next + 1;
+    }
+}
+
+// The field's value, with "" collapsed into scratch when needed
+static std::string_view field_value(const RawField& field, char quote, std::string& scratch) {
+    if (!field.escaped) return field.text;
+    scratch.clear();
+    for (size_t i = 0; i < field.text.size(); ++i) {
+        scratch += field.text[i];
+        if (field.text[i] == quote && i + 1 < field.text.size() && field.text[i + 1] == quote) ++i;
+    }
+    return scratch;
+}
+
+std::string_view ColumnTable::string_at(size_t column, size_t row) const {
+    const Column& col = columns_[column];
+    if (col.type != ColumnType::String || row >= rows_) return std::string_view();
+    return std::string_view(col.arena).substr(col.offsets[row], col.offsets[row + 1] - col.offsets[row]);
+}
+
+DelimitedReader::DelimitedReader(std::vector<ColumnType> schema, DelimitedOptions options)
+    : schema_(std::move(schema)), options_(options) {
+    if (options_.chunk_size < 64) options_.chunk_size = 64;
+}
+
+void DelimitedReader::reset(ColumnTable& table) const {
+    table.columns_.assign(schema_.size(), ColumnTable::Column());
+    for (size_t c = 0; c < schema_.size(); ++c) {
+        table.columns_[c].type = schema_[c];
+    }
+    table.rows_ = 0;
+    table.errors_.clear();
+}
+
+// Parses the complete records at the front of data and returns the bytes they span; in the
+// final chunk an unterminated last record counts as complete. The bytes past the returned
+// count are handed back at the front of the next chunk, and scan says how far they were scanned.
+size_t DelimitedReader::parse_chunk(std::string_view data, bool final_chunk, ColumnTable& table, bool& header_pending,
+                                    RecordScan& scan) const {
+    const size_t max_record = options_.max_record_size;
+    size_t start = 0;
+    if (scan.skipping) {
+        // The rest of a record past max_record_size: dropped up to its newline, quotes and all
+        size_t newline = data.find('\n');
+        if (newline == std::string_view::npos) return data.size();
+        scan.skipping = false;
+        start = newline + 1;
+        scan.scanned = start;
+        scan.in_quotes = 0;
+    }
+
+    std::vector<size_t> ends;
+    find_record_ends(data, scan.scanned, options_.quote, scan.in_quotes, ends);
+    size_t open = ends.empty() ? start : ends.back() + 1; // Start of the unfinished record
+    // A quote still open at the end of the input or past max_record_size was a stray one:
+    // its record ends at its own newline and the scan starts over after it
+    while (scan.in_quotes != 0 && (final_chunk || data.size() - open > max_record)) {
+        size_t newline = data.find('\n', open);
+        if (newline == std::string_view::npos) break;
+        ends.push_back(newline);
+        scan.in_quotes = 0;
+        find_record_ends(data, newline + 1, options_.quote, scan.in_quotes, ends);
+        open = ends.back() + 1;
+    }
+    size_t consumed = open;
+    if (open < data.size() && (final_chunk || data.size() - open > max_record)) {
+        // The last record, or one too long to wait for: it ends here, and a long one is dropped
+        // up to its newline in the chunks to come
+        scan.skipping = !final_chunk;
+        ends.push_back(data.size());
+        consumed = data.size();
+    }
+    scan.scanned = data.size() - consumed;
+
+    // Record spans without the newline or a trailing '\r'; blank lines are dropped
+    std::vector<std::pair<size_t, size_t>> records;
+    records.reserve(ends.size());
+    for (size_t end : ends) {
+        size_t stop = (end > start && data[end - 1] == '\r') ? end - 1 : end;
+        if (stop > start) records.emplace_back(start, stop - start);
+        start = end + 1;
+    }
+
+    const size_t columns = schema_.size();
+    const char quote = options_.quote;
+    std::vector<RawField> fields;
+    std::string scratch;
+    size_t first = 0;
+    if (header_pending && !records.empty()) {
+        header_pending = false;
+        split_record(data.substr(records[0].first, records[0].second), options_.delimiter, quote, fields);
+        for (size_t c = 0; c < columns && c < fields.size(); ++c) {
+            table.columns_[c].name = std::string(field_value(fields[c], quote, scratch));
+        }
+        first = 1;
+    }
+
+    const size_t count = records.size() - first;
+    const size_t base = table.rows_;
+    for (ColumnTable::Column& column : table.columns_) {
+        switch (column.type) {
+        case ColumnType::Int: column.ints.resize(base + count); break;
+        case ColumnType::Long: column.longs.resize(base + count); break;
+        case ColumnType::Float: column.floats.resize(base + count); break;
+        case ColumnType::Double: column.doubles.resize(base + count); break;
+        case ColumnType::String: break;
+        }
+    }
+
+    // Numbers are written in place; strings and errors are kept per run and appended in order
+    struct RunOutput {
+        std::vector<std::string> arenas;
+        std::vector<std::vector<size_t>> lengths;
+        std::vector<DelimitedError> errors;
+    };
+    const size_t runs = (count + RECORDS_PER_TASK - 1) / RECORDS_PER_TASK;
+    std::vector<RunOutput> outputs(runs);
+    run_parallel_tasks(runs, options_.num_threads, [&](size_t run) {
+        RunOutput& output = outputs[run];
+        output.arenas.resize(columns);
+        output.lengths.resize(columns);
+        std::vector<RawField> run_fields;
+        std::string run_scratch;
+        const size_t run_end = std::min(count, (run + 1) * RECORDS_PER_TASK);
+        for (size_t i = run * RECORDS_PER_TASK; i < run_end; ++i) {
+            const size_t row = base + i;
+            std::string_view record = data.substr(records[first + i].first, records[first + i].second);
+            const bool too_long = record.size() > max_record;
+            if (!too_long) split_record(record, options_.delimiter, quote, run_fields);
+            if (too_long || run_fields.size() != columns) {
+                output.errors.push_back(DelimitedError{row, std::string::npos, std::string(too_long ? record.substr(0, 64) : record)});
+                for (size_t c = 0; c < columns; ++c) {
+                    if (schema_[c] == ColumnType::String) output.lengths[c].push_back(0);
+                }
+                continue;
+            }
+            for (size_t c = 0; c < columns; ++c) {
+                ColumnTable::Column& column = table.columns_[c];
+                const RawField& field = run_fields[c];
+                std::string_view value = field_value(field, quote, run_scratch);
+                const char* readable_from = field.escaped ? run_scratch.data() : data.data();
+                bool ok = !field.malformed;
+                switch (column.type) {
+                case ColumnType::Int:
+                    ok = ok && parse_integer_field(value, column.ints[row], readable_from);
+                    if (!ok) column.ints[row] = 0;
+                    break;
+                case ColumnType::Long:
+                    ok = ok && parse_integer_field(value, column.longs[row], readable_from);
+                    if (!ok) column.longs[row] = 0;
+                    break;
+                case ColumnType::Float:
+                    ok = ok && parse_floating_field(value, column.floats[row]);
+                    if (!ok) column.floats[row] = 0.0f;
+                    break;
+                case ColumnType::Double:
+                    ok = ok && parse_floating_field(value, column.doubles[row]);
+                    if (!ok) column.doubles[row] = 0.0;
+                    break;
+                case ColumnType::String:
+                    output.arenas[c].append(value.data(), value.size());
+                    output.lengths[c].push_back(value.size());
+                    break;
+                }
+                if (!ok) output.errors.push_back(DelimitedError{row, c, std::string(value)});
+            }
+        }
+    });
+
+    for (size_t c = 0; c < columns; ++c) {
+        ColumnTable::Column& column = table.columns_[c];
+        if (column.type != ColumnType::String) continue;
+        for (RunOutput& output : outputs) {
+            column.arena += output.arenas[c];
+            for (size_t length : output.lengths[c]) {
+                column.offsets.push_back(column.offsets.back() + length);
+            }
+        }
+    }
+    for (RunOutput& output : outputs) {
+        table.errors_.insert(table.errors_.end(), output.errors.begin(), output.errors.end());
+    }
+    table.rows_ += count;
+    return consumed;
+}
+
+void DelimitedReader::read_buffer(std::string_view data, ColumnTable& table) const {
+    reset(table);
+    bool header_pending = options_.has_header;
+    RecordScan scan;
+    parse_chunk(data, true, table, header_pending, scan);
+}
+
+bool DelimitedReader::read_file(const std::string& path, ColumnTable& table) const {
+    reset(table);
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        std::cerr << "Error in DelimitedReader::read_file: cannot open '" << path << "'." << std::endl;
+        return false;
+    }
+    const size_t chunk_size = options_.chunk_size;
+    std::vector<char> buffer;
+    size_t carried = 0; // Bytes of an unfinished record moved to the front of the buffer
+    bool header_pending = options_.has_header;
+    RecordScan scan;
+    bool ok = true;
+    while (true) {
+        buffer.resize(carried + chunk_size); // carried stays within max_record_size
+        size_t got = std::fread(buffer.data() + carried, 1, chunk_size, file);
+        if (got < chunk_size && std::ferror(file)) {
+            std::cerr << "Error in DelimitedReader::read_file: read failed on '" << path << "'." << std::endl;
+            ok = false;
+            break;
+        }
+        const size_t filled = carried + got;
+        const bool final_chunk = got < chunk_size;
+        size_t consumed = parse_chunk(std::string_view(buffer.data(), filled), final_chunk, table, header_pending, scan);
+        if (final_chunk) break;
+        carried = filled - consumed;
+        std::memmove(buffer.data(), buffer.data() + consumed, carried);
+    }
+    std::fclose(file);
+    return ok;
+}
+
+// --- Zero-Copy String Splitting ---
+
+ByteSet::ByteSet(std::string_view chars)
+    : bits_{0, 0, 0, 0}, lo_nibbles_{}, hi_nibbles_{}, count_(0), single_(0), nibble_lookup_(false) {
+    for (char ch : chars) {
+        unsigned char c = static_cast<unsigned char>(ch);
+        if (!contains(c)) {
+            bits_[c >> 6] |= 1ULL << (c & 63);
+            ++count_;
+            single_ = c;
+        }
+    }
+
+    // One lookup bit per distinct high nibble keeps the nibble match exact:
+    // hi[h] names the class, lo[l] lists the classes that contain (h, l).
+    unsigned char class_bit[16] = {};
+    unsigned int classes = 0;
+    for (unsigned int c = 0; c < 256; ++c) {
+        if (!contains(static_cast<unsigned char>(c))) continue;
+        unsigned int h = c >> 4;
+        if (class_bit[h] == 0) {
+            if (classes == 8) {
+                return; // More than 8 high nibbles: use the bitmap scan
+            }
+            class_bit[h] = static_cast<unsigned char>(1u << classes++);
+        }
+        hi_nibbles_[h] = class_bit[h];
+        lo_nibbles_[c & 15] |= class_bit[h];
+    }
+    nibble_lookup_ = true;
+}
+
+size_t ByteSet::find_first_in(std::string_view str, size_t start_pos) const {
+    if (start_pos >= str.size() || count_ == 0) {
+        return std::string_view::npos;
+    }
+    const char *p = str.data() + start_pos;
+    const size_t n = str.size() - start_pos;
+    size_t hit;
+    if (count_ == 1) {
+        hit = simd_find_byte(p, n, static_cast<char>(single_));
+    } else if (nibble_lookup_) {
+        hit = simd_find_in_set(lo_nibbles_, hi_nibbles_, p, n);
+    } else {
+        hit = SCAN_NPOS;
+        for (size_t i = 0; i < n; ++i) {
+            if (contains(static_cast<unsigned char>(p[i]))) {
+                hit = i;
+                break;
+            }
+        }
+    }
+    return (hit == SCAN_NPOS) ? std::string_view::npos : start_pos + hit;
+}
+
+void StringSplitRange::iterator::advance() {
+    const std::string_view str = range_->str_;
+    while (true) {
+        if (next_ == std::string_view::npos) {
+            done_ = true; // Past the last token
+            token_ = std::string_view();
+            return;
+        }
+        size_t delim = range_->delimiters_.find_first_in(str, next_);
+        size_t token_end = (delim == std::string_view::npos) ? str.size() : delim;
+        token_ = str.substr(next_, token_end - next_);
+        next_ = (delim == std::string_view::npos) ? std::string_view::npos : delim + 1;
+        if (!(range_->skip_empty_ && token_.empty())) {
+            return;
+        }
+    }
+}
+
+StringSplitRange string_split_range(std::string_view str, char delimiter, bool skip_empty) {
+    return StringSplitRange(str, std::string_view(&delimiter, 1), skip_empty);
+}
+
+StringSplitRange string_split_range(std::string_view str, std::string_view delimiters, bool skip_empty) {
+    return StringSplitRange(str, delimiters, skip_empty);
+}
+
+std::vector<std::string_view> string_split_view(std::string_view str, char delimiter, bool skip_empty) {
+    std::vector<std::string_view> tokens;
+    for (std::string_view token : string_split_range(str, delimiter, skip_empty)) {
+        tokens.push_back(token);
+    }
+    return tokens;
+}
+
+std::vector<std::string_view> string_split_view(std::string_view str, std::string_view delimiters, bool skip_empty) {
+    std::vector<std::string_view> tokens;
+    for (std::string_view token : string_split_range(str, delimiters, skip_empty)) {
+        tokens.push_back(token);
+    }
+    return tokens;
+}
+
+std::string string_join(const std::vector<std::string>& parts, const std::string& separator) {
+    return string_join_range(parts, separator); // Sized up front: one allocation
+}
+
+bool string_starts_with(const std::string& str, const std::string& prefix) {
+    // C++20 has str.starts_with()
+    // Pre-C++20 implementation:
+    return str.rfind(prefix, 0) == 0;
+    // Or: return str.size() >= prefix.size() && str.compare(0, prefix.size(), prefix) == 0;
+}
+
+bool string_ends_with(const std::string& str, const std::string& suffix) {
+    // C++20 has str.ends_with()
+    // Pre-C++20 implementation:
+     if (suffix.size() > str.size()) return false;
+     return std::equal(suffix.rbegin(), suffix.rend(), str.rbegin());
+    // Or: return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+bool string_to_int(std::string_view str, int* out_val) {
+    if (out_val == nullptr) return false;
+    return parse_integer(str, *out_val) == NumberStatus::Ok; // out_val is untouched on failure
+}
+
+bool string_to_long(std::string_view str, long* out_val) {
+    if (out_val == nullptr) return false;
+    return parse_integer(str, *out_val) == NumberStatus::Ok;
+}
+
+bool string_to_float(std::string_view str, float* out_val) {
+    if (out_val == nullptr) return false;
+    NumberStatus status = parse_floating(str, *out_val);
+    if (status == NumberStatus::Underflow) {
+        *out_val = 0.0f; // Too small for float: accepted as zero
+        return true;
+    }
+    return status == NumberStatus::Ok; // Overflow, NaN and malformed input fail
+}
+
+bool string_to_double(std::string_view str, double* out_val) {
+    if (out_val == nullptr) return false;
+    NumberStatus status = parse_floating(str, *out_val);
+    if (status == NumberStatus::Underflow) {
+        *out_val = 0.0;
+        return true;
+    }
+    return status == NumberStatus::Ok;
+}
+
+
+// --- Memory Management Helpers ---
+// ... (free_string, free_string_array remain the same) ...
+void free_string(char* str) {
+    // Assumes str was allocated with malloc/calloc/strdup
+    std::free(str);
+}
+
+void free_string_array(char** arr, size_t size) {
+    // Assumes arr was allocated with malloc/calloc, and each arr[i] with malloc/calloc/strdup
+    if (arr == nullptr) {
+        return;
+    }
+    for (size_t i = 0; i < size; ++i) {
+        std::free(arr[i]); // Free each individual string
+    }
+    std::free(arr); // Free the array of pointers
+}
+
+// --- Utility Functions ---
+// ... (initialize_random, get_random_int, get_random_float, get_random_double, start_timer, stop_timer remain the same) ...
+void initialize_random() {
+    std::random_device rd; // Obtain a random number from hardware entropy source
+    global_random_engine.seed((static_cast<unsigned long long>(rd()) << 32) | rd()); // Seed the Mersenne Twister engine
+    random_initialized = true;
+}
+
+void seed_random(unsigned long long seed) {
+    global_random_engine.seed(seed); // Fixed seed: identical sequences on every run
+    random_initialized = true;
+}
+
+int get_random_int(int min_val, int max_val) {
+    if (!random_initialized) {
+        initialize_random();
+    }
+    if (min_val > max_val) {
+        std::swap(min_val, max_val); // Handle incorrect order
+    }
+    std::uniform_int_distribution<int> distrib(min_val, max_val);
+    return distrib(global_random_engine);
+}
+
+float get_random_float(float min_val, float max_val) {
+     if (!random_initialized) {
+        initialize_random();
+    }
+     if (min_val > max_val) {
+        std::swap(min_val, max_val);
+    }
+    // Inclusive range for real distribution
+    std::uniform_real_distribution<float> distrib(min_val, std::nextafter(max_val, std::numeric_limits<float>::infinity()));
+    return distrib(global_random_engine);
+}
+
+double get_random_double(double min_val, double max_val) {
+    if (!random_initialized) {
+        initialize_random();
+    }
+     if (min_val > max_val) {
+        std::swap(min_val, max_val);
+    }
+    std::uniform_real_distribution<double> distrib(min_val, std::nextafter(max_val, std::numeric_limits<double>::infinity()));
+    return distrib(global_random_engine);
+}
+
+std::chrono::steady_clock::time_point start_timer() {
+    return std::chrono::steady_clock::now();
+}
+
+double stop_timer(std::chrono::steady_clock::time_point start_time) {
+    auto end_time = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed = end_time - start_time;
+    return elapsed.count(); // Return duration in seconds
+}
+
+// --- Cycle Timer ---
+// lfence waits for every earlier instruction to finish before the counter is read; rdtscp
+// does the same for the stop read, and the lfence after it keeps later work out of the
+// region. Calibration pairs a TSC read with a steady_clock read at static initialization and
+// again at the first conversion (at least 10 ms later), so usually no time is spent waiting.
+
+#if defined(ATOMIX_X86_64)
+static bool detect_invariant_tsc() {
+    unsigned int max_extended = 0;
+    unsigned int power_edx = 0;
+    unsigned int features_edx = 0;
+#if defined(_MSC_VER) && !defined(__clang__)
+    int regs[4];
+    __cpuid(regs, 0x80000000);
+    max_extended = static_cast<unsigned int>(regs[0]);
+    if (max_extended >= 0x80000007) {
+        __cpuid(regs, 0x80000001);
+        features_edx = static_cast<unsigned int>(regs[3]);
+        __cpuid(regs, 0x80000007);
+        power_edx = static_cast<unsigned int>(regs[3]);
+    }
+#else
+    unsigned int eax = 0, ebx = 0, ecx = 0;
+    max_extended = __get_cpuid_max(0x80000000, nullptr);
+    if (max_extended >= 0x80000007) {
+        __get_cpuid(0x80000001, &eax, &ebx, &ecx, &features_edx);
+        __get_cpuid(0x80000007, &eax, &ebx, &ecx, &power_edx);
+    }
+#endif
+    return (power_edx & (1u << 8)) != 0 && (features_edx & (1u << 27)) != 0; // Invariant TSC, and RDTSCP
+}
+#endif
+
+struct CycleClock {
+    bool tsc = false;
+    std::chrono::steady_clock::time_point start_time;
+    unsigned long long start_ticks = 0;
+};
+
+static unsigned long long steady_ticks() {
+    return static_cast<unsigned long long>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+static const CycleClock& cycle_clock() {
+    static const CycleClock clock = [] {
+        CycleClock c;
+#if defined(ATOMIX_X86_64)
+        c.tsc = detect_invariant_tsc();
+#endif
+        c.start_time = std::chrono::steady_clock::now();
+#if defined(ATOMIX_X86_64)
+        if (c.tsc) c.start_ticks = __rdtsc();
+#endif
+        return c;
+    }();
+    return clock;
+}
+
+static const bool cycle_clock_started = cycle_clock().tsc; // Starts the calibration window at program start
+
+unsigned long long start_cycles() {
+#if defined(ATOMIX_X86_64)
+    if (cycle_clock().tsc) {
+        _mm_lfence();
+        unsigned long long ticks = __rdtsc();
+        _mm_lfence();
+        return ticks;
+    }
+#endif
+    return steady_ticks();
+}
+
+unsigned long long stop_cycles() {
+#if defined(ATOMIX_X86_64)
+    if (cycle_clock().tsc) {
+        unsigned int aux;
+        unsigned long long ticks = __rdtscp(&aux);
+        _mm_lfence();
+        return ticks;
+    }
+#endif
+    return steady_ticks();
+}
+
+double cycles_per_ns() {
+    static const double rate = [] {
+        const CycleClock& c = cycle_clock();
+        if (!c.tsc) return 1.0;
+        std::chrono::steady_clock::time_point now;
+        unsigned long long ticks = 0;
+        do {
+            now = std::chrono::steady_clock::now();
+#if defined(ATOMIX_X86_64)
+            ticks = __rdtsc();
+#endif
+        } while (now - c.start_time < std::chrono::milliseconds(10));
+        double ns = std::chrono::duration<double, std::nano>(now - c.start_time).count();
+        return static_cast<double>(ticks - c.start_ticks) / ns;
+    }();
+    return rate;
+}
+
+double cycles_to_ns(unsigned long long cycles) {
+    return static_cast<double>(cycles) / cycles_per_ns();
+}
+
+bool cycle_timer_uses_tsc() {
+    return cycle_clock().tsc;
+}
+
+// --- Hardware Performance Counters ---
+// The first counter that opens leads the group and the rest join it, so one ioctl starts
+// or stops them all and one read() returns every value with the group's enabled and
+// running times. Counters that fail to open are skipped rather than failing the group.
+
+static double PerfCounts::* const PERF_FIELDS[] = {
+    &PerfCounts::cycles, &PerfCounts::instructions, &PerfCounts::l1d_misses,
+    &PerfCounts::llc_misses, &PerfCounts::branch_misses, &PerfCounts::page_faults,
+};
+static const char* const PERF_FIELD_NAMES[] = { // Benchmark JSON keys, per iteration
+    "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses", "page_faults",
+};
+
+PerfCounts PerfCounts::per_operation(double operations) const {
+    PerfCounts result = *this;
+    if (operations <= 0.0) return result;
+    for (double PerfCounts::* field : PERF_FIELDS) {
+        if (result.*field >= 0.0) result.*field /= operations;
+    }
+    return result;
+}
+
+double PerfCounts::ipc() const {
+    return (cycles > 0.0 && instructions >= 0.0) ? instructions / cycles : -1.0;
+}
+
+PerfCounterGroup::PerfCounterGroup() {
+#if defined(ATOMIX_PERF_EVENTS)
+    struct EventSpec {
+        unsigned int type;
+        unsigned long long config;
+    };
+    const unsigned long long l1d_read_miss = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                             (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    const EventSpec specs[MAX_COUNTERS] = { // In PERF_FIELDS order
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {PERF_TYPE_HW_CACHE, l1d_read_miss},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+        {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+    };
+    for (int i = 0; i < MAX_COUNTERS; ++i) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = specs[i].type;
+        attr.config = specs[i].config;
+        attr.disabled = (count_ == 0) ? 1 : 0; // Members follow the leader's enable state
+        attr.exclude_kernel = 1;               // Allowed at perf_event_paranoid 2, the usual default
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        int group = (count_ == 0) ? -1 : fds_[0];
+        int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group, PERF_FLAG_FD_CLOEXEC));
+        if (fd < 0) continue;
+        fds_[count_] = fd;
+        fields_[count_] = i;
+        ++count_;
+        if (specs[i].type != PERF_TYPE_SOFTWARE) hardware_ = true;
+    }
+#endif
+}
+
+PerfCounterGroup::~PerfCounterGroup() {
+#if defined(ATOMIX_PERF_EVENTS)
+    for (int i = 0; i < count_; ++i) {
+        ::close(fds_[i]);
+    }
+#endif
+}
+
+void PerfCounterGroup::start() {
+#if defined(ATOMIX_PERF_EVENTS)
+    if (count_ == 0) return;
+    ioctl(fds_[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(fds_[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+}
+
+PerfCounts PerfCounterGroup::stop() {
+    PerfCounts counts;
+#if defined(ATOMIX_PERF_EVENTS)
+    if (count_ == 0) return counts;
+    ioctl(fds_[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    unsigned long long data[3 + MAX_COUNTERS]; // nr, time enabled, time running, then the values
+    ssize_t got = ::read(fds_[0], data, sizeof(data));
+    if (got < static_cast<ssize_t>(3 * sizeof(unsigned long long)) || data[0] != static_cast<unsigned long long>(count_)) {
+        return counts;
+    }
+    if (data[2] == 0) return counts; // The group never got onto the PMU
+    double scale = static_cast<double>(data[1]) / static_cast<double>(data[2]);
+    for (int i = 0; i < count_; ++i) {
+        counts.*PERF_FIELDS[fields_[i]] = static_cast<double>(data[3 + i]) * scale;
+    }
+#endif
+    return counts;
+}
+
+// --- Allocation Tracking ---
+// The totals are a plain thread_local struct: constant-initialized, so touching it from
+// operator new needs no TLS guard and cannot recurse, and no other thread ever writes it.
+
+static thread_local AllocationStats thread_allocations;
+
+#if defined(ATOMIX_TRACK_ALLOCATIONS)
+static void* counted_malloc(size_t size) {
+    ++thread_allocations.allocations;
+    thread_allocations.bytes += size;
+    return std::malloc(size != 0 ? size : 1);
+}
+
+static void* counted_aligned_malloc(size_t size, size_t alignment) {
+    ++thread_allocations.allocations;
+    thread_allocations.bytes += size;
+    if (size == 0) size = 1;
+#if defined(_MSC_VER)
+    return _aligned_malloc(size, alignment);
+#else
+    void* p = nullptr;
+    if (alignment < sizeof(void*)) alignment = sizeof(void*);
+    return (posix_memalign(&p, alignment, size) == 0) ? p : nullptr;
+#endif
+}
+
+static void counted_free(void* p) {
+    if (p == nullptr) return;
+    ++thread_allocations.deallocations;
+    std::free(p);
+}
+
+static void counted_aligned_free(void* p) {
+    if (p == nullptr) return;
+    ++thread_allocations.deallocations;
+#if defined(_MSC_VER)
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+void* operator new(size_t size) {
+    void* p = counted_malloc(size);
+    if (p == nullptr) throw std::bad_alloc();
+    return p;
+}
+void* operator new[](size_t size) { return operator new(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return counted_malloc(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return counted_malloc(size); }
+void* operator new(size_t size, std::align_val_t alignment) {
+    void* p = counted_aligned_malloc(size, static_cast<size_t>(alignment));
+    if (p == nullptr) throw std::bad_alloc();
+    return p;
+}
+void* operator new[](size_t size, std::align_val_t alignment) { return operator new(size, alignment); }
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return counted_aligned_malloc(size, static_cast<size_t>(alignment));
+}
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return counted_aligned_malloc(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* p) noexcept { counted_free(p); }
+void operator delete[](void* p) noexcept { counted_free(p); }
+void operator delete(void* p, size_t) noexcept { counted_free(p); }
+void operator delete[](void* p, size_t) noexcept { counted_free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { counted_free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { counted_free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { counted_aligned_free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { counted_aligned_free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { counted_aligned_free(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { counted_aligned_free(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { counted_aligned_free(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { counted_aligned_free(p); }
+#endif
+
+bool allocation_tracking_enabled() {
+#if defined(ATOMIX_TRACK_ALLOCATIONS)
+    return true;
+#else
+    return false;
+#endif
+}
+
+AllocationStats thread_allocation_stats() {
+    return thread_allocations;
+}
+
+AllocationStats AllocationScope::stats() const {
+    AllocationStats now = thread_allocations;
+    AllocationStats delta;
+    delta.allocations = now.allocations - start_.allocations;
+    delta.deallocations = now.deallocations - start_.deallocations;
+    delta.bytes = now.bytes - start_.bytes;
+    return delta;
+}
+
+CountingResource::CountingResource(std::pmr::memory_resource* upstream)
+    : upstream_(upstream != nullptr ? upstream : std::pmr::get_default_resource()) {}
+
+AllocationStats CountingResource::stats() const {
+    AllocationStats s;
+    s.allocations = allocations_.load(std::memory_order_relaxed);
+    s.deallocations = deallocations_.load(std::memory_order_relaxed);
+    s.bytes = bytes_.load(std::memory_order_relaxed);
+    return s;
+}
+
+void CountingResource::reset() {
+    allocations_.store(0, std::memory_order_relaxed);
+    deallocations_.store(0, std::memory_order_relaxed);
+    bytes_.store(0, std::memory_order_relaxed);
+}
+
+void* CountingResource::do_allocate(size_t bytes, size_t alignment) {
+    void* p = upstream_->allocate(bytes, alignment); // Throws before counting on failure
+    allocations_.fetch_add(1, std::memory_order_relaxed);
+    bytes_.fetch_add(bytes, std::memory_order_relaxed);
+    return p;
+}
+
+void CountingResource::do_deallocate(void* p, size_t bytes, size_t alignment) {
+    deallocations_.fetch_add(1, std::memory_order_relaxed);
+    upstream_->deallocate(p, bytes, alignment);
+}
+
+bool CountingResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+// --- Microbenchmarks ---
+// A run grows the iterations per sample until one sample takes min_sample_seconds, so the
+// clock's resolution and the call through batch() vanish in the total, then takes the
+// samples. Samples outside Tukey's fences (quartiles +/- outlier_iqr * IQR) are dropped
+// before the statistics: they are interrupts and migrations, not the code under test.
+
+#if !defined(__GNUC__) && !defined(__clang__)
+void benchmark_escape(const void* p) {
+    static const void* volatile sink = nullptr;
+    sink = p;
+}
+#endif
+
+// Linear interpolation between the closest ranks of sorted values
+static double sorted_percentile(const std::vector<double>& sorted, double fraction) {
+    if (sorted.empty()) return 0.0;
+    double rank = fraction * static_cast<double>(sorted.size() - 1);
+    size_t below = static_cast<size_t>(rank);
+    if (below + 1 >= sorted.size()) return sorted.back();
+    return sorted[below] + (rank - static_cast<double>(below)) * (sorted[below + 1] - sorted[below]);
+}
+
+BenchmarkRunner::BenchmarkRunner(BenchmarkOptions options) : options_(options) {
+    if (options_.samples == 0) options_.samples = 1;
+}
+
+BenchmarkResult BenchmarkRunner::run_batches(const std::string& name, void (*batch)(void*, size_t), void* context,
+                                             double items, double bytes) {
+    using Clock = std::chrono::steady_clock;
+    auto time_batch = [&](size_t iterations) {
+        Clock::time_point start = Clock::now();
+        batch(context, iterations);
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    };
+
+    // Warm up, then scale: aim 20% past the target so the next try usually lands
+    Clock::time_point warmup_end = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(options_.warmup_seconds));
+    do {
+        time_batch(1);
+    } while (Clock::now() < warmup_end);
+    size_t iterations = 1;
+    const size_t max_iterations = size_t(1) << 40;
+    for (;;) {
+        double seconds = time_batch(iterations);
+        if (seconds >= options_.min_sample_seconds || iterations >= max_iterations) break;
+        double scale = (seconds > 0.0) ? 1.2 * options_.min_sample_seconds / seconds : 100.0;
+        scale = std::min(std::max(scale, 2.0), 100.0);
+        iterations = std::min(max_iterations, static_cast<size_t>(static_cast<double>(iterations) * scale));
+    }
+
+    std::vector<double> per_iteration;
+    per_iteration.reserve(options_.samples);
+    Clock::time_point give_up = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(options_.max_seconds));
+    std::unique_ptr<PerfCounterGroup> counters;
+    if (options_.perf_counters) {
+        counters.reset(new PerfCounterGroup);
+        counters->start();
+    }
+    AllocationScope allocations; // Only the samples: warm-up and calibration may fill caches
+    for (size_t s = 0; s < options_.samples; ++s) {
+        per_iteration.push_back(time_batch(iterations) * 1e9 / static_cast<double>(iterations));
+        if (s >= 2 && Clock::now() > give_up) break;
+    }
+    PerfCounts counted = counters ? counters->stop() : PerfCounts();
+    AllocationStats allocated = allocations.stats();
+    std::sort(per_iteration.begin(), per_iteration.end());
+
+    BenchmarkResult result;
+    result.name = name;
+    result.iterations = iterations;
+    double total_iterations = static_cast<double>(iterations * per_iteration.size());
+    result.counters = counted.per_operation(total_iterations);
+    if (allocation_tracking_enabled()) {
+        result.allocations = static_cast<double>(allocated.allocations) / total_iterations;
+        result.allocated_bytes = static_cast<double>(allocated.bytes) / total_iterations;
+    }
+    std::vector<double> kept = per_iteration;
+    if (options_.outlier_iqr > 0.0 && per_iteration.size() >= 4) {
+        double q1 = sorted_percentile(per_iteration, 0.25);
+        double q3 = sorted_percentile(per_iteration, 0.75);
+        double low = q1 - options_.outlier_iqr * (q3 - q1);
+        double high = q3 + options_.outlier_iqr * (q3 - q1);
+        kept.clear();
+        for (double ns : per_iteration) {
+            if (ns >= low && ns <= high) kept.push_back(ns);
+        }
+    }
+    result.samples = kept.size();
+    result.outliers = per_iteration.size() - kept.size();
+    result.min_ns = kept.front();
+    result.max_ns = kept.back();
+    result.median_ns = sorted_percentile(kept, 0.5);
+    result.p99_ns = sorted_percentile(kept, 0.99);
+    result.mean_ns = std::accumulate(kept.begin(), kept.end(), 0.0) / static_cast<double>(kept.size());
+    if (result.median_ns > 0.0) {
+        result.items_per_second = items * 1e9 / result.median_ns;
+        result.bytes_per_second = bytes * 1e9 / result.median_ns;
+    }
+    results_.push_back(result);
+    return result;
+}
+
+static void append_json_string(std::string& out, std::string_view text) {
+    out += '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escape[8];
+            std::snprintf(escape, sizeof(escape), "\\u%04x", static_cast<unsigned>(c));
+            out += escape;
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+static void append_json_number(std::string& out, const char* key, double value) {
+    char buffer[64];
+    std::snprintf(buffer, sizeof(buffer), ", \"%s\": %.17g", key, std::isfinite(value) ? value : 0.0);
+    out += buffer;
+}
+
+std::string BenchmarkRunner::to_json() const {
+    std::string out = "{\n  \"benchmarks\": [";
+    for (size_t i = 0; i < results_.size(); ++i) {
+        const BenchmarkResult& r = results_[i];
+        out += (i == 0) ? "\n    {\"name\": " : ",\n    {\"name\": ";
+        append_json_string(out, r.name);
+        append_json_number(out, "iterations", static_cast<double>(r.iterations));
+        append_json_number(out, "samples", static_cast<double>(r.samples));
+        append_json_number(out, "outliers", static_cast<double>(r.outliers));
+        append_json_number(out, "min_ns", r.min_ns);
+        append_json_number(out, "median_ns", r.median_ns);
+        append_json_number(out, "mean_ns", r.mean_ns);
+        append_json_number(out, "p99_ns", r.p99_ns);
+        append_json_number(out, "max_ns", r.max_ns);
+        append_json_number(out, "items_per_second", r.items_per_second);
+        append_json_number(out, "bytes_per_second", r.bytes_per_second);
+        for (size_t f = 0; f < sizeof(PERF_FIELDS) / sizeof(PERF_FIELDS[0]); ++f) {
+            if (r.counters.*PERF_FIELDS[f] >= 0.0) append_json_number(out, PERF_FIELD_NAMES[f], r.counters.*PERF_FIELDS[f]);
+        }
+        if (r.allocations >= 0.0) {
+            append_json_number(out, "allocations", r.allocations);
+            append_json_number(out, "allocated_bytes", r.allocated_bytes);
+        }
+        out += '}';
+    }
+    out += "\n  ]\n}\n";
+    return out;
+}
+
+bool BenchmarkRunner::write_json(const std::string& path) const {
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        std::cerr << "Error in BenchmarkRunner::write_json: cannot open '" << path << "'." << std::endl;
+        return false;
+    }
+    std::string json = to_json();
+    bool ok = std::fwrite(json.data(), 1, json.size(), file) == json.size();
+    ok = (std::fclose(file) == 0) && ok;
+    if (!ok) {
+        std::cerr << "Error in BenchmarkRunner::write_json: cannot write '" << path << "'." << std::endl;
+    }
+    return ok;
+}
+
+void print_benchmark_result(const BenchmarkResult& result) {
+    char line[256];
+    std::snprintf(line, sizeof(line), "%-48s %12.1f ns %12.1f ns %12.1f ns", result.name.c_str(),
+                  result.min_ns, result.median_ns, result.p99_ns);
+    std::cout << line;
+    if (result.items_per_second > 0.0) {
+        std::snprintf(line, sizeof(line), " %10.2f M items/s", result.items_per_second / 1e6);
+        std::cout << line;
+    }
+    if (result.bytes_per_second > 0.0) {
+        std::snprintf(line, sizeof(line), " %10.2f MB/s", result.bytes_per_second / 1e6);
+        std::cout << line;
+    }
+    std::cout << std::endl;
+    const PerfCounts& c = result.counters;
+    std::string counts;
+    static const char* const labels[] = {"cycles", "instructions", "L1D misses", "LLC misses", "branch misses", "page faults"};
+    for (size_t f = 0; f < sizeof(PERF_FIELDS) / sizeof(PERF_FIELDS[0]); ++f) {
+        if (c.*PERF_FIELDS[f] < 0.0) continue;
+        std::snprintf(line, sizeof(line), "%s%.2f %s", counts.empty() ? "" : ", ", c.*PERF_FIELDS[f], labels[f]);
+        counts += line;
+        if (f == 1 && c.ipc() >= 0.0) {
+            std::snprintf(line, sizeof(line), " (%.2f IPC)", c.ipc());
+            counts += line;
+        }
+    }
+    if (result.allocations >= 0.0) {
+        std::snprintf(line, sizeof(line), "%s%.2f allocations (%.0f bytes)", counts.empty() ? "" : ", ",
+                      result.allocations, result.allocated_bytes);
+        counts += line;
+    }
+    if (!counts.empty()) std::cout << "    per call: " << counts << std::endl;
+}
+
+// A small reader for the JSON that to_json() writes: one flat object per benchmark with a
+// string name and numeric fields. Unknown keys are skipped, so files from newer versions load.
+namespace {
+struct JsonCursor {
+    std::string_view text;
+    size_t pos = 0;
+
+    void skip_space() {
+        while (pos < text.size() && is_space_byte(text[pos])) ++pos;
+    }
+    bool consume(char c) {
+        skip_space();
+        if (pos < text.size() && text[pos] == c) {
+            ++pos;
+            return true;
+        }
+        return false;
+    }
+    bool read_string(std::string& out) {
+        out.clear();
+        if (!consume('"')) return false;
+        while (pos < text.size() && text[pos] != '"') {
+            char c = text[pos++];
+            if (c == '\\' && pos < text.size()) {
+                char e = text[pos++];
+                if (e == 'u' && pos + 4 <= text.size()) {
+                    unsigned code = 0;
+                    std::from_chars(text.data() + pos, text.data() + pos + 4, code, 16);
+                    pos += 4;
+                    c = static_cast<char>(code); // Only control bytes are written as \u escapes
+                } else {
+                    c = (e == 'n') ? '\n' : (e == 't') ? '\t' : (e == 'r') ? '\r' : e;
+                }
+            }
+            out += c;
+        }
+        return consume('"');
+    }
+    bool read_number(double& out) {
+        skip_space();
+        size_t end = pos;
+        while (end < text.size() && std::strchr("+-.0123456789eE", text[end]) != nullptr) ++end;
+        if (parse_floating(text.substr(pos, end - pos), out) != NumberStatus::Ok) return false;
+        pos = end;
+        return true;
+    }
+};
+} // namespace
+
+bool parse_benchmark_json(std::string_view json, std::vector<BenchmarkResult>& out) {
+    out.clear();
+    JsonCursor cursor{json};
+    std::string key;
+    if (!cursor.consume('{') || !cursor.read_string(key) || key != "benchmarks" || !cursor.consume(':') ||
+        !cursor.consume('[')) {
+        std::cerr << "Error in parse_benchmark_json: expected {\"benchmarks\": [...]}." << std::endl;
+        return false;
+    }
+    if (cursor.consume(']')) return true;
+    do {
+        if (!cursor.consume('{')) break;
+        BenchmarkResult r;
+        bool ok = true;
+        do {
+            if (!cursor.read_string(key) || !cursor.consume(':')) {
+                ok = false;
+                break;
+            }
+            if (key == "name") {
+                ok = cursor.read_string(r.name);
+                continue;
+            }
+            double value = 0.0;
+            if (!cursor.read_number(value)) {
+                ok = false;
+                break;
+            }
+            if (key == "iterations") r.iterations = static_cast<size_t>(value);
+            else if (key == "samples") r.samples = static_cast<size_t>(value);
+            else if (key == "outliers") r.outliers = static_cast<size_t>(value);
+            else if (key == "min_ns") r.min_ns = value;
+            else if (key == "median_ns") r.median_ns = value;
+            else if (key == "mean_ns") r.mean_ns = value;
+            else if (key == "p99_ns") r.p99_ns = value;
+            else if (key == "max_ns") r.max_ns = value;
+            else if (key == "items_per_second") r.items_per_second = value;
+            else if (key == "bytes_per_second") r.bytes_per_second = value;
+            else if (key == "allocations") r.allocations = value;
+            else if (key == "allocated_bytes") r.allocated_bytes = value;
+            for (size_t f = 0; f < sizeof(PERF_FIELDS) / sizeof(PERF_FIELDS[0]); ++f) {
+                if (key == PERF_FIELD_NAMES[f]) r.counters.*PERF_FIELDS[f] = value;
+            }
+        } while (ok && cursor.consume(','));
+        if (!ok || !cursor.consume('}')) {
+            std::cerr << "Error in parse_benchmark_json: malformed entry at offset " << cursor.pos << "." << std::endl;
+            return false;
+        }
+        out.push_back(std::move(r));
+    } while (cursor.consume(','));
+    if (!cursor.consume(']')) {
+        std::cerr << "Error in parse_benchmark_json: malformed list at offset " << cursor.pos << "." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool read_benchmark_json(const std::string& path, std::vector<BenchmarkResult>& out) {
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        std::cerr << "Error in read_benchmark_json: cannot open '" << path << "'." << std::endl;
+        return false;
+    }
+    std::string json;
+    char buffer[65536];
+    size_t got;
+    while ((got = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        json.append(buffer, got);
+    }
+    std::fclose(file);
+    return parse_benchmark_json(json, out);
+}
+
+std::vector<BenchmarkComparison> compare_benchmarks(const std::vector<BenchmarkResult>& baseline,
+                                                    const std::vector<BenchmarkResult>& current) {
+    std::vector<BenchmarkComparison> comparisons;
+    std::vector<bool> matched(current.size(), false);
+    for (const BenchmarkResult& base : baseline) {
+        BenchmarkComparison c;
+        c.name = base.name;
+        c.baseline_ns = base.median_ns;
+        c.baseline_allocations = base.allocations;
+        for (size_t i = 0; i < current.size(); ++i) {
+            if (!matched[i] && current[i].name == base.name) {
+                matched[i] = true;
+                c.current_ns = current[i].median_ns;
+                c.current_allocations = current[i].allocations;
+                break;
+            }
+        }
+        if (c.baseline_ns > 0.0 && c.current_ns > 0.0) c.change = c.current_ns / c.baseline_ns - 1.0;
+        comparisons.push_back(c);
+    }
+    for (size_t i = 0; i < current.size(); ++i) {
+        if (matched[i]) continue;
+        BenchmarkComparison c;
+        c.name = current[i].name;
+        c.current_ns = current[i].median_ns;
+        c.current_allocations = current[i].allocations;
+        comparisons.push_back(c);
+    }
+    return comparisons;
+}
+
+// --- Latency Histograms ---
+// Slot layout as in HdrHistogram: the first bucket counts 0 .. 2^m - 1 one by one (2^m being
+// the smallest power of two above 2 * 10^digits), and each further bucket covers twice the
+// range of the one before with 2^(m-1) slots, so every slot is within 10^-digits of the
+// values it counts. A value's slot comes from its highest set bit and a shift.
+
+static inline unsigned highest_set_bit64(unsigned long long mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanReverse64(&index, mask);
+    return static_cast<unsigned>(index);
+#else
+    return 63u - static_cast<unsigned>(__builtin_clzll(mask));
+#endif
+}
+
+HistogramLayout::HistogramLayout(unsigned long long highest_value, int digits)
+    : highest(std::max<unsigned long long>(highest_value, 2)), significant_digits(std::min(std::max(digits, 1), 5)) {
+    unsigned long long largest_single_unit = 2;
+    for (int i = 0; i < significant_digits; ++i) largest_single_unit *= 10;
+    int magnitude = static_cast<int>(highest_set_bit64(largest_single_unit - 1)) + 1; // ceil(log2)
+    sub_bucket_half_count_magnitude = magnitude - 1;
+    unsigned long long sub_bucket_count = 1ULL << magnitude;
+    sub_bucket_mask = sub_bucket_count - 1;
+    size_t buckets = 1;
+    for (unsigned long long untrackable = sub_bucket_count; untrackable <= highest; untrackable <<= 1) {
+        ++buckets;
+        if (untrackable > ~0ULL / 2) break;
+    }
+    slots = (buckets + 1) << sub_bucket_half_count_magnitude;
+}
+
+size_t HistogramLayout::index_of(unsigned long long value) const {
+    if (value > highest) value = highest;
+    unsigned bucket = highest_set_bit64(value | sub_bucket_mask) - static_cast<unsigned>(sub_bucket_half_count_magnitude);
+    unsigned long long sub_bucket = value >> bucket; // In [half count, full count) for every bucket but the first
+    return (static_cast<size_t>(bucket + 1) << sub_bucket_half_count_magnitude) +
+           static_cast<size_t>(sub_bucket - (1ULL << sub_bucket_half_count_magnitude));
+}
+
+unsigned long long HistogramLayout::lowest_at(size_t index) const {
+    const size_t half = size_t(1) << sub_bucket_half_count_magnitude;
+    size_t bucket = index >> sub_bucket_half_count_magnitude;
+    unsigned long long sub_bucket = (index & (half - 1)) + half;
+    if (bucket == 0) return sub_bucket - half; // The first bucket's lower half
+    return sub_bucket << (bucket - 1);
+}
+
+unsigned long long HistogramLayout::highest_at(size_t index) const {
+    size_t bucket = index >> sub_bucket_half_count_magnitude;
+    unsigned long long width = (bucket <= 1) ? 1 : (1ULL << (bucket - 1));
+    return lowest_at(index) + (width - 1);
+}
+
+LatencyHistogram::LatencyHistogram(unsigned long long highest, int significant_digits)
+    : layout_(highest, significant_digits), counts_(layout_.slots, 0) {}
+
+void LatencyHistogram::record(unsigned long long value, unsigned long long count) {
+    if (count == 0) return;
+    if (value > layout_.highest) value = layout_.highest;
+    counts_[layout_.index_of(value)] += count;
+    total_ += count;
+    if (value < min_) min_ = value;
+    if (value > max_) max_ = value;
+}
+
+bool LatencyHistogram::merge(const LatencyHistogram& other) {
+    if (other.total_ == 0) return true;
+    if (total_ > ~0ULL - other.total_) {
+        report_diagnostic(ErrorCode::Overflow, DiagnosticLevel::Error, "LatencyHistogram::merge", "total count would overflow.");
         return false;
     }
-    *min_val = *std::min_element(vec.begin(), vec.end());
+    if (layout_ == other.layout_) {
+        for (size_t i = 0; i < counts_.size(); ++i) counts_[i] += other.counts_[i];
+        total_ += other.total_;
+        min_ = std::min(min_, other.min_);
+        max_ = std::max(max_, other.max_);
+        return true;
+    }
+    for (size_t i = 0; i < other.counts_.size(); ++i) { // Different precision or range: re-bucket
+        if (other.counts_[i] == 0) continue;
+        unsigned long long value = other.layout_.lowest_at(i);
+        record(std::max(other.min_, std::min(other.max_, value)), other.counts_[i]);
+    }
+    min_ = std::min(min_, std::min(other.min_, layout_.highest));
+    max_ = std::max(max_, std::min(other.max_, layout_.highest));
     return true;
 }
 
-void array_sort_string(std::vector<std::string>& vec) {
-    std::sort(vec.begin(), vec.end()); // Lexicographical sort
+void LatencyHistogram::reset() {
+    std::fill(counts_.begin(), counts_.end(), 0ULL);
+    total_ = 0;
+    min_ = ~0ULL;
+    max_ = 0;
 }
 
-bool array_contains_string(const std::vector<std::string>& vec, const std::string& value) {
-    // std::find uses operator== for std::string
-    return std::find(vec.begin(), vec.end(), value) != vec.end();
+double LatencyHistogram::mean() const {
+    if (total_ == 0) return 0.0;
+    double sum = 0.0;
+    for (size_t i = 0; i < counts_.size(); ++i) {
+        if (counts_[i] == 0) continue;
+        double middle = 0.5 * (static_cast<double>(layout_.lowest_at(i)) + static_cast<double>(layout_.highest_at(i)));
+        sum += middle * static_cast<double>(counts_[i]);
+    }
+    return sum / static_cast<double>(total_);
 }
 
-long long array_index_of_string(const std::vector<std::string>& vec, const std::string& value) {
-    auto it = std::find(vec.begin(), vec.end(), value);
-    if (it != vec.end()) {
-        size_t index = std::distance(vec.begin(), it);
-        if (index > static_cast<size_t>(std::numeric_limits<long long>::max())) {
-            std::cerr << "Warning: Index found (" << index << ") exceeds maximum representable long long value. Returning -1." << std::endl;
-            return -1LL;
-        }
-        return static_cast<long long>(index);
+unsigned long long LatencyHistogram::value_at_percentile(double percentile) const {
+    if (total_ == 0) return 0;
+    percentile = std::min(std::max(percentile, 0.0), 100.0);
+    unsigned long long target = static_cast<unsigned long long>(percentile / 100.0 * static_cast<double>(total_) + 0.5);
+    target = std::max<unsigned long long>(target, 1);
+    unsigned long long seen = 0;
+    for (size_t i = 0; i < counts_.size(); ++i) {
+        seen += counts_[i];
+        if (seen >= target) return std::max(min_, std::min(max_, layout_.highest_at(i)));
     }
-    return -1LL; // Not found
+    return max_;
 }
 
-size_t array_count_occurrence_string(const std::vector<std::string>& vec, const std::string& value) {
-    // std::count uses operator==
-    return std::count(vec.begin(), vec.end(), value);
+ConcurrentLatencyHistogram::ConcurrentLatencyHistogram(unsigned long long highest, int significant_digits)
+    : layout_(highest, significant_digits), counts_(new std::atomic<unsigned long long>[layout_.slots]) {
+    reset();
 }
 
-std::vector<std::string> array_copy_string(const std::vector<std::string>& vec) {
-    return vec; // Vector copy constructor performs deep copy of strings
+void ConcurrentLatencyHistogram::record(unsigned long long value, unsigned long long count) {
+    if (count == 0) return;
+    if (value > layout_.highest) value = layout_.highest;
+    counts_[layout_.index_of(value)].fetch_add(count, std::memory_order_relaxed);
+    total_.fetch_add(count, std::memory_order_relaxed);
+    unsigned long long seen = min_.load(std::memory_order_relaxed);
+    while (value < seen && !min_.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {
+    }
+    seen = max_.load(std::memory_order_relaxed);
+    while (value > seen && !max_.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {
+    }
 }
 
-void array_print_string(const std::vector<std::string>& vec) {
-    std::cout << "[";
-    for (size_t i = 0; i < vec.size(); ++i) {
-        // Consider quoting strings if they might contain commas or brackets?
-        std::cout << "\"" << vec[i] << "\""; // Basic quoting
-        if (i < vec.size() - 1) {
-            std::cout << ", ";
-        }
+LatencyHistogram ConcurrentLatencyHistogram::snapshot() const {
+    LatencyHistogram copy(layout_.highest, layout_.significant_digits);
+    for (size_t i = 0; i < layout_.slots; ++i) {
+        unsigned long long n = counts_[i].load(std::memory_order_relaxed);
+        copy.counts_[i] = n;
+        copy.total_ += n; // The sum of what was copied, so percentiles stay consistent
     }
-    std::cout << "]" << std::endl;
+    if (copy.total_ > 0) {
+        copy.min_ = min_.load(std::memory_order_relaxed);
+        copy.max_ = max_.load(std::memory_order_relaxed);
+    }
+    return copy;
 }
 
-void array_reverse_string(std::vector<std::string>& vec) {
-    std::reverse(vec.begin(), vec.end());
+void ConcurrentLatencyHistogram::reset() {
+    for (size_t i = 0; i < layout_.slots; ++i) counts_[i].store(0, std::memory_order_relaxed);
+    total_.store(0, std::memory_order_relaxed);
+    min_.store(~0ULL, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
 }
 
-void array_shuffle_string(std::vector<std::string>& vec) {
-    if (vec.size() < 2) return;
-    if (!random_initialized) initialize_random();
-    std::shuffle(vec.begin(), vec.end(), global_random_engine);
+void print_latency_histogram(const LatencyHistogram& histogram, const char* unit) {
+    std::cout << "count " << histogram.count() << ", mean " << histogram.mean() << ' ' << unit << ", min "
+              << histogram.min() << ", max " << histogram.max() << std::endl;
+    static const double percentiles[] = {50.0, 90.0, 99.0, 99.9, 99.99};
+    for (double p : percentiles) {
+        std::cout << "  p" << p << ": " << histogram.value_at_percentile(p) << ' ' << unit << std::endl;
+    }
 }
 
-std::vector<std::string> array_concat_string(const std::vector<std::string>& vec1, const std::vector<std::string>& vec2) {
-    std::vector<std::string> result = vec1;
-    result.insert(result.end(), vec2.begin(), vec2.end());
-    return result;
+// --- Profiling Zones ---
+// Every thread that records a zone gets its own ring, registered once under a mutex. After
+// that the thread only writes its ring's head index and the drain only writes the tail, so
+// neither side waits for the other. The registry keeps rings alive after their thread exits
+// until they have been drained.
+
+const size_t PROFILE_RING_EVENTS = 8192; // 256 KB per profiled thread
+
+struct ProfileRing {
+    SpscRing<ProfileEvent, PROFILE_RING_EVENTS> events;
+    unsigned int thread_id = 0;
+    std::atomic<bool> thread_exited{false};
+};
+
+struct ProfileRegistry {
+    std::mutex mutex; // Guards rings and next_thread_id, and serializes drains
+    std::vector<std::shared_ptr<ProfileRing>> rings;
+    unsigned int next_thread_id = 1;
+};
+
+static ProfileRegistry& profile_registry() {
+    static ProfileRegistry registry;
+    return registry;
 }
 
-// --- String Manipulation Functions ---
-// ... (copy, equals, trim remain the same) ...
-std::string string_copy(const std::string& str) {
-    return str; // std::string assignment/copy constructor handles this
+static std::atomic<bool> profiling_on{false};
+static std::atomic<size_t> profile_dropped{0};
+static std::atomic<unsigned long long> profile_epoch{0}; // Cycle count at which trace time 0 falls
+
+struct ThreadProfileRing {
+    std::shared_ptr<ProfileRing> ring;
+    ~ThreadProfileRing() {
+        if (ring) ring->thread_exited.store(true, std::memory_order_release);
+    }
+};
+
+static ProfileRing& this_thread_profile_ring() {
+    thread_local ThreadProfileRing local;
+    if (!local.ring) {
+        local.ring = std::make_shared<ProfileRing>();
+        ProfileRegistry& registry = profile_registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        local.ring->thread_id = registry.next_thread_id++;
+        registry.rings.push_back(local.ring);
+    }
+    return *local.ring;
 }
 
-bool string_equals(const std::string& str1, const std::string& str2) {
-    return str1 == str2;
+// Same ticks as start_cycles, without its fences: at trace resolution a few instructions
+// drifting across the read do not matter, and the fences would double a zone's cost
+static inline unsigned long long zone_ticks() {
+#if defined(ATOMIX_X86_64)
+    if (cycle_clock().tsc) return __rdtsc();
+#endif
+    return steady_ticks();
 }
 
-std::string string_trim(const std::string& str) {
-    const char* whitespace = " \t\n\r\f\v";
-    size_t first = str.find_first_not_of(whitespace);
-    if (first == std::string::npos) {
-        return ""; // String is all whitespace
+ScopedZone::ScopedZone(const char* name) : name_(nullptr), start_(0) {
+    if (profiling_on.load(std::memory_order_relaxed)) {
+        name_ = name;
+        start_ = zone_ticks();
     }
-    size_t last = str.find_last_not_of(whitespace);
-    return str.substr(first, (last - first + 1));
 }
 
+ScopedZone::~ScopedZone() {
+    if (name_ == nullptr) return;
+    unsigned long long end = zone_ticks();
+    ProfileRing& ring = this_thread_profile_ring();
+    if (!ring.events.push(ProfileEvent{name_, start_, end, ring.thread_id})) {
+        profile_dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
 
-bool string_is_int(const std::string& str) {
-    std::string trimmed = string_trim(str);
-    if (trimmed.empty()) {
-        return false;
+void set_profiling_enabled(bool enabled) {
+    if (enabled) {
+        unsigned long long unset = 0;
+        profile_epoch.compare_exchange_strong(unset, start_cycles());
     }
-    size_t pos = 0;
-    try {
-        // Use stol/stoll for parsing check, but check for trailing characters
-        // *** REMOVED [[maybe_unused]] attribute ***
-        long long val = std::stoll(trimmed, &pos);
-         // Ensure the entire string was consumed by stoll
-         return pos == trimmed.length();
-    } catch (const std::invalid_argument&) {
-        return false; // Not a number
-    } catch (const std::out_of_range&) {
-        return false; // Number is valid format but outside long long range
-    }
-    // Should not be reached
-    return false;
+    profiling_on.store(enabled, std::memory_order_relaxed);
 }
 
-// ... (is_alpha, is_digit, is_alnum, is_space, is_empty, concat, substring, find_char, find_substring, replace_char, to_lower, to_upper, split, join, starts_with, ends_with, to_float remain the same) ...
-bool string_is_alpha(const std::string& str) {
-    if (str.empty()) return false; // Or true depending on definition? Usually false.
-    return std::all_of(str.begin(), str.end(), ::isalpha);
+bool profiling_enabled() {
+    return profiling_on.load(std::memory_order_relaxed);
 }
 
-bool string_is_digit(const std::string& str) {
-     if (str.empty()) return false;
-    return std::all_of(str.begin(), str.end(), ::isdigit);
+size_t drain_profile_events(std::vector<ProfileEvent>& out) {
+    ProfileRegistry& registry = profile_registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    size_t drained = 0;
+    for (size_t i = 0; i < registry.rings.size();) {
+        ProfileRing& ring = *registry.rings[i];
+        bool exited = ring.thread_exited.load(std::memory_order_acquire); // Before the drain: nothing can follow it
+        drained += ring.events.drain([&](const ProfileEvent& e) { out.push_back(e); });
+        if (exited) {
+            registry.rings.erase(registry.rings.begin() + static_cast<std::ptrdiff_t>(i));
+        } else {
+            ++i;
+        }
+    }
+    return drained;
 }
 
-bool string_is_alnum(const std::string& str) {
-     if (str.empty()) return false;
-    return std::all_of(str.begin(), str.end(), ::isalnum);
+size_t profile_events_dropped() {
+    return profile_dropped.load(std::memory_order_relaxed);
 }
 
-bool string_is_space(const std::string& str) {
-     if (str.empty()) return false; // Or true? Let's say false.
-    return std::all_of(str.begin(), str.end(), ::isspace);
+struct TraceWriterState {
+    FILE* file = nullptr;
+    bool first_event = true;
+    bool write_failed = false;
+    std::mutex write_mutex; // flush() may run on the caller's thread and the background one
+    std::vector<ProfileEvent> events; // Drain buffer, reused between flushes
+    std::string text;
+
+    std::thread flusher;
+    std::mutex stop_mutex;
+    std::condition_variable stop_signal;
+    bool stopping = false;
+};
+
+TraceWriter::TraceWriter(const std::string& path) : state_(new TraceWriterState) {
+    state_->file = std::fopen(path.c_str(), "wb");
+    if (state_->file == nullptr) {
+        std::cerr << "Error in TraceWriter: cannot open '" << path << "'." << std::endl;
+        return;
+    }
+    static const char header[] = "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+    state_->write_failed = std::fwrite(header, 1, sizeof(header) - 1, state_->file) != sizeof(header) - 1;
 }
 
-bool string_is_empty(const std::string& str) {
-    return str.empty();
+TraceWriter::~TraceWriter() {
+    close();
 }
 
-std::string string_concat(const std::string& str1, const std::string& str2) {
-    return str1 + str2;
+bool TraceWriter::is_open() const {
+    return state_->file != nullptr;
 }
 
-std::string string_substring(const std::string& str, size_t start, size_t length) {
-    // std::string::substr handles bounds checking (throws out_of_range if start > size)
-    // and automatically adjusts length if it goes past the end.
-    try {
-       return str.substr(start, length);
-    } catch (const std::out_of_range& oor) {
-        std::cerr << "Error: Substring start position (" << start << ") is out of range for string of length " << str.length() << "." << std::endl;
-        return ""; // Return empty string on error
+size_t TraceWriter::flush() {
+    std::lock_guard<std::mutex> lock(state_->write_mutex);
+    if (state_->file == nullptr) return 0;
+    state_->events.clear();
+    drain_profile_events(state_->events);
+    if (state_->events.empty()) return 0;
+    const unsigned long long epoch = profile_epoch.load(std::memory_order_relaxed);
+    std::string& text = state_->text;
+    text.clear();
+    char numbers[128];
+    for (const ProfileEvent& e : state_->events) {
+        text += state_->first_event ? "\n{\"name\": " : ",\n{\"name\": ";
+        state_->first_event = false;
+        append_json_string(text, e.name);
+        double start_us = cycles_to_ns(e.start_cycles - epoch) / 1000.0;
+        double duration_us = cycles_to_ns(e.end_cycles - e.start_cycles) / 1000.0;
+        std::snprintf(numbers, sizeof(numbers), ", \"ph\": \"X\", \"pid\": 1, \"tid\": %u, \"ts\": %.3f, \"dur\": %.3f}",
+                      e.thread_id, start_us, duration_us);
+        text += numbers;
+    }
+    if (std::fwrite(text.data(), 1, text.size(), state_->file) != text.size() || std::fflush(state_->file) != 0) {
+        state_->write_failed = true;
     }
+    return state_->events.size();
+}
 
+void TraceWriter::start_background_flush(std::chrono::milliseconds interval) {
+    if (state_->flusher.joinable() || state_->file == nullptr) return;
+    state_->stopping = false;
+    TraceWriterState* state = state_.get();
+    state_->flusher = std::thread([this, state, interval] {
+        std::unique_lock<std::mutex> lock(state->stop_mutex);
+        while (!state->stop_signal.wait_for(lock, interval, [state] { return state->stopping; })) {
+            lock.unlock();
+            flush();
+            lock.lock();
+        }
+    });
 }
 
-long long string_find_char(const std::string& str, char c, size_t start_pos) {
-    size_t pos = str.find(c, start_pos);
-    if (pos == std::string::npos) {
-        return -1LL;
+void TraceWriter::stop_background_flush() {
+    if (!state_->flusher.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(state_->stop_mutex);
+        state_->stopping = true;
     }
-     if (pos > static_cast<size_t>(std::numeric_limits<long long>::max())) {
-            std::cerr << "Warning: Index found (" << pos << ") exceeds maximum representable long long value. Returning -1." << std::endl;
-            return -1LL;
-     }
-    return static_cast<long long>(pos);
+    state_->stop_signal.notify_one();
+    state_->flusher.join();
 }
 
-long long string_find_substring(const std::string& haystack, const std::string& needle, size_t start_pos) {
-    size_t pos = haystack.find(needle, start_pos);
-     if (pos == std::string::npos) {
-        return -1LL;
+bool TraceWriter::close() {
+    stop_background_flush();
+    if (state_->file == nullptr) return false;
+    flush();
+    static const char footer[] = "\n]}\n";
+    if (std::fwrite(footer, 1, sizeof(footer) - 1, state_->file) != sizeof(footer) - 1) state_->write_failed = true;
+    if (std::fclose(state_->file) != 0) state_->write_failed = true;
+    state_->file = nullptr;
+    if (state_->write_failed) {
+        std::cerr << "Error in TraceWriter::close: the trace could not be written." << std::endl;
     }
-      if (pos > static_cast<size_t>(std::numeric_limits<long long>::max())) {
-            std::cerr << "Warning: Index found (" << pos << ") exceeds maximum representable long long value. Returning -1." << std::endl;
-            return -1LL;
-     }
-    return static_cast<long long>(pos);
+    return !state_->write_failed;
 }
 
-std::string string_replace_char(const std::string& str, char find, char replace) {
-    std::string result = str;
-    std::replace(result.begin(), result.end(), find, replace);
-    return result;
+// --- Random Distribution Functions ---
+// Normal and exponential samples use the Ziggurat method (Marsaglia & Tsang) with
+// 256 layers. Each draw consumes one 64-bit value: the low 8 bits select the layer,
+// the top 53 bits give the uniform coordinate. ~99% of draws are accepted by a
+// single compare, so no log/sqrt/exp is evaluated on the fast path.
+
+unsigned long long get_random_u64() {
+    if (!random_initialized) {
+        initialize_random();
+    }
+    return static_cast<unsigned long long>(global_random_engine());
 }
 
-std::string string_to_lower(const std::string& str) {
-     std::string result = str;
-     std::transform(result.begin(), result.end(), result.begin(),
-                   [](unsigned char c){ return std::tolower(c); });
-     return result;
+// Uniform double in [0, 1) built from the top 53 bits
+static inline double bits_to_unit_double(unsigned long long bits) {
+    return static_cast<double>(bits >> 11) * (1.0 / 9007199254740992.0);
 }
 
-std::string string_to_upper(const std::string& str) {
-    std::string result = str;
-     std::transform(result.begin(), result.end(), result.begin(),
-                   [](unsigned char c){ return std::toupper(c); });
-     return result;
+// Uniform double in (0, 1], safe to pass to std::log
+static inline double bits_to_open_unit_double(unsigned long long bits) {
+    return static_cast<double>((bits >> 11) + 1) * (1.0 / 9007199254740992.0);
 }
 
-std::vector<std::string> string_split(const std::string& str, char delimiter) {
-    std::vector<std::string> tokens;
-    std::string token;
-    std::istringstream tokenStream(str);
-    while (std::getline(tokenStream, token, delimiter)) {
-        tokens.push_back(token);
+struct ZigguratTables {
+    double x[257]; // Layer edges: x[0] is the virtual width of the base strip, x[256] == 0
+    double f[257]; // Unnormalised density at each edge
+};
+
+static double zig_normal_pdf(double x) {
+    return std::exp(-0.5 * x * x);
+}
+
+static double zig_exponential_pdf(double x) {
+    return std::exp(-x);
+}
+
+static ZigguratTables build_normal_ziggurat() {
+    ZigguratTables t;
+    const double r = 3.6541528853610088; // Start of the tail
+    // Area of every layer: the base strip plus the tail beyond r (sqrt(pi/2) * erfc(r/sqrt(2)))
+    const double v = r * zig_normal_pdf(r) + 1.2533141373155002512 * std::erfc(r / std::sqrt(2.0));
+
+    t.x[0] = v / zig_normal_pdf(r);
+    t.x[1] = r;
+    for (int i = 1; i < 256; ++i) {
+        // Each layer has area v: x[i] * (f(x[i+1]) - f(x[i])) == v
+        double y = v / t.x[i] + zig_normal_pdf(t.x[i]);
+        t.x[i + 1] = (y >= 1.0) ? 0.0 : std::sqrt(-2.0 * std::log(y));
     }
-    // Handle case where the string might end with a delimiter (adds an empty token)
-    // or if the string is empty (results in an empty vector, which is correct)
-    return tokens;
+    t.x[256] = 0.0;
+    for (int i = 0; i <= 256; ++i) {
+        t.f[i] = zig_normal_pdf(t.x[i]);
+    }
+    return t;
 }
 
-std::string string_join(const std::vector<std::string>& parts, const std::string& separator) {
-    std::string result;
-    for (size_t i = 0; i < parts.size(); ++i) {
-        result += parts[i];
-        if (i < parts.size() - 1) {
-            result += separator;
-        }
+static ZigguratTables build_exponential_ziggurat() {
+    ZigguratTables t;
+    const double r = 7.69711747013104972; // Start of the tail
+    const double v = (r + 1.0) * zig_exponential_pdf(r); // Base strip plus tail area
+
+    t.x[0] = v / zig_exponential_pdf(r);
+    t.x[1] = r;
+    for (int i = 1; i < 256; ++i) {
+        double y = v / t.x[i] + zig_exponential_pdf(t.x[i]);
+        t.x[i + 1] = (y >= 1.0) ? 0.0 : -std::log(y);
     }
-    return result;
+    t.x[256] = 0.0;
+    for (int i = 0; i <= 256; ++i) {
+        t.f[i] = zig_exponential_pdf(t.x[i]);
+    }
+    return t;
 }
 
-bool string_starts_with(const std::string& str, const std::string& prefix) {
-    // C++20 has str.starts_with()
-    // Pre-C++20 implementation:
-    return str.rfind(prefix, 0) == 0;
-    // Or: return str.size() >= prefix.size() && str.compare(0, prefix.size(), prefix) == 0;
+static const ZigguratTables& normal_ziggurat() {
+    static const ZigguratTables tables = build_normal_ziggurat(); // Built once, thread-safe
+    return tables;
 }
 
-bool string_ends_with(const std::string& str, const std::string& suffix) {
-    // C++20 has str.ends_with()
-    // Pre-C++20 implementation:
-     if (suffix.size() > str.size()) return false;
-     return std::equal(suffix.rbegin(), suffix.rend(), str.rbegin());
-    // Or: return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+static const ZigguratTables& exponential_ziggurat() {
+    static const ZigguratTables tables = build_exponential_ziggurat();
+    return tables;
 }
 
-bool string_to_float(const std::string& str, float* out_val) {
-    if (out_val == nullptr) return false;
-    std::string temp_str = string_trim(str); // Handle leading/trailing whitespace
-    if (temp_str.empty()) return false;
+// Standard normal sample (mean 0, stddev 1)
+static double sample_standard_normal(const ZigguratTables& t) {
+    const double r = t.x[1];
+    while (true) {
+        unsigned long long bits = get_random_u64();
+        size_t i = static_cast<size_t>(bits & 0xFF);
+        double u = 2.0 * bits_to_unit_double(bits) - 1.0; // Uniform in [-1, 1)
+        double x = u * t.x[i];
 
-    try {
-        size_t pos;
-        // Use stod for wider range check first
-        double d = std::stod(temp_str, &pos);
-
-        // Ensure entire string was consumed
-        if (pos != temp_str.length()) {
-            return false; // Trailing characters
-        }
-
-        // Check float range before assignment
-        if (d > std::numeric_limits<float>::max() || d < -std::numeric_limits<float>::max()) {
-            if (d != 0.0 && !std::isinf(d) && (std::fabs(d) < std::numeric_limits<float>::min())) {
-                // Underflow - maybe acceptable as 0.0f? Let's return true but set 0.
-                *out_val = 0.0f;
-                return true; // Or false if underflow is an error
-            } else if (!std::isinf(d)) { // Overflow
-                return false;
-            }
-            // Allow Inf/-Inf through if that's the result of stod
+        if (std::fabs(x) < t.x[i + 1]) {
+            return x; // Inside the rectangle fully covered by the density
+        }
+        if (i == 0) {
+            // Base strip overflowed into the tail: Marsaglia's tail algorithm
+            double tx, ty;
+            do {
+                tx = -std::log(bits_to_open_unit_double(get_random_u64())) / r;
+                ty = -std::log(bits_to_open_unit_double(get_random_u64()));
+            } while (2.0 * ty < tx * tx);
+            return (u < 0.0) ? -(r + tx) : (r + tx);
+        }
+        // Wedge between the rectangle and the curve
+        double y = t.f[i + 1] + (t.f[i] - t.f[i + 1]) * bits_to_unit_double(get_random_u64());
+        if (y < zig_normal_pdf(x)) {
+            return x;
         }
-
-        *out_val = static_cast<float>(d);
-        return true;
-    } catch (const std::invalid_argument&) {
-        return false; // Not a valid number format
-    } catch (const std::out_of_range&) {
-        return false; // Out of range for double (and thus definitely for float)
     }
 }
 
+// Standard exponential sample (rate 1)
+static double sample_standard_exponential(const ZigguratTables& t) {
+    const double r = t.x[1];
+    while (true) {
+        unsigned long long bits = get_random_u64();
+        size_t i = static_cast<size_t>(bits & 0xFF);
+        double x = bits_to_unit_double(bits) * t.x[i];
 
-bool string_to_double(const std::string& str, double* out_val) {
-     if (out_val == nullptr) return false;
-     std::string temp_str = string_trim(str);
-     if (temp_str.empty()) return false;
-
-    try {
-        size_t pos;
-        // Use stold for potentially wider range check if needed, though stod is usually fine
-        long double ld = std::stold(temp_str, &pos);
-
-        if (pos != temp_str.length()) {
-            return false; // Trailing characters
-        }
-
-        // Check double range (less likely to fail than float, but good practice)
-        if (ld > std::numeric_limits<double>::max() || ld < -std::numeric_limits<double>::max()) {
-             // *** Use fabsl (global scope) instead of std::fabsl ***
-             if (ld != 0.0l && !std::isinf(ld) && (fabsl(ld) < std::numeric_limits<double>::min())) {
-                 // Underflow
-                 *out_val = 0.0;
-                 return true; // Or false?
-             } else if (!std::isinf(ld)) { // Overflow
-                return false;
-             }
-             // Allow Inf/-Inf
+        if (x < t.x[i + 1]) {
+            return x;
+        }
+        if (i == 0) {
+            // Memoryless tail: r plus another standard exponential
+            return r - std::log(bits_to_open_unit_double(get_random_u64()));
+        }
+        double y = t.f[i + 1] + (t.f[i] - t.f[i + 1]) * bits_to_unit_double(get_random_u64());
+        if (y < zig_exponential_pdf(x)) {
+            return x;
         }
-
-        *out_val = static_cast<double>(ld);
-        return true;
-    } catch (const std::invalid_argument&) {
-        return false;
-    } catch (const std::out_of_range&) {
-        // Out of range for long double
-        return false;
     }
 }
 
+// Poisson sampler. Small means use inversion by sequential search; larger means use
+// Hormann's PTRS transformed rejection, whose constants are computed once per mean.
+struct PoissonSampler {
+    double mean;
+    double exp_neg_mean; // Inversion
+    double slam, loglam, b, a, invalpha, vr; // PTRS
+
+    explicit PoissonSampler(double m) : mean(m), exp_neg_mean(std::exp(-m)),
+        slam(0.0), loglam(0.0), b(0.0), a(0.0), invalpha(0.0), vr(0.0) {
+        if (mean >= 10.0) {
+            slam = std::sqrt(mean);
+            loglam = std::log(mean);
+            b = 0.931 + 2.53 * slam;
+            a = -0.059 + 0.02483 * b;
+            invalpha = 1.1239 + 1.1328 / (b - 3.4);
+            vr = 0.9277 - 3.6224 / (b - 2.0);
+        }
+    }
 
-// --- Memory Management Helpers ---
-// ... (free_string, free_string_array remain the same) ...
-void free_string(char* str) {
-    // Assumes str was allocated with malloc/calloc/strdup
-    std::free(str);
-}
+    int sample() const {
+        if (mean < 10.0) {
+            int k = 0;
+            double p = exp_neg_mean;
+            double cdf = p;
+            double u = bits_to_unit_double(get_random_u64());
+            while (u > cdf) {
+                ++k;
+                p *= mean / k;
+                cdf += p;
+                if (p <= 0.0) break; // Guard against rounding at the far tail
+            }
+            return k;
+        }
 
-void free_string_array(char** arr, size_t size) {
-    // Assumes arr was allocated with malloc/calloc, and each arr[i] with malloc/calloc/strdup
-    if (arr == nullptr) {
-        return;
+        while (true) {
+            double u = bits_to_unit_double(get_random_u64()) - 0.5;
+            double v = bits_to_open_unit_double(get_random_u64());
+            double us = 0.5 - std::fabs(u);
+            double k = std::floor((2.0 * a / us + b) * u + mean + 0.43);
+
+            if (us >= 0.07 && v <= vr) {
+                return static_cast<int>(k);
+            }
+            if (k < 0.0 || (us < 0.013 && v > us)) {
+                continue;
+            }
+            if (std::log(v) + std::log(invalpha) - std::log(a / (us * us) + b) <=
+                -mean + k * loglam - std::lgamma(k + 1.0)) {
+                return static_cast<int>(k);
+            }
+        }
     }
-    for (size_t i = 0; i < size; ++i) {
-        std::free(arr[i]); // Free each individual string
+};
+
+double get_random_normal(double mean, double stddev) {
+    return mean + std::fabs(stddev) * sample_standard_normal(normal_ziggurat());
+}
+
+double get_random_exponential(double lambda) {
+    if (!(lambda > 0.0)) {
+        report_diagnostic(ErrorCode::InvalidArgument, DiagnosticLevel::Error, "get_random_exponential", "lambda (%g) must be positive.", lambda);
+        return 0.0;
     }
-    std::free(arr); // Free the array of pointers
+    return sample_standard_exponential(exponential_ziggurat()) / lambda;
 }
 
-// --- Utility Functions ---
-// ... (initialize_random, get_random_int, get_random_float, get_random_double, start_timer, stop_timer remain the same) ...
-void initialize_random() {
-    std::random_device rd; // Obtain a random number from hardware entropy source
-    global_random_engine.seed(rd()); // Seed the Mersenne Twister engine
-    random_initialized = true;
+int get_random_poisson(double mean) {
+    if (!(mean >= 0.0) || mean > static_cast<double>(std::numeric_limits<int>::max() / 2)) {
+        report_diagnostic(ErrorCode::OutOfRange, DiagnosticLevel::Error, "get_random_poisson", "mean (%g) is out of range.", mean);
+        return 0;
+    }
+    return PoissonSampler(mean).sample();
 }
 
-int get_random_int(int min_val, int max_val) {
-    if (!random_initialized) {
-        initialize_random();
+bool fill_random_normal(double *out, size_t count, double mean, double stddev) {
+    if (out == nullptr && count > 0) {
+        set_last_error(ErrorCode::NullArgument);
+        return false;
     }
-    if (min_val > max_val) {
-        std::swap(min_val, max_val); // Handle incorrect order
+    const ZigguratTables& t = normal_ziggurat();
+    const double scale = std::fabs(stddev);
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = mean + scale * sample_standard_normal(t);
     }
-    std::uniform_int_distribution<int> distrib(min_val, max_val);
-    return distrib(global_random_engine);
+    return true;
 }
 
-float get_random_float(float min_val, float max_val) {
-     if (!random_initialized) {
-        initialize_random();
+bool fill_random_normal_float(float *out, size_t count, float mean, float stddev) {
+    if (out == nullptr && count > 0) {
+        set_last_error(ErrorCode::NullArgument);
+        return false;
     }
-     if (min_val > max_val) {
-        std::swap(min_val, max_val);
+    const ZigguratTables& t = normal_ziggurat();
+    const double scale = std::fabs(stddev);
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = static_cast<float>(mean + scale * sample_standard_normal(t));
     }
-    // Inclusive range for real distribution
-    std::uniform_real_distribution<float> distrib(min_val, std::nextafter(max_val, std::numeric_limits<float>::infinity()));
-    return distrib(global_random_engine);
+    return true;
 }
 
-double get_random_double(double min_val, double max_val) {
-    if (!random_initialized) {
-        initialize_random();
+bool fill_random_exponential(double *out, size_t count, double lambda) {
+    if ((out == nullptr && count > 0) || !(lambda > 0.0)) {
+        set_last_error((out == nullptr && count > 0) ? ErrorCode::NullArgument : ErrorCode::InvalidArgument);
+        return false;
     }
-     if (min_val > max_val) {
-        std::swap(min_val, max_val);
+    const ZigguratTables& t = exponential_ziggurat();
+    const double scale = 1.0 / lambda;
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = sample_standard_exponential(t) * scale;
     }
-    std::uniform_real_distribution<double> distrib(min_val, std::nextafter(max_val, std::numeric_limits<double>::infinity()));
-    return distrib(global_random_engine);
+    return true;
 }
 
-std::chrono::high_resolution_clock::time_point start_timer() {
-    return std::chrono::high_resolution_clock::now();
+bool fill_random_exponential_float(float *out, size_t count, float lambda) {
+    if ((out == nullptr && count > 0) || !(lambda > 0.0f)) {
+        set_last_error((out == nullptr && count > 0) ? ErrorCode::NullArgument : ErrorCode::InvalidArgument);
+        return false;
+    }
+    const ZigguratTables& t = exponential_ziggurat();
+    const double scale = 1.0 / lambda;
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = static_cast<float>(sample_standard_exponential(t) * scale);
+    }
+    return true;
 }
 
-double stop_timer(std::chrono::high_resolution_clock::time_point start_time) {
-    auto end_time = std::chrono::high_resolution_clock::now();
-    std::chrono::duration<double> elapsed = end_time - start_time;
-    return elapsed.count(); // Return duration in seconds
+bool fill_random_poisson(int *out, size_t count, double mean) {
+    if ((out == nullptr && count > 0) || !(mean >= 0.0) ||
+        mean > static_cast<double>(std::numeric_limits<int>::max() / 2)) {
+        set_last_error((out == nullptr && count > 0) ? ErrorCode::NullArgument : ErrorCode::OutOfRange);
+        return false;
+    }
+    PoissonSampler sampler(mean); // Constants computed once for the whole batch
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = sampler.sample();
+    }
+    return true;
 }
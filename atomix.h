@@ -3,10 +3,19 @@
 
 #include <cstddef> // size_t
 #include <string>  // std::string
+#include <string_view> // std::string_view for zero-copy string functions
+#include <iterator> // std::forward_iterator_tag
 #include <vector>  // std::vector
 #include <limits>  // std::numeric_limits
 #include <chrono>  // For timer
 #include <cmath>   // For std::fabs in helper functions
+#include <random>  // std::mt19937_64 for the sampling templates
+#include <algorithm> // std::push_heap / std::pop_heap for weighted sampling
+#include <utility> // std::pair
+#include <memory>  // std::shared_ptr
+#include <type_traits> // std::remove_reference_t for the benchmark runner
+#include <atomic>  // std::atomic_signal_fence (clobber_memory without GCC asm)
+#include <memory_resource> // std::pmr::memory_resource for CountingResource
 
 // --- Constants ---
 const float FLOAT_EPSILON = 1e-5f;
@@ -27,7 +36,188 @@ inline bool doubles_are_close(double a, double b, double epsilon = DOUBLE_EPSILO
 }
 
 
+// --- Diagnostics ---
+// The array, vector, string and distribution functions never write to std::cerr. When a
+// call fails it returns its usual failure value (false, -1, nullptr, empty) and sets the
+// calling thread's last_error(); "not found" is not a failure. A null pointer or an empty
+// input where a value is needed only sets the code. Other failures (overflow, a failed
+// allocation, a bad range) also report a Diagnostic to the sink. The default sink appends it to
+// a ring owned by the reporting thread: no lock, no I/O. A background thread writes the rings
+// to stderr every 50 ms and at exit. Diagnostics that find their ring full are dropped and
+// counted. A custom sink is called on the reporting thread instead.
+enum class ErrorCode { None, NullArgument, InvalidArgument, OutOfRange, Overflow, AllocationFailed, CapacityExceeded };
+enum class DiagnosticLevel { Warning, Error };
+
+struct Diagnostic {
+    ErrorCode code = ErrorCode::None;
+    DiagnosticLevel level = DiagnosticLevel::Error;
+    const char* function = ""; // Name of the reporting function (a string literal)
+    char message[112] = {};    // Formatted when reported, truncated to fit
+};
+
+using DiagnosticSink = void (*)(const Diagnostic& diagnostic);
+void set_diagnostic_sink(DiagnosticSink sink); // nullptr restores the default per-thread rings
+ErrorCode last_error(); // The calling thread's most recent error; like errno, success leaves it alone
+void clear_last_error();
+const char* error_code_name(ErrorCode code); // "OutOfRange", ...
+std::string format_diagnostic(const Diagnostic& diagnostic); // "Error in string_substring: ..."
+void flush_diagnostics(); // Writes the queued diagnostics to stderr now
+size_t diagnostics_dropped();
+
 // --- Input Functions ---
+// Interactive mode flushes every prompt and reads std::cin line by line. Batch mode, for
+// piped or redirected input, reads stdin in large raw blocks and does not flush prompts.
+// Auto (the default) picks Batch when stdin is not a terminal. Don't mix Batch mode with
+// direct std::cin reads: they buffer separately. At end of input both modes set std::cin's
+// eofbit and failbit, so std::cin.eof() checks keep working.
+enum class InputMode { Auto, Interactive, Batch };
+void set_input_mode(InputMode mode);
+InputMode get_input_mode(); // The mode in effect: Interactive or Batch, never Auto
+
+// Result of a timed or non-blocking read
+enum class InputStatus { Ok, Timeout, Eof, Error };
+using InputDeadline = std::chrono::steady_clock::time_point;
+
+// Buffered line reader over a file descriptor (poll + read), e.g. a pipe or socket. Lines
+// are views into its buffer, valid until the next call; a partial line that times out
+// stays buffered. End of input is not sticky: a terminal can be read again afterwards.
+// Without POSIX poll only fd 0 is supported, and reads there always block.
+class LineReader {
+public:
+    explicit LineReader(int fd = 0) : fd_(fd) {}
+    int fd() const { return fd_; } // For callers that poll several descriptors themselves
+
+    InputStatus read_line(std::string_view& line);                         // Waits as long as needed
+    InputStatus read_line(std::string_view& line, InputDeadline deadline); // Timeout once deadline passes
+    InputStatus poll_line(std::string_view& line);                         // Never waits: Timeout if no full line yet
+
+    // Delivers every line available right now to on_line(std::string_view) without waiting.
+    // Returns Ok while the input is open, Eof once it has ended, or Error.
+    template <typename Callback>
+    InputStatus pump(Callback on_line) {
+        std::string_view line;
+        InputStatus status;
+        while ((status = poll_line(line)) == InputStatus::Ok) {
+            on_line(line);
+        }
+        return (status == InputStatus::Timeout) ? InputStatus::Ok : status;
+    }
+
+private:
+    InputStatus next_line(std::string_view& line, int wait_ms, bool until_deadline, InputDeadline deadline);
+    InputStatus fill(int wait_ms);
+
+    int fd_;
+    std::vector<char> data_;
+    size_t begin_ = 0;   // Unread bytes are data_[begin_, end_)
+    size_t end_ = 0;
+    size_t scanned_ = 0; // data_[begin_, scanned_) holds no newline
+};
+
+// Where the get_* functions read lines from. Sources are not owned by the library; the
+// current one must outlive its use. Only interactive sources get their prompts flushed.
+class InputSource {
+public:
+    virtual ~InputSource() = default;
+    // Next line without its '\n'; false at end of input. The view stays valid until the next call.
+    virtual bool read_line(std::string_view& line) = 0;
+    virtual bool interactive() const { return false; }
+    // For the timed get_* functions; sources whose data is always at hand never wait
+    virtual InputStatus read_line_until(std::string_view& line, InputDeadline deadline) {
+        (void)deadline;
+        return read_line(line) ? InputStatus::Ok : InputStatus::Eof;
+    }
+};
+
+class StdinSource : public InputSource { // The default; follows the InputMode above
+public:
+    bool read_line(std::string_view& line) override;
+    bool interactive() const override;
+    InputStatus read_line_until(std::string_view& line, InputDeadline deadline) override; // Raw fd 0 in both modes, and read_line follows
+};
+
+class MemorySource : public InputSource { // Lines of a caller-owned buffer, without copying
+public:
+    explicit MemorySource(std::string_view data) : data_(data) {}
+    bool read_line(std::string_view& line) override;
+    void rewind() { pos_ = 0; }
+
+protected:
+    MemorySource() = default;
+    std::string_view data_;
+    size_t pos_ = 0;
+};
+
+class MappedFileSource : public MemorySource { // A file mapped with mmap (read whole where unavailable)
+public:
+    explicit MappedFileSource(const std::string& path);
+    ~MappedFileSource() override;
+    MappedFileSource(const MappedFileSource&) = delete;
+    MappedFileSource& operator=(const MappedFileSource&) = delete;
+
+    bool is_open() const { return open_; }
+
+private:
+    void* mapping_ = nullptr;
+    size_t mapped_size_ = 0;
+    std::vector<char> contents_; // Used when the file cannot be mapped
+    bool open_ = false;
+};
+
+void set_input_source(InputSource* source); // nullptr restores stdin; also clears std::cin's state
+InputSource& get_input_source();
+
+std::string_view get_line_view(const char *prompt = nullptr); // Valid until the next input call; empty at EOF
+
+// Timed versions: give up with InputStatus::Timeout at the deadline instead of blocking.
+// Invalid input is retried until then, as in the untimed versions; *out is written only on
+// Ok. Timed reads of stdin use its raw buffer even in Interactive mode, and once one has
+// run, untimed reads use that buffer too instead of std::getline.
+InputStatus get_line_view(std::string_view *line, InputDeadline deadline, const char *prompt = nullptr);
+InputStatus get_string(std::string *out, InputDeadline deadline, const char *prompt = nullptr);
+InputStatus get_int(int *out, InputDeadline deadline, const char *prompt = nullptr);
+InputStatus get_long(long *out, InputDeadline deadline, const char *prompt = nullptr);
+InputStatus get_float(float *out, InputDeadline deadline, const char *prompt = nullptr);
+InputStatus get_double(double *out, InputDeadline deadline, const char *prompt = nullptr);
+
+inline InputStatus get_line_view(std::string_view *line, std::chrono::milliseconds timeout, const char *prompt = nullptr) {
+    return get_line_view(line, std::chrono::steady_clock::now() + timeout, prompt);
+}
+inline InputStatus get_string(std::string *out, std::chrono::milliseconds timeout, const char *prompt = nullptr) {
+    return get_string(out, std::chrono::steady_clock::now() + timeout, prompt);
+}
+inline InputStatus get_int(int *out, std::chrono::milliseconds timeout, const char *prompt = nullptr) {
+    return get_int(out, std::chrono::steady_clock::now() + timeout, prompt);
+}
+inline InputStatus get_long(long *out, std::chrono::milliseconds timeout, const char *prompt = nullptr) {
+    return get_long(out, std::chrono::steady_clock::now() + timeout, prompt);
+}
+inline InputStatus get_float(float *out, std::chrono::milliseconds timeout, const char *prompt = nullptr) {
+    return get_float(out, std::chrono::steady_clock::now() + timeout, prompt);
+}
+inline InputStatus get_double(double *out, std::chrono::milliseconds timeout, const char *prompt = nullptr) {
+    return get_double(out, std::chrono::steady_clock::now() + timeout, prompt);
+}
+
+// Bulk readers: read values separated by whitespace (and by delimiter, if given) from the
+// current input source, across as many lines as needed, until count values or the end of
+// input (count 0, vector forms only). Values outside [min_val, max_val] or malformed tokens
+// stop the read with a message on std::cerr. Returns the number of values stored; vectors
+// are replaced. Tokens after the count-th value on its line are discarded.
+size_t get_ints(std::vector<int>& out, size_t count = 0, char delimiter = ' ',
+                int min_val = std::numeric_limits<int>::min(), int max_val = std::numeric_limits<int>::max());
+size_t get_ints(int *out, size_t count, char delimiter = ' ',
+                int min_val = std::numeric_limits<int>::min(), int max_val = std::numeric_limits<int>::max());
+size_t get_longs(std::vector<long>& out, size_t count = 0, char delimiter = ' ',
+                 long min_val = std::numeric_limits<long>::min(), long max_val = std::numeric_limits<long>::max());
+size_t get_longs(long *out, size_t count, char delimiter = ' ',
+                 long min_val = std::numeric_limits<long>::min(), long max_val = std::numeric_limits<long>::max());
+size_t get_doubles(std::vector<double>& out, size_t count = 0, char delimiter = ' ',
+                   double min_val = -std::numeric_limits<double>::infinity(),
+                   double max_val = std::numeric_limits<double>::infinity());
+size_t get_doubles(double *out, size_t count, char delimiter = ' ',
+                   double min_val = -std::numeric_limits<double>::infinity(),
+                   double max_val = std::numeric_limits<double>::infinity());
 std::string get_string(const char *prompt = nullptr);
 char get_char(const char *prompt = nullptr);
 int get_int(const char *prompt = nullptr);
@@ -53,6 +243,7 @@ size_t array_count_occurrence(const int *arr, size_t size, int value);
 int* array_copy_int(const int *arr, size_t size); // Caller must delete[] result
 void array_reverse_int(int *arr, size_t size);
 void array_shuffle_int(int *arr, size_t size);
+void array_parallel_shuffle_int(int *arr, size_t size, unsigned long long seed, unsigned int num_threads = 0); // Reproducible per seed; 0 threads = all cores
 int* array_unique_int(const int *arr, size_t size, size_t *unique_size); // Caller must delete[] result
 int* array_concat_int(const int *arr1, size_t size1, const int *arr2, size_t size2, size_t *new_size); // Caller must delete[] result
 
@@ -69,6 +260,7 @@ std::vector<float> array_copy_float(const std::vector<float>& vec);
 void array_print_float(const std::vector<float>& vec);
 void array_reverse_float(std::vector<float>& vec);
 void array_shuffle_float(std::vector<float>& vec);
+void array_parallel_shuffle_float(std::vector<float>& vec, unsigned long long seed, unsigned int num_threads = 0);
 std::vector<float> array_concat_float(const std::vector<float>& vec1, const std::vector<float>& vec2);
 
 // --- Double Array Functions (using std::vector) ---
@@ -84,6 +276,7 @@ std::vector<double> array_copy_double(const std::vector<double>& vec);
 void array_print_double(const std::vector<double>& vec);
 void array_reverse_double(std::vector<double>& vec);
 void array_shuffle_double(std::vector<double>& vec);
+void array_parallel_shuffle_double(std::vector<double>& vec, unsigned long long seed, unsigned int num_threads = 0);
 std::vector<double> array_concat_double(const std::vector<double>& vec1, const std::vector<double>& vec2);
 
 // --- String Array Functions (using std::vector<std::string>) ---
@@ -98,13 +291,16 @@ std::vector<std::string> array_copy_string(const std::vector<std::string>& vec);
 void array_print_string(const std::vector<std::string>& vec);
 void array_reverse_string(std::vector<std::string>& vec);
 void array_shuffle_string(std::vector<std::string>& vec);
+void array_parallel_shuffle_string(std::vector<std::string>& vec, unsigned long long seed, unsigned int num_threads = 0);
 std::vector<std::string> array_concat_string(const std::vector<std::string>& vec1, const std::vector<std::string>& vec2);
 
 // --- String Manipulation Functions ---
+enum class CaseMode { Ascii, Utf8 }; // Which letters case conversion maps (see Case Conversion below)
+
 std::string string_copy(const std::string& str);
 bool string_equals(const std::string& str1, const std::string& str2);
 std::string string_trim(const std::string& str);
-bool string_is_int(const std::string& str);
+bool string_is_int(std::string_view str); // Whole string (ignoring surrounding whitespace) is a long long
 bool string_is_alpha(const std::string& str);
 bool string_is_digit(const std::string& str);
 bool string_is_alnum(const std::string& str);
@@ -114,15 +310,406 @@ std::string string_concat(const std::string& str1, const std::string& str2);
 std::string string_substring(const std::string& str, size_t start, size_t length = std::string::npos);
 long long string_find_char(const std::string& str, char c, size_t start_pos = 0); // Returns -1 if not found
 long long string_find_substring(const std::string& haystack, const std::string& needle, size_t start_pos = 0); // Returns -1 if not found
+std::vector<size_t> string_find_all(std::string_view haystack, std::string_view needle, bool overlapping = false); // Empty needle: no matches
+size_t string_count_substring(std::string_view haystack, std::string_view needle, bool overlapping = false);
+long long string_find_any_of(std::string_view str, std::string_view chars, size_t start_pos = 0); // First byte that is in chars, -1 if none
 std::string string_replace_char(const std::string& str, char find, char replace);
-std::string string_to_lower(const std::string& str);
-std::string string_to_upper(const std::string& str);
+// Replace every non-overlapping occurrence of from (left to right); an empty from changes nothing.
+// The output size is computed by a first scan, so the result is allocated or written exactly once.
+std::string string_replace_all(std::string_view str, std::string_view from, std::string_view to);
+size_t string_replace_all_into(std::string_view str, std::string_view from, std::string_view to,
+                               char* out, size_t out_capacity); // Returns the required size; writes only if it fits
+size_t string_replace_all_inplace(std::string& str, std::string_view from, std::string_view to); // Returns replacements made; no allocation unless to is longer than from
+std::string string_to_lower(const std::string& str, CaseMode mode = CaseMode::Ascii);
+std::string string_to_upper(const std::string& str, CaseMode mode = CaseMode::Ascii);
 std::vector<std::string> string_split(const std::string& str, char delimiter);
 std::string string_join(const std::vector<std::string>& parts, const std::string& separator);
 bool string_starts_with(const std::string& str, const std::string& prefix);
 bool string_ends_with(const std::string& str, const std::string& suffix);
-bool string_to_float(const std::string& str, float* out_val);
-bool string_to_double(const std::string& str, double* out_val);
+// Numeric conversion: surrounding whitespace and a leading '+' are allowed, nothing else may
+// trail the number. No exceptions and no allocation; out_val is only written on success.
+bool string_to_int(std::string_view str, int* out_val);
+bool string_to_long(std::string_view str, long* out_val);
+bool string_to_float(std::string_view str, float* out_val); // Accepts inf, rejects NaN; underflow gives 0
+bool string_to_double(std::string_view str, double* out_val);
+
+// --- Case Conversion and Case-Insensitive Matching ---
+// Conversions never change the length, so in-place and into-buffer forms need no allocation.
+// Ascii (the default) maps A-Z/a-z only and is locale-independent; Utf8 also maps the
+// Latin-1, Latin Extended-A, Greek and Cyrillic letters whose case pair has the same
+// encoded length. Comparisons fold ASCII letters only.
+void string_to_lower_inplace(std::string& str, CaseMode mode = CaseMode::Ascii);
+void string_to_upper_inplace(std::string& str, CaseMode mode = CaseMode::Ascii);
+void string_to_lower_inplace(char* buf, size_t len, CaseMode mode = CaseMode::Ascii);
+void string_to_upper_inplace(char* buf, size_t len, CaseMode mode = CaseMode::Ascii);
+size_t string_to_lower_into(std::string_view src, char* out, size_t out_capacity, CaseMode mode = CaseMode::Ascii); // Bytes written, 0 if out is too small
+size_t string_to_upper_into(std::string_view src, char* out, size_t out_capacity, CaseMode mode = CaseMode::Ascii); // Bytes written, 0 if out is too small
+void string_to_lower_into(std::string_view src, std::string& out, CaseMode mode = CaseMode::Ascii); // Reuses out's capacity
+void string_to_upper_into(std::string_view src, std::string& out, CaseMode mode = CaseMode::Ascii);
+bool string_equals_ignore_case(std::string_view str1, std::string_view str2);
+bool string_starts_with_ignore_case(std::string_view str, std::string_view prefix);
+long long string_find_ignore_case(std::string_view haystack, std::string_view needle, size_t start_pos = 0); // Returns -1 if not found
+
+// --- Substring Search ---
+// Compiles a needle once for reuse across many haystacks. Short needles (up to 32 bytes)
+// use a SIMD first/last-byte filter; longer ones use Two-Way, linear in the worst case.
+// The needle is copied, so the Searcher does not depend on the caller's buffer.
+struct TwoWayTable; // Defined in atomix.cpp
+
+class Searcher {
+public:
+    explicit Searcher(std::string_view needle);
+
+    size_t find(std::string_view haystack, size_t start_pos = 0) const; // std::string_view::npos if none
+    std::vector<size_t> find_all(std::string_view haystack, bool overlapping = false) const;
+    size_t count(std::string_view haystack, bool overlapping = false) const;
+    const std::string& needle() const { return needle_; }
+
+private:
+    std::string needle_;
+    std::shared_ptr<const TwoWayTable> table_; // Two-Way state, only for long needles (shared by copies)
+};
+
+// --- Multi-Pattern Matching ---
+// Aho-Corasick automaton compiled to a dense DFA: bytes are first mapped to classes (all
+// bytes that appear in no pattern share one class), and each state's row holds the next
+// state for every class, premultiplied by the row width so a step is one load. States
+// that end a pattern, directly or through a shorter suffix, are flagged in the table
+// itself. All matches are reported, including overlapping ones; empty patterns never match.
+struct PatternMatch {
+    size_t pattern_id; // Index into the pattern list
+    size_t offset;     // Start of the match in the haystack (or stream)
+};
+
+class MultiPatternMatcher {
+public:
+    // Scan position for input that arrives in chunks; start with a default-constructed one
+    struct StreamState {
+        unsigned int state = 0;
+        size_t consumed = 0; // Bytes seen so far, so offsets are relative to the whole stream
+    };
+
+    MultiPatternMatcher() : class_count_(1), transitions_(1, 0), byte_class_{} {}
+    explicit MultiPatternMatcher(const std::vector<std::string>& patterns);
+
+    size_t pattern_count() const { return pattern_lengths_.size(); }
+    size_t state_count() const { return transitions_.size() / class_count_; }
+
+    std::vector<PatternMatch> find_all(std::string_view haystack) const;
+    bool contains_any(std::string_view haystack) const;
+    void scan_chunk(StreamState& stream, std::string_view chunk, std::vector<PatternMatch>& out) const; // Appends to out
+
+    // Calls on_match(const PatternMatch&) for every match, in order of match end
+    template <typename Callback>
+    void scan(std::string_view haystack, Callback on_match) const {
+        StreamState stream;
+        scan_stream(stream, haystack, on_match);
+    }
+
+private:
+    static constexpr unsigned int MATCH_FLAG = 0x80000000u; // Set on transitions into output states
+    static constexpr unsigned int NO_STATE = 0xFFFFFFFFu;
+
+    template <typename Callback>
+    void scan_stream(StreamState& stream, std::string_view chunk, Callback& on_match) const {
+        const unsigned int* table = transitions_.data();
+        unsigned int state = stream.state;
+        for (size_t i = 0; i < chunk.size(); ++i) {
+            state = table[state + byte_class_[static_cast<unsigned char>(chunk[i])]];
+            if (state & MATCH_FLAG) {
+                state &= ~MATCH_FLAG;
+                report_matches(state, stream.consumed + i, on_match);
+            }
+        }
+        stream.state = state;
+        stream.consumed += chunk.size();
+    }
+
+    template <typename Callback>
+    void report_matches(unsigned int state, size_t end_pos, Callback& on_match) const {
+        for (unsigned int s = state / class_count_; s != NO_STATE; s = dict_link_[s]) {
+            for (unsigned int id = first_output_[s]; id != NO_STATE; id = next_output_[id]) {
+                PatternMatch match = {id, end_pos + 1 - pattern_lengths_[id]};
+                on_match(match);
+            }
+        }
+    }
+
+    unsigned int class_count_;                 // Row width of the transition table
+    std::vector<unsigned int> transitions_;    // state + class -> next state (premultiplied, flagged)
+    std::vector<unsigned int> dict_link_;      // Nearest proper suffix state with output (by state index)
+    std::vector<unsigned int> first_output_;   // First pattern ending exactly at each state
+    std::vector<unsigned int> next_output_;    // Next pattern ending at the same state (by pattern id)
+    std::vector<size_t> pattern_lengths_;
+    unsigned char byte_class_[256];
+};
+
+// --- Batch Rewriting ---
+// Applies many (from, to) rules in one pass. Where rules overlap, the leftmost match wins,
+// then the longest, then the earliest rule. Replacements are not rescanned.
+class StringRewriter {
+public:
+    explicit StringRewriter(const std::vector<std::pair<std::string, std::string>>& rules);
+
+    std::string rewrite(std::string_view str) const;
+    size_t rewrite_into(std::string_view str, char* out, size_t out_capacity) const; // Returns the required size; writes only if it fits
+    size_t rewrite_inplace(std::string& str) const; // Returns replacements made; no allocation unless a chosen replacement grows
+    size_t rule_count() const { return replacements_.size(); }
+
+private:
+    void select_matches(std::string_view str, std::vector<PatternMatch>& chosen) const;
+    size_t output_size(std::string_view str, const std::vector<PatternMatch>& chosen) const;
+    void write_output(std::string_view str, const std::vector<PatternMatch>& chosen, char* out) const;
+
+    MultiPatternMatcher matcher_;
+    std::vector<std::string> replacements_;
+    std::vector<size_t> pattern_lengths_;
+};
+
+// --- String Building ---
+// Appends into one growing buffer. Reserve an estimate of the final size up front and the
+// whole record is built with a single allocation. Numbers are formatted with std::to_chars
+// (locale-independent; floating point uses the shortest form that round-trips).
+class StringBuilder {
+public:
+    StringBuilder() {}
+    explicit StringBuilder(size_t estimated_size) { buffer_.reserve(estimated_size); }
+
+    StringBuilder& reserve(size_t estimated_size) { buffer_.reserve(estimated_size); return *this; } // Total, not additional
+    StringBuilder& append(std::string_view str) { buffer_.append(str.data(), str.size()); return *this; }
+    StringBuilder& append(char c) { buffer_.push_back(c); return *this; }
+    StringBuilder& append(int value);
+    StringBuilder& append(unsigned int value);
+    StringBuilder& append(long value);
+    StringBuilder& append(unsigned long value);
+    StringBuilder& append(long long value);
+    StringBuilder& append(unsigned long long value);
+    StringBuilder& append(float value);
+    StringBuilder& append(double value);
+
+    // Appends the parts of any range of strings, string_views or C strings with separator
+    // between them, growing the buffer at most once
+    template <typename Range>
+    StringBuilder& append_join(const Range& parts, std::string_view separator) {
+        size_t total = 0;
+        size_t count = 0;
+        for (const auto& part : parts) {
+            total += std::string_view(part).size();
+            ++count;
+        }
+        if (count > 1) total += separator.size() * (count - 1);
+        buffer_.reserve(buffer_.size() + total);
+        bool first = true;
+        for (const auto& part : parts) {
+            if (!first) append(separator);
+            append(std::string_view(part));
+            first = false;
+        }
+        return *this;
+    }
+
+    size_t size() const { return buffer_.size(); }
+    size_t capacity() const { return buffer_.capacity(); }
+    bool empty() const { return buffer_.empty(); }
+    void clear() { buffer_.clear(); } // Keeps the capacity for the next record
+    std::string_view view() const { return buffer_; }
+    const std::string& str() const { return buffer_; }
+    std::string release() { std::string out; out.swap(buffer_); return out; } // Moves the result out, leaves the builder empty
+
+private:
+    std::string buffer_;
+};
+
+// Joins any range of strings, string_views or C strings in exactly one allocation
+template <typename Range>
+std::string string_join_range(const Range& parts, std::string_view separator) {
+    StringBuilder builder;
+    builder.append_join(parts, separator);
+    return builder.release();
+}
+
+// --- Bulk Column Parsing ---
+// Parses every field of a text buffer straight into a typed vector (out is replaced).
+// Fields are separated by delimiter or '\n' and may carry surrounding whitespace (so CRLF
+// files work); blank lines are skipped. A field that fails to parse is stored as 0 and,
+// if errors is given, listed there; nothing throws. Returns the number of fields parsed
+// successfully. Buffers of 1 MB or more are parsed on num_threads threads (0 = all cores,
+// 1 = serial); the result is identical either way.
+struct ColumnParseError {
+    size_t field_index;    // Index in out
+    size_t offset;         // Byte offset of the field in the buffer
+    std::string_view text; // The field itself (points into the buffer)
+};
+
+size_t parse_int_column(std::string_view buffer, char delimiter, std::vector<int>& out,
+                        std::vector<ColumnParseError>* errors = nullptr, unsigned int num_threads = 0);
+size_t parse_long_column(std::string_view buffer, char delimiter, std::vector<long>& out,
+                         std::vector<ColumnParseError>* errors = nullptr, unsigned int num_threads = 0);
+size_t parse_float_column(std::string_view buffer, char delimiter, std::vector<float>& out,
+                          std::vector<ColumnParseError>* errors = nullptr, unsigned int num_threads = 0);
+size_t parse_double_column(std::string_view buffer, char delimiter, std::vector<double>& out,
+                           std::vector<ColumnParseError>* errors = nullptr, unsigned int num_threads = 0);
+
+// --- Delimited Record Reading ---
+// Reads CSV-style records into typed, contiguous columns. Quoting follows RFC 4180: a quoted
+// field may hold delimiters and newlines, and "" stands for one quote. Blank lines are
+// skipped and a trailing '\r' is dropped. A quote inside an unquoted field is a bad value;
+// if it leaves a quote open to the end of the input or for max_record_size bytes, its record
+// ends at its own newline instead. Files are read chunk_size bytes at a time, so input memory
+// stays bounded by one chunk plus max_record_size; the records of each chunk are parsed on
+// num_threads threads (0 = all cores, 1 = serial) with identical results.
+// A bad value is stored as 0 (or ""), a record with the wrong number of fields or longer than
+// max_record_size is stored as all 0/""; all are listed in errors() and reading goes on.
+enum class ColumnType { Int, Long, Float, Double, String };
+
+struct DelimitedOptions {
+    char delimiter = ',';
+    char quote = '"';
+    bool has_header = false;          // First record names the columns
+    size_t chunk_size = 1 << 20;      // Bytes per read
+    size_t max_record_size = 1 << 20; // Longer records are skipped and reported
+    unsigned int num_threads = 0;
+};
+
+struct DelimitedError {
+    size_t record;    // Data record index (the header is not counted)
+    size_t column;    // Column of the bad value, or npos for a wrong field count
+    std::string text; // The bad field, or the whole record (its first 64 bytes if too long)
+};
+
+class ColumnTable {
+public:
+    size_t row_count() const { return rows_; }
+    size_t column_count() const { return columns_.size(); }
+    ColumnType column_type(size_t column) const { return columns_[column].type; }
+    const std::string& column_name(size_t column) const { return columns_[column].name; } // Empty without a header
+
+    // The storage of a column of that type, ready for the array_* functions (empty for other types)
+    const std::vector<int>& int_column(size_t column) const { return columns_[column].ints; }
+    const std::vector<long>& long_column(size_t column) const { return columns_[column].longs; }
+    const std::vector<float>& float_column(size_t column) const { return columns_[column].floats; }
+    const std::vector<double>& double_column(size_t column) const { return columns_[column].doubles; }
+    std::string_view string_at(size_t column, size_t row) const; // Empty for non-string columns
+
+    const std::vector<DelimitedError>& errors() const { return errors_; }
+
+private:
+    friend class DelimitedReader;
+
+    struct Column {
+        ColumnType type = ColumnType::String;
+        std::string name;
+        std::vector<int> ints;
+        std::vector<long> longs;
+        std::vector<float> floats;
+        std::vector<double> doubles;
+        std::string arena;               // String values back to back
+        std::vector<size_t> offsets{0};  // Row r is arena[offsets[r], offsets[r + 1])
+    };
+
+    std::vector<Column> columns_;
+    size_t rows_ = 0;
+    std::vector<DelimitedError> errors_;
+};
+
+class DelimitedReader {
+public:
+    explicit DelimitedReader(std::vector<ColumnType> schema, DelimitedOptions options = DelimitedOptions());
+
+    bool read_file(const std::string& path, ColumnTable& table) const; // False if the file cannot be opened or read
+    void read_buffer(std::string_view data, ColumnTable& table) const;
+
+private:
+    // Where the record scan of one input stopped, kept across its chunks
+    struct RecordScan {
+        size_t scanned = 0;               // Bytes at the front of the buffer already scanned
+        unsigned long long in_quotes = 0; // All ones when the scan stopped inside quotes
+        bool skipping = false;            // Dropping the rest of a record past max_record_size
+    };
+
+    void reset(ColumnTable& table) const;
+    size_t parse_chunk(std::string_view data, bool final_chunk, ColumnTable& table, bool& header_pending, RecordScan& scan) const;
+
+    std::vector<ColumnType> schema_;
+    DelimitedOptions options_;
+};
+
+// --- Zero-Copy String Splitting ---
+// Tokens are std::string_view slices of the input: the input must outlive them.
+// Every delimiter ends a token, so "a,,b" gives {"a", "", "b"} and "a," gives {"a", ""};
+// an empty input gives no tokens. Pass skip_empty = true to drop empty tokens.
+
+// Set of delimiter bytes with a fast scan for the first member. Scans use SSE2/AVX2
+// kernels chosen at runtime; sets whose bytes span at most 8 distinct high nibbles
+// (any ASCII set) are matched 32 bytes at a time with a nibble shuffle lookup.
+class ByteSet {
+public:
+    ByteSet() : bits_{0, 0, 0, 0}, lo_nibbles_{}, hi_nibbles_{}, count_(0), single_(0), nibble_lookup_(false) {}
+    explicit ByteSet(std::string_view chars);
+
+    bool contains(unsigned char c) const { return (bits_[c >> 6] >> (c & 63)) & 1ULL; }
+    size_t size() const { return count_; } // Number of distinct bytes
+    size_t find_first_in(std::string_view str, size_t start_pos = 0) const; // std::string_view::npos if none
+
+private:
+    unsigned long long bits_[4];     // One bit per byte value
+    unsigned char lo_nibbles_[16];   // Shuffle lookup: byte b matches if lo[b & 15] & hi[b >> 4]
+    unsigned char hi_nibbles_[16];
+    size_t count_;
+    unsigned char single_;           // The only member when count_ == 1
+    bool nibble_lookup_;             // Tables above are usable
+};
+
+// Lazy split: tokens are produced one at a time while iterating and nothing is allocated.
+// Iterators refer to the range, so keep the range alive while iterating (a range-for
+// over string_split_range(...) does this automatically).
+class StringSplitRange {
+public:
+    class iterator {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef std::string_view value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const std::string_view* pointer;
+        typedef const std::string_view& reference;
+
+        iterator() : range_(nullptr), next_(0), done_(true) {}
+        reference operator*() const { return token_; }
+        pointer operator->() const { return &token_; }
+        iterator& operator++() { advance(); return *this; }
+        iterator operator++(int) { iterator old = *this; advance(); return old; }
+        bool operator==(const iterator& other) const {
+            return done_ == other.done_ && (done_ || (token_.data() == other.token_.data() && next_ == other.next_));
+        }
+        bool operator!=(const iterator& other) const { return !(*this == other); }
+
+    private:
+        friend class StringSplitRange;
+        explicit iterator(const StringSplitRange* range) : range_(range), next_(0), done_(false) { advance(); }
+        void advance();
+
+        const StringSplitRange* range_;
+        std::string_view token_;
+        size_t next_; // Start of the following token, npos after the last one
+        bool done_;
+    };
+
+    StringSplitRange(std::string_view str, std::string_view delimiters, bool skip_empty = false)
+        : str_(str), delimiters_(delimiters), skip_empty_(skip_empty) {}
+
+    iterator begin() const { return str_.empty() ? iterator() : iterator(this); }
+    iterator end() const { return iterator(); }
+
+private:
+    std::string_view str_;
+    ByteSet delimiters_;
+    bool skip_empty_;
+};
+
+std::vector<std::string_view> string_split_view(std::string_view str, char delimiter, bool skip_empty = false);
+std::vector<std::string_view> string_split_view(std::string_view str, std::string_view delimiters, bool skip_empty = false); // Any byte of delimiters splits
+StringSplitRange string_split_range(std::string_view str, char delimiter, bool skip_empty = false);
+StringSplitRange string_split_range(std::string_view str, std::string_view delimiters, bool skip_empty = false);
 
 // --- Memory Management Helpers ---
 void free_string(char* str);
@@ -130,11 +717,607 @@ void free_string_array(char** arr, size_t size);
 
 // --- Utility Functions ---
 void initialize_random();
+void seed_random(unsigned long long seed); // Deterministic seeding for reproducible runs
 int get_random_int(int min_val, int max_val); // Inclusive range
 float get_random_float(float min_val, float max_val); // Inclusive range approx
 double get_random_double(double min_val, double max_val); // Inclusive range approx
-std::chrono::high_resolution_clock::time_point start_timer();
-double stop_timer(std::chrono::high_resolution_clock::time_point start_time); // Returns elapsed seconds
+std::chrono::steady_clock::time_point start_timer(); // Monotonic: clock adjustments don't affect it
+double stop_timer(std::chrono::steady_clock::time_point start_time); // Returns elapsed seconds
+
+// --- Cycle Timer ---
+// For regions too short for start_timer. Where the CPU's time-stamp counter is invariant
+// (it ticks at a constant rate in every power state, in step on all cores), the TSC is read
+// with fences so the region's instructions cannot drift across the reads; elsewhere
+// steady_clock nanoseconds stand in for cycles. Tick rates are measured against
+// steady_clock from program start, and fixed on the first conversion.
+unsigned long long start_cycles(); // Reads the counter once earlier instructions have finished
+unsigned long long stop_cycles();  // Reads the counter once the timed region has finished
+double cycles_to_ns(unsigned long long cycles);
+double cycles_per_ns();            // 1.0 without an invariant TSC
+bool cycle_timer_uses_tsc();
+
+// --- Hardware Performance Counters ---
+// Linux perf_event_open counters for the calling thread, user space only, opened as one
+// group so they all cover the same instructions. A counter the kernel refuses (no PMU in
+// a VM, perf_event_paranoid, a container's seccomp filter) reads as -1; with none open,
+// available() is false and start()/stop() do nothing. Counts are scaled up when the kernel
+// had to multiplex the group with other users of the PMU.
+struct PerfCounts {
+    double cycles = -1.0;
+    double instructions = -1.0;
+    double l1d_misses = -1.0;    // L1 data cache read misses
+    double llc_misses = -1.0;    // Last-level cache misses
+    double branch_misses = -1.0;
+    double page_faults = -1.0;   // A software event: available even without a PMU
+
+    PerfCounts per_operation(double operations) const; // Available counts divided by operations
+    double ipc() const;          // Instructions per cycle; -1 unless both are available
+};
+
+class PerfCounterGroup {
+public:
+    PerfCounterGroup();
+    ~PerfCounterGroup();
+    PerfCounterGroup(const PerfCounterGroup&) = delete;
+    PerfCounterGroup& operator=(const PerfCounterGroup&) = delete;
+
+    bool available() const { return count_ > 0; }
+    bool has_hardware_counters() const { return hardware_; } // False when only page faults could be opened
+    void start();     // Zeroes and enables the counters
+    PerfCounts stop(); // Disables and reads them
+
+private:
+    static const int MAX_COUNTERS = 6;
+    int fds_[MAX_COUNTERS];
+    int fields_[MAX_COUNTERS]; // Which PerfCounts member each fd fills
+    int count_ = 0;
+    bool hardware_ = false;
+};
+
+// --- Allocation Tracking ---
+// Opt-in: build atomix.cpp with -DATOMIX_TRACK_ALLOCATIONS and it replaces the global
+// operator new/delete with versions that count into per-thread totals (no locks, no shared
+// cache lines). An AllocationScope then reports what the calling thread allocated since the
+// scope began, Atomix calls included. Without the flag the totals stay zero. A
+// CountingResource counts what pmr containers allocate through it in either build.
+struct AllocationStats {
+    unsigned long long allocations = 0;
+    unsigned long long deallocations = 0;
+    unsigned long long bytes = 0; // Requested by the allocations
+};
+
+bool allocation_tracking_enabled(); // True when atomix.cpp was built with ATOMIX_TRACK_ALLOCATIONS
+AllocationStats thread_allocation_stats(); // Running totals for the calling thread
+
+class AllocationScope {
+public:
+    AllocationScope() : start_(thread_allocation_stats()) {}
+    AllocationStats stats() const; // Since construction, on this thread
+
+private:
+    AllocationStats start_;
+};
+
+class CountingResource : public std::pmr::memory_resource {
+public:
+    explicit CountingResource(std::pmr::memory_resource* upstream = std::pmr::get_default_resource());
+    AllocationStats stats() const;
+    void reset();
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+    std::pmr::memory_resource* upstream_;
+    std::atomic<unsigned long long> allocations_{0};
+    std::atomic<unsigned long long> deallocations_{0};
+    std::atomic<unsigned long long> bytes_{0};
+};
+
+// --- Microbenchmarks ---
+// Barriers that stop the optimizer from deleting benchmarked work: do_not_optimize(x)
+// makes x look read (and, for non-const x, possibly written); clobber_memory() makes all
+// memory look read and written, so stores before it cannot be dropped.
+#if defined(__GNUC__) || defined(__clang__)
+template <typename T>
+inline void do_not_optimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+template <typename T>
+inline void do_not_optimize(T& value) {
+    asm volatile("" : "+m"(value) : : "memory");
+}
+
+inline void clobber_memory() {
+    asm volatile("" : : : "memory");
+}
+#else
+void benchmark_escape(const void* p); // Defined out of line so the compiler must assume it reads *p
+
+template <typename T>
+inline void do_not_optimize(const T& value) {
+    benchmark_escape(&value);
+}
+
+inline void clobber_memory() {
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+}
+#endif
+
+struct BenchmarkOptions {
+    double min_sample_seconds = 0.01; // Iterations per sample grow until a sample takes this long
+    double warmup_seconds = 0.05;     // Run untimed this long first (caches, branch predictors, clocks)
+    size_t samples = 30;
+    double max_seconds = 5.0;         // Stop taking samples past this (at least 3 are kept)
+    double outlier_iqr = 1.5;         // Drop samples outside the quartiles by this many IQRs; 0 keeps all
+    bool perf_counters = false;       // Also count hardware events over the samples (see PerfCounterGroup)
+};
+
+struct BenchmarkResult {
+    std::string name;
+    size_t iterations = 0; // Per sample
+    size_t samples = 0;    // After outlier rejection
+    size_t outliers = 0;
+    double min_ns = 0.0;   // Per iteration, over the kept samples
+    double median_ns = 0.0;
+    double mean_ns = 0.0;
+    double p99_ns = 0.0;
+    double max_ns = 0.0;
+    double items_per_second = 0.0; // 0 unless items per iteration were given
+    double bytes_per_second = 0.0; // 0 unless bytes per iteration were given
+    PerfCounts counters;           // Per iteration; -1 unless counted (BenchmarkOptions::perf_counters)
+    double allocations = -1.0;     // Per iteration; -1 unless built with ATOMIX_TRACK_ALLOCATIONS
+    double allocated_bytes = -1.0;
+};
+
+struct BenchmarkComparison {
+    std::string name;
+    double baseline_ns = 0.0; // Median per iteration; 0 when the benchmark is missing on that side
+    double current_ns = 0.0;
+    double change = 0.0;      // current / baseline - 1: +0.10 is 10% slower
+    double baseline_allocations = -1.0; // Per iteration; -1 where not tracked
+    double current_allocations = -1.0;
+};
+
+class BenchmarkRunner {
+public:
+    explicit BenchmarkRunner(BenchmarkOptions options = BenchmarkOptions());
+
+    // Times fn(), called repeatedly; items and bytes are per call and give the throughput.
+    // The result is also appended to results().
+    template <typename Fn>
+    BenchmarkResult run(const std::string& name, Fn&& fn, double items = 0.0, double bytes = 0.0) {
+        auto batch = [](void* context, size_t iterations) {
+            Fn& body = *static_cast<std::remove_reference_t<Fn>*>(context);
+            for (size_t i = 0; i < iterations; ++i) {
+                body();
+            }
+        };
+        return run_batches(name, batch, const_cast<void*>(static_cast<const void*>(&fn)), items, bytes);
+    }
+
+    const std::vector<BenchmarkResult>& results() const { return results_; }
+    void clear() { results_.clear(); }
+    std::string to_json() const;
+    bool write_json(const std::string& path) const;
+
+private:
+    BenchmarkResult run_batches(const std::string& name, void (*batch)(void*, size_t), void* context,
+                                double items, double bytes);
+
+    BenchmarkOptions options_;
+    std::vector<BenchmarkResult> results_;
+};
+
+void print_benchmark_result(const BenchmarkResult& result);
+bool parse_benchmark_json(std::string_view json, std::vector<BenchmarkResult>& out); // Reads to_json() output
+bool read_benchmark_json(const std::string& path, std::vector<BenchmarkResult>& out);
+// Pairs results by name, in baseline order, then any new benchmarks
+std::vector<BenchmarkComparison> compare_benchmarks(const std::vector<BenchmarkResult>& baseline,
+                                                    const std::vector<BenchmarkResult>& current);
+
+// --- Latency Histograms ---
+// HdrHistogram-style log-linear buckets: values from 0 to highest are kept to within
+// significant_digits decimal digits of precision (3 digits: within 0.1%) in a fixed array,
+// so recording is O(1) and never allocates, and memory depends only on the range and
+// precision (about 270 KB for an hour in nanoseconds at 3 digits). Values above highest are
+// clamped to it. Any unit works; ScopedLatency records nanoseconds.
+struct HistogramLayout {
+    HistogramLayout(unsigned long long highest, int significant_digits);
+    size_t index_of(unsigned long long value) const;          // Counts slot of a value (clamped)
+    unsigned long long lowest_at(size_t index) const;         // Smallest value counted in a slot
+    unsigned long long highest_at(size_t index) const;        // Largest value counted in a slot
+    bool operator==(const HistogramLayout& other) const {
+        return highest == other.highest && significant_digits == other.significant_digits;
+    }
+
+    unsigned long long highest;
+    int significant_digits;
+    int sub_bucket_half_count_magnitude; // log2 of the slots per bucket after the first
+    unsigned long long sub_bucket_mask;
+    size_t slots;
+};
+
+class LatencyHistogram {
+public:
+    explicit LatencyHistogram(unsigned long long highest = 3600ULL * 1000000000ULL, int significant_digits = 3);
+
+    void record(unsigned long long value, unsigned long long count = 1);
+    bool merge(const LatencyHistogram& other); // Re-buckets when the layouts differ; false only on a count overflow
+    void reset();
+
+    unsigned long long count() const { return total_; }
+    unsigned long long min() const { return total_ ? min_ : 0; }
+    unsigned long long max() const { return max_; }
+    double mean() const;
+    unsigned long long value_at_percentile(double percentile) const; // percentile in [0, 100]; 0 when empty
+    const HistogramLayout& layout() const { return layout_; }
+
+private:
+    friend class ConcurrentLatencyHistogram;
+    HistogramLayout layout_;
+    std::vector<unsigned long long> counts_;
+    unsigned long long total_ = 0;
+    unsigned long long min_ = ~0ULL;
+    unsigned long long max_ = 0;
+};
+
+// The same histogram for many recording threads at once: counts are atomics, so record()
+// is lock-free. snapshot() copies the counts while recording continues; the copy may miss
+// a few values recorded during it but never invents one.
+class ConcurrentLatencyHistogram {
+public:
+    explicit ConcurrentLatencyHistogram(unsigned long long highest = 3600ULL * 1000000000ULL, int significant_digits = 3);
+
+    void record(unsigned long long value, unsigned long long count = 1);
+    LatencyHistogram snapshot() const;
+    void reset(); // Not atomic with concurrent record() calls
+    unsigned long long count() const { return total_.load(std::memory_order_relaxed); }
+
+private:
+    HistogramLayout layout_;
+    std::unique_ptr<std::atomic<unsigned long long>[]> counts_;
+    std::atomic<unsigned long long> total_{0};
+    std::atomic<unsigned long long> min_{~0ULL};
+    std::atomic<unsigned long long> max_{0};
+};
+
+// Records the nanoseconds between construction and destruction (cycle timer) into a
+// LatencyHistogram or ConcurrentLatencyHistogram: { ScopedLatency timed(histogram); ... }
+template <typename Histogram>
+class ScopedLatency {
+public:
+    explicit ScopedLatency(Histogram& histogram) : histogram_(histogram), start_(start_cycles()) {}
+    ~ScopedLatency() {
+        histogram_.record(static_cast<unsigned long long>(cycles_to_ns(stop_cycles() - start_)));
+    }
+    ScopedLatency(const ScopedLatency&) = delete;
+    ScopedLatency& operator=(const ScopedLatency&) = delete;
+
+private:
+    Histogram& histogram_;
+    unsigned long long start_;
+};
+
+void print_latency_histogram(const LatencyHistogram& histogram, const char* unit = "ns"); // Count, mean and tail percentiles
+
+// --- Profiling Zones ---
+// A ScopedZone records its scope's start and end (cycle timer ticks) into a ring owned by
+// the calling thread. Each ring has one writer (its thread) and one reader (the drain), so
+// recording takes no lock, and nothing is allocated after a thread's first zone. When a
+// ring is full, new events are dropped and counted rather than blocking. Zone names are not
+// copied: use string literals or names that outlive the trace. Profiling is off by default;
+// a zone then costs one relaxed atomic load.
+class ScopedZone {
+public:
+    explicit ScopedZone(const char* name);
+    ~ScopedZone();
+    ScopedZone(const ScopedZone&) = delete;
+    ScopedZone& operator=(const ScopedZone&) = delete;
+
+private:
+    const char* name_; // nullptr while profiling is disabled
+    unsigned long long start_;
+};
+
+struct ProfileEvent {
+    const char* name;
+    unsigned long long start_cycles;
+    unsigned long long end_cycles;
+    unsigned int thread_id; // 1 for the first thread that recorded a zone, then 2, 3, ...
+};
+
+void set_profiling_enabled(bool enabled);
+bool profiling_enabled();
+size_t drain_profile_events(std::vector<ProfileEvent>& out); // Appends events recorded since the last drain
+size_t profile_events_dropped(); // Events lost to full rings so far
+
+// Streams drained events to a Chrome trace-event JSON file, which chrome://tracing and the
+// Perfetto UI open directly. flush() drains on demand; a background flush drains on an
+// interval from its own thread. Every drain takes all threads' events, so use one writer.
+struct TraceWriterState; // Defined in atomix.cpp
+
+class TraceWriter {
+public:
+    explicit TraceWriter(const std::string& path);
+    ~TraceWriter(); // Stops the background flush, flushes and closes
+    TraceWriter(const TraceWriter&) = delete;
+    TraceWriter& operator=(const TraceWriter&) = delete;
+
+    bool is_open() const;
+    size_t flush(); // Returns the events written
+    void start_background_flush(std::chrono::milliseconds interval = std::chrono::milliseconds(100));
+    void stop_background_flush();
+    bool close();   // Flushes and completes the JSON; false on a write error
+
+private:
+    std::unique_ptr<TraceWriterState> state_;
+};
+
+// --- Random Distribution Functions ---
+unsigned long long get_random_u64(); // 64 raw random bits from the global engine
+double get_random_normal(double mean = 0.0, double stddev = 1.0); // Gaussian (Ziggurat method)
+double get_random_exponential(double lambda = 1.0); // Exponential with rate lambda (Ziggurat method)
+int get_random_poisson(double mean); // Poisson with the given mean (mean >= 0)
+bool fill_random_normal(double *out, size_t count, double mean = 0.0, double stddev = 1.0);
+bool fill_random_normal_float(float *out, size_t count, float mean = 0.0f, float stddev = 1.0f);
+bool fill_random_exponential(double *out, size_t count, double lambda = 1.0);
+bool fill_random_exponential_float(float *out, size_t count, float lambda = 1.0f);
+bool fill_random_poisson(int *out, size_t count, double mean);
+
+// --- Streaming Sampling (header-only templates) ---
+// One-pass samplers for streams too large to hold in memory. Each sampler owns its
+// engine (seeded from the global engine unless a seed is given), so one sampler per
+// thread needs no locking; combine them afterwards with merge().
+
+// Uniform sample of up to `capacity` items (Li's Algorithm L). After the reservoir
+// fills, the sampler jumps straight to the next item to keep, so the number of random
+// draws grows with capacity * log(seen / capacity) instead of with the stream length.
+template <typename T>
+class ReservoirSampler {
+public:
+    explicit ReservoirSampler(size_t capacity)
+        : ReservoirSampler(capacity, get_random_u64()) {}
+
+    ReservoirSampler(size_t capacity, unsigned long long seed)
+        : capacity_(capacity), seen_(0), next_(0), w_(0.0), rng_(seed) {
+        reservoir_.reserve(capacity);
+    }
+
+    void offer(const T& item) {
+        offer(&item, 1);
+    }
+
+    void offer(const T *items, size_t count) {
+        if (items == nullptr) return;
+        size_t i = 0;
+        // Fill phase: keep everything until the reservoir is full
+        while (i < count && reservoir_.size() < capacity_) {
+            reservoir_.push_back(items[i]);
+            ++seen_;
+            ++i;
+            if (reservoir_.size() == capacity_) {
+                start_skipping();
+            }
+        }
+        if (capacity_ == 0 || i == count) {
+            seen_ += count - i;
+            return;
+        }
+        // Skip phase: only touch the items Algorithm L selects
+        const unsigned long long base = seen_;
+        const unsigned long long end = seen_ + (count - i);
+        while (next_ < end) {
+            reservoir_[random_index()] = items[i + static_cast<size_t>(next_ - base)];
+            w_ *= std::exp(std::log(uniform_open()) / static_cast<double>(capacity_));
+            next_ += skip_length() + 1;
+        }
+        seen_ = end;
+    }
+
+    void offer(const std::vector<T>& items) {
+        offer(items.data(), items.size());
+    }
+
+    // Combines another sampler's reservoir as if both streams had been offered here.
+    // Returns false (and changes nothing) if the capacities differ.
+    bool merge(const ReservoirSampler& other) {
+        if (other.capacity_ != capacity_) return false;
+        if (other.seen_ == 0) return true;
+
+        std::vector<T> mine(std::move(reservoir_));
+        std::vector<T> theirs(other.reservoir_);
+        unsigned long long n_mine = seen_, n_theirs = other.seen_;
+        const unsigned long long total = seen_ + other.seen_;
+        const size_t keep = static_cast<size_t>(std::min<unsigned long long>(capacity_, total));
+
+        // Hypergeometric draw: each slot comes from a stream in proportion to the
+        // items of that stream not yet represented, then a random survivor of it.
+        reservoir_.clear();
+        reservoir_.reserve(capacity_);
+        for (size_t j = 0; j < keep; ++j) {
+            bool take_mine = (theirs.empty()) ||
+                (!mine.empty() && uniform_open() * static_cast<double>(n_mine + n_theirs) <= static_cast<double>(n_mine));
+            std::vector<T>& from = take_mine ? mine : theirs;
+            size_t pick = static_cast<size_t>(rng_() % from.size());
+            reservoir_.push_back(std::move(from[pick]));
+            from[pick] = std::move(from.back());
+            from.pop_back();
+            --(take_mine ? n_mine : n_theirs);
+        }
+        seen_ = total;
+        if (total >= capacity_ && capacity_ > 0) {
+            // The skip state only depends on W, the largest kept key, which is the
+            // capacity-th order statistic of `total` uniforms: Beta(capacity, total - capacity + 1).
+            std::gamma_distribution<double> ga(static_cast<double>(capacity_), 1.0);
+            std::gamma_distribution<double> gb(static_cast<double>(total - capacity_ + 1), 1.0);
+            double a = ga(rng_), b = gb(rng_);
+            w_ = a / (a + b);
+            next_ = seen_ + skip_length();
+        }
+        return true;
+    }
+
+    const std::vector<T>& sample() const { return reservoir_; }
+    size_t capacity() const { return capacity_; }
+    unsigned long long seen() const { return seen_; }
+
+    void clear() {
+        reservoir_.clear();
+        seen_ = 0;
+        next_ = 0;
+        w_ = 0.0;
+    }
+
+private:
+    // Uniform double in (0, 1], safe for std::log
+    double uniform_open() {
+        return static_cast<double>((rng_() >> 11) + 1) * (1.0 / 9007199254740992.0);
+    }
+
+    size_t random_index() {
+        return static_cast<size_t>(rng_() % capacity_);
+    }
+
+    // Number of items to pass over before the next replacement
+    unsigned long long skip_length() {
+        double skip = std::floor(std::log(uniform_open()) / std::log1p(-w_));
+        const double max_skip = 4.0e18; // Saturate instead of overflowing on W ~ 0
+        return (skip >= max_skip || skip != skip) ? static_cast<unsigned long long>(max_skip)
+                                                  : static_cast<unsigned long long>(skip);
+    }
+
+    void start_skipping() {
+        w_ = std::exp(std::log(uniform_open()) / static_cast<double>(capacity_));
+        next_ = seen_ + skip_length();
+    }
+
+    size_t capacity_;
+    unsigned long long seen_; // Items offered so far
+    unsigned long long next_; // Stream index of the next item to keep
+    double w_;                // Algorithm L threshold
+    std::mt19937_64 rng_;
+    std::vector<T> reservoir_;
+};
+
+// Weighted sample without replacement of up to `capacity` items (Efraimidis & Spirakis
+// A-ExpJ). Item i gets key u^(1/w_i) and the largest keys are kept; exponential jumps
+// skip whole runs of items by accumulated weight, so most items cost one subtraction.
+// Keys are stored as logarithms to stay accurate for very large or very small weights.
+template <typename T>
+class WeightedReservoirSampler {
+public:
+    explicit WeightedReservoirSampler(size_t capacity)
+        : WeightedReservoirSampler(capacity, get_random_u64()) {}
+
+    WeightedReservoirSampler(size_t capacity, unsigned long long seed)
+        : capacity_(capacity), seen_(0), jump_(0.0), rng_(seed) {
+        heap_.reserve(capacity);
+    }
+
+    // Items with a weight that is not positive and finite are ignored
+    void offer(const T& item, double weight) {
+        offer(&item, &weight, 1);
+    }
+
+    void offer(const T *items, const double *weights, size_t count) {
+        if (items == nullptr || weights == nullptr) return;
+        for (size_t i = 0; i < count; ++i) {
+            const double w = weights[i];
+            ++seen_;
+            if (!(w > 0.0) || w == std::numeric_limits<double>::infinity() || capacity_ == 0) {
+                continue;
+            }
+            if (heap_.size() < capacity_) {
+                push(std::log(uniform_open()) / w, items[i]);
+                if (heap_.size() == capacity_) {
+                    draw_jump();
+                }
+                continue;
+            }
+            jump_ -= w;
+            if (jump_ > 0.0) {
+                continue; // Skipped by the exponential jump
+            }
+            // The new key is drawn conditioned on beating the current minimum
+            const double min_log_key = heap_.front().first;
+            const double t = std::exp(min_log_key * w);
+            const double r = t + (1.0 - t) * uniform_open();
+            pop();
+            push(std::log(r) / w, items[i]);
+            draw_jump();
+        }
+    }
+
+    void offer(const std::vector<T>& items, const std::vector<double>& weights) {
+        offer(items.data(), weights.data(), std::min(items.size(), weights.size()));
+    }
+
+    // Keys from independent samplers are directly comparable: keep the overall largest
+    void merge(const WeightedReservoirSampler& other) {
+        for (const Entry& e : other.heap_) {
+            if (heap_.size() < capacity_) {
+                push(e.first, e.second);
+            } else if (capacity_ > 0 && e.first > heap_.front().first) {
+                pop();
+                push(e.first, e.second);
+            }
+        }
+        seen_ += other.seen_;
+        if (capacity_ > 0 && heap_.size() == capacity_) {
+            draw_jump(); // Memoryless: a fresh jump from the new threshold is exact
+        }
+    }
+
+    std::vector<T> sample() const {
+        std::vector<T> out;
+        out.reserve(heap_.size());
+        for (const Entry& e : heap_) out.push_back(e.second);
+        return out;
+    }
+
+    size_t capacity() const { return capacity_; }
+    unsigned long long seen() const { return seen_; }
+
+    void clear() {
+        heap_.clear();
+        seen_ = 0;
+        jump_ = 0.0;
+    }
+
+private:
+    typedef std::pair<double, T> Entry; // (log key, item)
+
+    static bool key_greater(const Entry& a, const Entry& b) { return a.first > b.first; }
+
+    double uniform_open() {
+        return static_cast<double>((rng_() >> 11) + 1) * (1.0 / 9007199254740992.0);
+    }
+
+    void push(double log_key, const T& item) {
+        heap_.emplace_back(log_key, item);
+        std::push_heap(heap_.begin(), heap_.end(), key_greater); // Min-heap on key
+    }
+
+    void pop() {
+        std::pop_heap(heap_.begin(), heap_.end(), key_greater);
+        heap_.pop_back();
+    }
+
+    void draw_jump() {
+        const double min_log_key = heap_.front().first;
+        jump_ = (min_log_key < 0.0) ? std::log(uniform_open()) / min_log_key
+                                    : std::numeric_limits<double>::infinity();
+    }
+
+    size_t capacity_;
+    unsigned long long seen_;
+    double jump_; // Weight still to pass before the next insertion
+    std::mt19937_64 rng_;
+    std::vector<Entry> heap_;
+};
 
 
 #endif // ATOMIX_H
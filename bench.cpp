@@ -0,0 +1,745 @@
+// bench.cpp
+// Throughput benchmarks for Atomix Library
+
+#include "atomix.h" // Include the library header
+#include <iostream>
+#include <iomanip>   // For std::setw, std::setprecision
+#include <vector>
+#include <string>
+#include <string_view>
+#include <random>    // std::normal_distribution etc. as the baseline
+#include <algorithm> // std::shuffle as the baseline
+#include <cstring>   // memchr as the baseline
+#include <cctype>    // std::tolower as the baseline
+#include <stdexcept> // std::stod's exceptions as the baseline
+#include <fstream>   // std::getline over a file as the baseline
+#include <cstdio>    // Temporary benchmark files
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>   // open, to redirect stdin for the input benchmark
+#include <unistd.h>  // dup, dup2
+#endif
+
+// Use standard namespace for brevity
+using namespace std;
+
+// Keeps the compiler from discarding benchmark results
+static volatile double bench_sink = 0.0;
+
+// --- Helper Function ---
+void print_bench_result(const string& bench_name, size_t items, double seconds) {
+    double rate = (seconds > 0.0) ? items / seconds / 1e6 : 0.0;
+    cout << left << setw(48) << bench_name << right << fixed << setprecision(2)
+         << setw(10) << seconds * 1e3 << " ms" << setw(12) << rate << " M items/s" << endl;
+}
+
+// --- Benchmark Functions ---
+
+void bench_random_distributions() {
+    cout << "\n--- Random Distributions (Atomix Ziggurat vs <random>) ---" << endl;
+    const size_t n = 10000000;
+    vector<double> d_buf(n);
+    vector<int> i_buf(n);
+    mt19937 std_engine(12345);
+
+    // Normal
+    auto start = start_timer();
+    fill_random_normal(d_buf.data(), n);
+    print_bench_result("fill_random_normal", n, stop_timer(start));
+    bench_sink = bench_sink + d_buf[n / 2];
+
+    start = start_timer();
+    for (size_t i = 0; i < n; ++i) d_buf[i] = get_random_normal();
+    print_bench_result("get_random_normal (per call)", n, stop_timer(start));
+    bench_sink = bench_sink + d_buf[n / 2];
+
+    normal_distribution<double> std_normal(0.0, 1.0);
+    start = start_timer();
+    for (size_t i = 0; i < n; ++i) d_buf[i] = std_normal(std_engine);
+    print_bench_result("std::normal_distribution", n, stop_timer(start));
+    bench_sink = bench_sink + d_buf[n / 2];
+
+    // Exponential
+    start = start_timer();
+    fill_random_exponential(d_buf.data(), n, 1.0);
+    print_bench_result("fill_random_exponential", n, stop_timer(start));
+    bench_sink = bench_sink + d_buf[n / 2];
+
+    exponential_distribution<double> std_exp(1.0);
+    start = start_timer();
+    for (size_t i = 0; i < n; ++i) d_buf[i] = std_exp(std_engine);
+    print_bench_result("std::exponential_distribution", n, stop_timer(start));
+    bench_sink = bench_sink + d_buf[n / 2];
+
+    // Poisson (small mean uses inversion, large mean uses PTRS)
+    const double means[] = {4.0, 500.0};
+    for (double mean : means) {
+        string label = " (mean " + to_string(static_cast<int>(mean)) + ")";
+        start = start_timer();
+        fill_random_poisson(i_buf.data(), n, mean);
+        print_bench_result("fill_random_poisson" + label, n, stop_timer(start));
+        bench_sink = bench_sink + i_buf[n / 2];
+
+        poisson_distribution<int> std_pois(mean);
+        start = start_timer();
+        for (size_t i = 0; i < n; ++i) i_buf[i] = std_pois(std_engine);
+        print_bench_result("std::poisson_distribution" + label, n, stop_timer(start));
+        bench_sink = bench_sink + i_buf[n / 2];
+    }
+}
+
+void bench_parallel_shuffle() {
+    cout << "\n--- Parallel Shuffle (scaling and uniformity) ---" << endl;
+    const size_t n = 20000000;
+    vector<int> data(n);
+    for (size_t i = 0; i < n; ++i) data[i] = static_cast<int>(i);
+
+    mt19937_64 std_engine(12345);
+    auto start = start_timer();
+    shuffle(data.begin(), data.end(), std_engine);
+    print_bench_result("std::shuffle (serial)", n, stop_timer(start));
+
+    const unsigned int thread_counts[] = {1, 2, 4, 8};
+    for (unsigned int threads : thread_counts) {
+        start = start_timer();
+        array_parallel_shuffle_int(data.data(), n, 99, threads);
+        print_bench_result("array_parallel_shuffle_int (" + to_string(threads) + " threads)", n, stop_timer(start));
+    }
+
+    // Uniformity: element i starts in block i*B/n; after a uniform shuffle every
+    // (source block, destination block) cell should hold ~n/B^2 elements.
+    const size_t blocks = 16;
+    for (size_t i = 0; i < n; ++i) data[i] = static_cast<int>(i);
+    array_parallel_shuffle_int(data.data(), n, 2024);
+    vector<double> cells(blocks * blocks, 0.0);
+    for (size_t pos = 0; pos < n; ++pos) {
+        size_t src_block = static_cast<size_t>(data[pos]) * blocks / n;
+        size_t dst_block = pos * blocks / n;
+        cells[src_block * blocks + dst_block] += 1.0;
+    }
+    double expected = static_cast<double>(n) / (blocks * blocks);
+    double chi2 = 0.0;
+    for (double c : cells) chi2 += (c - expected) * (c - expected) / expected;
+    // (blocks-1)^2 = 225 degrees of freedom: mean 225, 99.9% quantile ~ 300
+    cout << "Uniformity chi-square (225 dof, expect < 300): " << fixed << setprecision(1) << chi2
+         << (chi2 < 300.0 ? "  OK" : "  SUSPICIOUS") << endl;
+}
+
+void bench_string_split() {
+    cout << "\n--- String Splitting (1KB log line) ---" << endl;
+    string line;
+    while (line.size() < 1024) line += "field" + to_string(line.size()) + ",";
+    const size_t reps = 200000;
+    size_t total = 0;
+
+    auto start = start_timer();
+    for (size_t r = 0; r < reps; ++r) total += string_split(line, ',').size();
+    print_bench_result("string_split (std::string tokens)", reps, stop_timer(start));
+
+    start = start_timer();
+    for (size_t r = 0; r < reps; ++r) total += string_split_view(line, ',').size();
+    print_bench_result("string_split_view (string_view tokens)", reps, stop_timer(start));
+
+    start = start_timer();
+    for (size_t r = 0; r < reps; ++r) {
+        for (string_view token : string_split_range(line, ',')) total += token.size();
+    }
+    print_bench_result("string_split_range (lazy, no allocation)", reps, stop_timer(start));
+    bench_sink = bench_sink + static_cast<double>(total);
+}
+
+void bench_byte_scanning() {
+    cout << "\n--- Byte Scanning (64MB buffer, match at the end; rate in M bytes/s) ---" << endl;
+    const size_t n = 64 << 20;
+    string buf(n, 'a');
+    buf[n - 1] = ';';
+    size_t total = 0;
+
+    auto start = start_timer();
+    const void* hit = memchr(buf.data(), ';', n);
+    print_bench_result("memchr", n, stop_timer(start));
+    total += static_cast<const char*>(hit) - buf.data();
+
+    start = start_timer();
+    total += static_cast<size_t>(string_find_char(buf, ';'));
+    print_bench_result("string_find_char", n, stop_timer(start));
+
+    start = start_timer();
+    size_t scalar_pos = 0;
+    while (scalar_pos < n && buf[scalar_pos] != ',' && buf[scalar_pos] != ';' && buf[scalar_pos] != '\t') ++scalar_pos;
+    print_bench_result("scalar loop (3 delimiters)", n, stop_timer(start));
+    total += scalar_pos;
+
+    start = start_timer();
+    total += static_cast<size_t>(string_find_any_of(buf, ",;\t"));
+    print_bench_result("string_find_any_of (3 delimiters)", n, stop_timer(start));
+
+    start = start_timer();
+    total += buf.find_first_of(",;\t");
+    print_bench_result("std::string::find_first_of (3 delimiters)", n, stop_timer(start));
+    bench_sink = bench_sink + static_cast<double>(total);
+}
+
+void bench_case_conversion() {
+    cout << "\n--- Case Conversion (64MB mixed-case text; rate in M bytes/s) ---" << endl;
+    const size_t n = 64 << 20;
+    string text;
+    text.reserve(n);
+    while (text.size() < n) text += "Content-Type: Application/JSON; Charset=UTF-8\r\n";
+    text.resize(n);
+    string copy = text;
+
+    auto start = start_timer();
+    transform(copy.begin(), copy.end(), copy.begin(), [](unsigned char c) { return static_cast<char>(tolower(c)); });
+    print_bench_result("std::transform + std::tolower", n, stop_timer(start));
+
+    copy = text;
+    start = start_timer();
+    string_to_lower_inplace(copy);
+    print_bench_result("string_to_lower_inplace (ASCII)", n, stop_timer(start));
+
+    copy = text;
+    start = start_timer();
+    string_to_lower_inplace(copy, CaseMode::Utf8);
+    print_bench_result("string_to_lower_inplace (UTF-8 mode)", n, stop_timer(start));
+
+    string upper = string_to_upper(text);
+    start = start_timer();
+    bool same = string_equals_ignore_case(text, upper);
+    print_bench_result("string_equals_ignore_case", n, stop_timer(start));
+    bench_sink = bench_sink + (same ? 1.0 : 0.0) + copy[n / 2];
+}
+
+void bench_substring_search() {
+    cout << "\n--- Substring Search (64MB text; rate in M bytes/s) ---" << endl;
+    const size_t n = 64 << 20;
+    // Adversarial for a first-byte scan: 't' is everywhere, the needle appears only at the end
+    string text;
+    text.reserve(n);
+    while (text.size() < n) text += "the tiny tortoise trotted to town; ";
+    text.resize(n);
+    const string needles[] = {"token=", "token=5f3a9c1e-2b7d-4e8f-a6c0-91d2b3e4f5a6-deadbeef"};
+    for (const string& needle : needles) {
+        string hay = text + needle;
+        string label = " (" + to_string(needle.size()) + "-byte needle)";
+        auto start = start_timer();
+        size_t pos = hay.find(needle);
+        print_bench_result("std::string::find" + label, n, stop_timer(start));
+
+        Searcher searcher(needle);
+        start = start_timer();
+        size_t pos2 = searcher.find(hay);
+        print_bench_result("Searcher::find" + label, n, stop_timer(start));
+        bench_sink = bench_sink + static_cast<double>(pos + pos2);
+    }
+
+    string tokens;
+    while (tokens.size() < n) tokens += "key=value; token=abc; ";
+    auto start = start_timer();
+    size_t found = string_count_substring(tokens, "token=");
+    print_bench_result("string_count_substring (" + to_string(found) + " hits)", tokens.size(), stop_timer(start));
+}
+
+void bench_multi_pattern() {
+    cout << "\n--- Multi-Pattern Matching (20k keywords over 64MB; rate in M bytes/s) ---" << endl;
+    mt19937_64 rng(7);
+    vector<string> keywords(20000);
+    for (string& keyword : keywords) {
+        keyword.resize(6 + rng() % 10);
+        for (char& c : keyword) c = static_cast<char>('a' + rng() % 26);
+    }
+    auto start = start_timer();
+    MultiPatternMatcher matcher(keywords);
+    double build = stop_timer(start);
+    cout << "Build: " << fixed << setprecision(2) << build * 1e3 << " ms, " << matcher.state_count() << " states" << endl;
+
+    const size_t n = 64 << 20;
+    string text(n, ' ');
+    for (size_t i = 0; i < n; ++i) {
+        text[i] = (i % 8 == 7) ? ' ' : static_cast<char>('a' + rng() % 26);
+    }
+    for (size_t i = 0; i + 64 < n; i += n / 1000) text.replace(i, keywords[i % 20000].size(), keywords[i % 20000]);
+
+    start = start_timer();
+    size_t hits = matcher.find_all(text).size();
+    print_bench_result("MultiPatternMatcher::find_all (" + to_string(hits) + " hits)", n, stop_timer(start));
+
+    start = start_timer();
+    size_t naive_hits = 0;
+    for (size_t k = 0; k < 100; ++k) naive_hits += string_count_substring(text, keywords[k]);
+    double naive = stop_timer(start);
+    print_bench_result("string_count_substring x100 keywords", n, naive);
+    cout << "(projected for all 20k keywords: " << naive * 200 << " s)" << endl;
+    bench_sink = bench_sink + static_cast<double>(hits + naive_hits);
+}
+
+void bench_replace() {
+    cout << "\n--- Replace (16MB text; rate in M bytes/s) ---" << endl;
+    const size_t n = 16 << 20;
+    string text;
+    text.reserve(n);
+    while (text.size() < n) text += "GET /index.html?user=alice&lang=en HTTP/1.1 ";
+
+    // The chained find/substring/concat idiom the replace functions supersede, on a 1/64 slice
+    string slice = text.substr(0, n / 64);
+    auto start = start_timer();
+    string chained = slice;
+    long long pos = string_find_substring(chained, "&");
+    while (pos >= 0) {
+        chained = string_concat(string_concat(string_substring(chained, 0, static_cast<size_t>(pos)), "&amp;"),
+                                string_substring(chained, static_cast<size_t>(pos) + 1));
+        pos = string_find_substring(chained, "&", static_cast<size_t>(pos) + 5);
+    }
+    print_bench_result("find/substring/concat loop (1/64 of input)", slice.size(), stop_timer(start));
+
+    start = start_timer();
+    string replaced = string_replace_all(text, "&", "&amp;");
+    print_bench_result("string_replace_all", n, stop_timer(start));
+
+    string copy = text;
+    start = start_timer();
+    string_replace_all_inplace(copy, "HTTP/1.1", "H/1");
+    print_bench_result("string_replace_all_inplace (shrinking)", n, stop_timer(start));
+
+    StringRewriter escaper({{"&", "&amp;"}, {"<", "&lt;"}, {">", "&gt;"}, {"\"", "&quot;"}});
+    start = start_timer();
+    string escaped = escaper.rewrite(text);
+    print_bench_result("StringRewriter::rewrite (4 rules)", n, stop_timer(start));
+    bench_sink = bench_sink + static_cast<double>(chained.size() + replaced.size() + copy.size() + escaped.size());
+}
+
+void bench_string_building() {
+    cout << "\n--- String Building (1M output records) ---" << endl;
+    const size_t records = 1000000;
+    vector<string> fields = {"2024-01-01T12:00:00Z", "INFO", "worker-3", "request completed", "200"};
+    size_t total = 0;
+
+    auto start = start_timer();
+    for (size_t r = 0; r < records; ++r) {
+        string line = fields[0] + "," + fields[1] + "," + fields[2] + "," + fields[3] + "," + to_string(r) + "," + to_string(r * 0.5);
+        total += line.size();
+    }
+    print_bench_result("operator+ and std::to_string", records, stop_timer(start));
+
+    start = start_timer();
+    for (size_t r = 0; r < records; ++r) total += string_join(fields, ",").size();
+    print_bench_result("string_join (pre-sized)", records, stop_timer(start));
+
+    StringBuilder builder(128);
+    start = start_timer();
+    for (size_t r = 0; r < records; ++r) {
+        builder.clear(); // Capacity is kept, so no allocation after the first record
+        builder.append_join(fields, ",").append(',').append(static_cast<unsigned long long>(r)).append(',').append(r * 0.5);
+        total += builder.size();
+    }
+    print_bench_result("StringBuilder (reused buffer, to_chars)", records, stop_timer(start));
+    bench_sink = bench_sink + static_cast<double>(total);
+}
+
+void bench_number_parsing() {
+    cout << "\n--- Number Parsing (1M fields, 5% malformed) ---" << endl;
+    const size_t n = 1000000;
+    vector<string> fields(n);
+    mt19937_64 rng(11);
+    for (size_t i = 0; i < n; ++i) {
+        fields[i] = (rng() % 20 == 0) ? "n/a" : to_string(static_cast<double>(rng() % 1000000) / 100.0);
+    }
+    size_t ok = 0;
+    double sum = 0.0;
+
+    // The previous implementation: trimmed copy, then std::stod with exceptions for bad input
+    auto start = start_timer();
+    for (const string& field : fields) {
+        try {
+            size_t pos;
+            string trimmed = string_trim(field);
+            double d = stod(trimmed, &pos);
+            if (pos == trimmed.size()) { sum += d; ++ok; }
+        } catch (const exception&) {
+        }
+    }
+    print_bench_result("string_trim + std::stod + try/catch", n, stop_timer(start));
+
+    start = start_timer();
+    for (const string& field : fields) {
+        double d;
+        if (string_to_double(field, &d)) { sum += d; ++ok; }
+    }
+    print_bench_result("string_to_double (from_chars)", n, stop_timer(start));
+
+    start = start_timer();
+    for (const string& field : fields) {
+        int v;
+        if (string_to_int(field, &v)) { sum += v; ++ok; }
+    }
+    print_bench_result("string_to_int (from_chars)", n, stop_timer(start));
+    bench_sink = bench_sink + sum + static_cast<double>(ok);
+}
+
+void bench_column_parsing() {
+    cout << "\n--- Column Parsing (2M fields, rates are MB/s of text) ---" << endl;
+    const size_t n = 2000000;
+    string ints, doubles;
+    mt19937_64 rng(13);
+    for (size_t i = 0; i < n; ++i) {
+        const char* sep = (i % 10 == 9) ? "\n" : ",";
+        ints += to_string(static_cast<long long>(rng() % 2000000000) - 1000000000) + sep;
+        doubles += to_string(static_cast<double>(rng() % 100000000) / 1000.0) + sep;
+    }
+    double sum = 0.0;
+
+    // The usual idiom: split into strings, then convert each one
+    auto start = start_timer();
+    for (const string& line : string_split(doubles, '\n')) {
+        for (const string& field : string_split(line, ',')) {
+            double d;
+            if (string_to_double(field, &d)) sum += d;
+        }
+    }
+    print_bench_result("string_split + string_to_double", doubles.size(), stop_timer(start));
+
+    vector<double> d_out;
+    start = start_timer();
+    parse_double_column(doubles, ',', d_out, nullptr, 1);
+    print_bench_result("parse_double_column (serial)", doubles.size(), stop_timer(start));
+
+    start = start_timer();
+    parse_double_column(doubles, ',', d_out);
+    print_bench_result("parse_double_column (all cores)", doubles.size(), stop_timer(start));
+    sum += d_out.empty() ? 0.0 : d_out.back();
+
+    start = start_timer();
+    for (string_view field : string_split_view(ints, ",\n")) {
+        int v;
+        if (string_to_int(field, &v)) sum += v;
+    }
+    print_bench_result("string_split_view + string_to_int", ints.size(), stop_timer(start));
+
+    vector<int> i_out;
+    start = start_timer();
+    parse_int_column(ints, ',', i_out, nullptr, 1);
+    print_bench_result("parse_int_column (serial, SWAR digits)", ints.size(), stop_timer(start));
+
+    start = start_timer();
+    parse_int_column(ints, ',', i_out);
+    print_bench_result("parse_int_column (all cores)", ints.size(), stop_timer(start));
+    bench_sink = bench_sink + sum + (i_out.empty() ? 0 : i_out.back());
+}
+
+// Times the getline + string_split idiom and DelimitedReader on the same file
+static void bench_delimited_file(const string& label, const string& text, const vector<ColumnType>& schema) {
+    const string path = "atomix_bench_records.csv";
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file == nullptr) return;
+    fwrite(text.data(), 1, text.size(), file);
+    fclose(file);
+    double sum = 0.0;
+
+    auto start = start_timer();
+    ifstream in(path);
+    string line;
+    while (getline(in, line)) {
+        vector<string> fields = string_split(line, ',');
+        for (size_t c = 0; c < fields.size() && c < schema.size(); ++c) {
+            double d;
+            if (schema[c] != ColumnType::String && string_to_double(fields[c], &d)) sum += d;
+        }
+    }
+    print_bench_result(label + ": getline + string_split", text.size(), stop_timer(start));
+
+    ColumnTable table;
+    DelimitedOptions serial;
+    serial.num_threads = 1;
+    start = start_timer();
+    DelimitedReader(schema, serial).read_file(path, table);
+    print_bench_result(label + ": DelimitedReader (serial)", text.size(), stop_timer(start));
+
+    start = start_timer();
+    DelimitedReader(schema).read_file(path, table);
+    print_bench_result(label + ": DelimitedReader (all cores)", text.size(), stop_timer(start));
+    bench_sink = bench_sink + sum + static_cast<double>(table.row_count());
+    remove(path.c_str());
+}
+
+void bench_delimited_reader() {
+    cout << "\n--- Delimited Records (rates are MB/s of file) ---" << endl;
+    mt19937_64 rng(17);
+    // Narrow: 2 numeric columns, 1M records
+    string narrow;
+    for (int i = 0; i < 1000000; ++i) {
+        narrow += to_string(rng() % 1000000) + "," + to_string(static_cast<double>(rng() % 100000) / 100.0) + "\n";
+    }
+    bench_delimited_file("narrow (2 cols)", narrow, {ColumnType::Int, ColumnType::Double});
+
+    // Wide: 24 mixed columns with some quoted strings, 100k records
+    vector<ColumnType> wide_schema;
+    for (int c = 0; c < 24; ++c) {
+        wide_schema.push_back(c % 4 == 0 ? ColumnType::Long : c % 4 == 1 ? ColumnType::Double : c % 4 == 2 ? ColumnType::Float : ColumnType::String);
+    }
+    string wide;
+    for (int i = 0; i < 100000; ++i) {
+        for (int c = 0; c < 24; ++c) {
+            if (c) wide += ',';
+            switch (c % 4) {
+            case 0: wide += to_string(rng() % 10000000000ULL); break;
+            case 1: wide += to_string(static_cast<double>(rng() % 1000000) / 1000.0); break;
+            case 2: wide += to_string(static_cast<int>(rng() % 1000)) + ".5"; break;
+            default: wide += (rng() % 4 == 0) ? "\"name, quoted\"" : "name" + to_string(rng() % 1000); break;
+            }
+        }
+        wide += '\n';
+    }
+    bench_delimited_file("wide (24 cols)", wide, wide_schema);
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+// Points stdin at path (rewound to the start); returns the saved stdin to restore later
+static int redirect_stdin(const string& path) {
+    int saved = dup(STDIN_FILENO);
+    int fd = open(path.c_str(), O_RDONLY);
+    dup2(fd, STDIN_FILENO);
+    close(fd);
+    cin.clear();
+    return saved;
+}
+
+static void restore_stdin(int saved) {
+    dup2(saved, STDIN_FILENO);
+    close(saved);
+    cin.clear();
+}
+
+void bench_batch_input() {
+    cout << "\n--- Line Input (get_int over a 1M-line file) ---" << endl;
+    const size_t n = 1000000;
+    const string path = "atomix_bench_input.txt";
+    string text;
+    mt19937_64 rng(19);
+    for (size_t i = 0; i < n; ++i) text += to_string(static_cast<int>(rng() % 2000000) - 1000000) + "\n";
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file == nullptr) return;
+    fwrite(text.data(), 1, text.size(), file);
+    fclose(file);
+    long long sum = 0;
+
+    // Interactive mode: std::getline on std::cin (synced with stdio), as before
+    set_input_mode(InputMode::Interactive);
+    int saved = redirect_stdin(path);
+    auto start = start_timer();
+    for (size_t i = 0; i < n; ++i) sum += get_int();
+    print_bench_result("get_int (Interactive: std::getline)", n, stop_timer(start));
+    restore_stdin(saved);
+
+    set_input_mode(InputMode::Batch);
+    saved = redirect_stdin(path);
+    start = start_timer();
+    for (size_t i = 0; i < n; ++i) sum += get_int();
+    print_bench_result("get_int (Batch: buffered read())", n, stop_timer(start));
+
+    restore_stdin(saved);
+    set_input_mode(InputMode::Auto);
+
+    {
+        MappedFileSource mapped(path);
+        set_input_source(&mapped);
+        start = start_timer();
+        for (size_t i = 0; i < n; ++i) sum += get_int();
+        print_bench_result("get_int (MappedFileSource)", n, stop_timer(start));
+        set_input_source(nullptr);
+    }
+    bench_sink = bench_sink + static_cast<double>(sum);
+    remove(path.c_str());
+}
+#endif
+
+void bench_bulk_input() {
+    cout << "\n--- Bulk Input (1M integers from a MemorySource) ---" << endl;
+    const size_t n = 1000000;
+    string one_per_line, many_per_line;
+    mt19937_64 rng(23);
+    for (size_t i = 0; i < n; ++i) {
+        string value = to_string(static_cast<int>(rng() % 2000000) - 1000000);
+        one_per_line += value + "\n";
+        many_per_line += value + (i % 1000 == 999 ? "\n" : " ");
+    }
+    long long sum = 0;
+
+    MemorySource lines(one_per_line);
+    set_input_source(&lines);
+    auto start = start_timer();
+    for (size_t i = 0; i < n; ++i) sum += get_int();
+    print_bench_result("get_int per line", n, stop_timer(start));
+
+    vector<int> values;
+    MemorySource tokens(many_per_line);
+    set_input_source(&tokens);
+    start = start_timer();
+    get_ints(values, n);
+    print_bench_result("get_ints (1000 per line)", n, stop_timer(start));
+
+    lines.rewind();
+    set_input_source(&lines);
+    start = start_timer();
+    get_ints(values, n);
+    print_bench_result("get_ints (one per line)", n, stop_timer(start));
+    set_input_source(nullptr);
+    for (int v : values) sum += v;
+    bench_sink = bench_sink + static_cast<double>(sum);
+}
+
+void bench_timers() {
+    cout << "\n--- Timers (1M start/stop pairs) ---" << endl;
+    const size_t n = 1000000;
+    double total_seconds = 0.0;
+    auto start = start_timer();
+    for (size_t i = 0; i < n; ++i) {
+        auto t = start_timer();
+        total_seconds += stop_timer(t);
+    }
+    print_bench_result("start_timer + stop_timer (steady_clock)", n, stop_timer(start));
+
+    unsigned long long total_cycles = 0;
+    start = start_timer();
+    for (size_t i = 0; i < n; ++i) {
+        unsigned long long c = start_cycles();
+        total_cycles += stop_cycles() - c;
+    }
+    print_bench_result(cycle_timer_uses_tsc() ? "start_cycles + stop_cycles (TSC)" : "start_cycles + stop_cycles (steady_clock)",
+                       n, stop_timer(start));
+    cout << "empty region: " << fixed << setprecision(1) << total_seconds * 1e9 / n << " ns (steady_clock), "
+         << cycles_to_ns(total_cycles) / n << " ns (cycles)" << endl;
+    bench_sink = bench_sink + total_seconds + static_cast<double>(total_cycles);
+}
+
+void bench_profiling_zones() {
+    cout << "\n--- Profiling Zones (1M empty zones) ---" << endl;
+    const size_t n = 1000000;
+    vector<ProfileEvent> events;
+    events.reserve(8192);
+    auto start = start_timer();
+    for (size_t i = 0; i < n; ++i) {
+        ScopedZone zone("bench");
+    }
+    print_bench_result("ScopedZone (profiling disabled)", n, stop_timer(start));
+
+    set_profiling_enabled(true);
+    start = start_timer();
+    for (size_t i = 0; i < n; ++i) {
+        ScopedZone zone("bench");
+        if ((i & 4095) == 4095) { // Drain before the ring fills, as a flushing thread would
+            events.clear();
+            drain_profile_events(events);
+        }
+    }
+    print_bench_result("ScopedZone (enabled, drained every 4096)", n, stop_timer(start));
+    set_profiling_enabled(false);
+    events.clear();
+    drain_profile_events(events);
+    bench_sink = bench_sink + static_cast<double>(events.size() + profile_events_dropped());
+}
+
+void bench_latency_histograms() {
+    cout << "\n--- Latency Histograms (10M recordings + p99) ---" << endl;
+    const size_t n = 10000000;
+    vector<unsigned long long> samples(n);
+    mt19937_64 rng(31);
+    lognormal_distribution<double> latency(9.0, 1.0); // ~8 us median, long tail
+    for (size_t i = 0; i < n; ++i) samples[i] = static_cast<unsigned long long>(latency(rng));
+
+    auto start = start_timer();
+    vector<unsigned long long> stored;
+    for (size_t i = 0; i < n; ++i) stored.push_back(samples[i]);
+    sort(stored.begin(), stored.end());
+    unsigned long long p99_sorted = stored[n * 99 / 100];
+    print_bench_result("vector + sort (baseline)", n, stop_timer(start));
+
+    LatencyHistogram histogram;
+    start = start_timer();
+    for (size_t i = 0; i < n; ++i) histogram.record(samples[i]);
+    unsigned long long p99 = histogram.value_at_percentile(99.0);
+    print_bench_result("LatencyHistogram::record", n, stop_timer(start));
+
+    ConcurrentLatencyHistogram shared;
+    start = start_timer();
+    for (size_t i = 0; i < n; ++i) shared.record(samples[i]);
+    unsigned long long p99_shared = shared.snapshot().value_at_percentile(99.0);
+    print_bench_result("ConcurrentLatencyHistogram::record", n, stop_timer(start));
+    cout << "p99: " << p99_sorted << " (exact), " << p99 << ", " << p99_shared << endl;
+    bench_sink = bench_sink + static_cast<double>(p99 + p99_shared + p99_sorted);
+}
+
+void bench_allocation_tracking() {
+    cout << "\n--- Allocations per call (100k calls, 11-field line) ---" << endl;
+    if (!allocation_tracking_enabled()) {
+        cout << "(build atomix.cpp with -DATOMIX_TRACK_ALLOCATIONS to count allocations)" << endl;
+    }
+    const size_t n = 100000;
+    const string line = "  Alpha,Beta,Gamma,Delta,Epsilon,Zeta,Eta,Theta,Iota,Kappa,Lambda  ";
+    auto report = [n](const char* label, double seconds, const AllocationStats& stats) {
+        print_bench_result(label, n, seconds);
+        cout << "    " << static_cast<double>(stats.allocations) / n << " allocations, "
+             << static_cast<double>(stats.bytes) / n << " bytes per call" << endl;
+    };
+    size_t total = 0;
+    {
+        AllocationScope scope;
+        auto start = start_timer();
+        for (size_t i = 0; i < n; ++i) total += string_split(line, ',').size();
+        report("string_split", stop_timer(start), scope.stats());
+    }
+    {
+        AllocationScope scope;
+        auto start = start_timer();
+        for (size_t i = 0; i < n; ++i) {
+            for (string_view part : string_split_range(line, ',')) total += part.empty() ? 0 : 1;
+        }
+        report("string_split_range", stop_timer(start), scope.stats());
+    }
+    {
+        AllocationScope scope;
+        auto start = start_timer();
+        for (size_t i = 0; i < n; ++i) total += string_to_lower(line).size();
+        report("string_to_lower", stop_timer(start), scope.stats());
+    }
+    {
+        AllocationScope scope;
+        string lowered;
+        auto start = start_timer();
+        for (size_t i = 0; i < n; ++i) {
+            string_to_lower_into(line, lowered);
+            total += lowered.size();
+        }
+        report("string_to_lower_into (reused string)", stop_timer(start), scope.stats());
+    }
+    bench_sink = bench_sink + static_cast<double>(total);
+}
+
+// --- Main Function ---
+int main() {
+    cout << "===== Atomix Library Benchmarks =====" << endl;
+
+    initialize_random();
+
+    bench_random_distributions();
+    bench_parallel_shuffle();
+    bench_string_split();
+    bench_byte_scanning();
+    bench_case_conversion();
+    bench_substring_search();
+    bench_multi_pattern();
+    bench_replace();
+    bench_string_building();
+    bench_number_parsing();
+    bench_column_parsing();
+    bench_delimited_reader();
+    bench_bulk_input();
+    bench_timers();
+    bench_profiling_zones();
+    bench_latency_histograms();
+    bench_allocation_tracking();
+#if defined(__unix__) || defined(__APPLE__)
+    bench_batch_input();
+#endif
+
+    cout << "\n===== Benchmarks Finished =====" << endl;
+    return 0;
+}
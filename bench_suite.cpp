@@ -0,0 +1,489 @@
+// bench_suite.cpp
+// Regression benchmarks for Atomix Library: every API family over a range of input sizes
+// and data distributions, written as JSON and compared against a stored baseline.
+//
+// Usage: ./bench_suite [--max-size N] [--filter TEXT] [--json FILE] [--baseline FILE]
+//                      [--tolerance FRACTION] [--quick] [--perf]
+//   --max-size   Largest input, in elements (default 1e6; sizes go up by 10x from 1e3, to 1e9).
+//                The string and parse families stop at 1e7 (see TEXT_MAX_SIZE).
+//   --filter     Only run benchmarks whose name contains TEXT, e.g. "int/sort_array"
+//   --json       Write the results to FILE
+//   --baseline   Compare against results written earlier with --json
+//   --tolerance  Slowdown of the median that counts as a regression (default 0.10 = 10%)
+//   --quick      Fewer, shorter samples: for smoke runs, too noisy for baselines
+//   --perf       Also report hardware counters per call (Linux perf_event_open, if permitted)
+// Exit status: 0 on success, 1 if a benchmark regressed past the tolerance, 2 on bad
+// arguments or unreadable files.
+// Built with -DATOMIX_TRACK_ALLOCATIONS, the results also carry allocations per call, and a
+// benchmark that makes half an allocation per call more than its baseline is a regression too.
+
+#include "atomix.h" // Include the library header
+#include <iostream>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <random>    // Reproducible input data
+#include <algorithm> // std::sort for the sorted distribution
+#include <cstring>   // std::strcmp for argument parsing
+#include <cstdio>    // std::snprintf for the comparison table
+
+// Use standard namespace for brevity
+using namespace std;
+
+// --- Input Data ---
+enum class Distribution { Sorted, Random, Skewed, Duplicates };
+
+const Distribution ALL_DISTRIBUTIONS[] = {Distribution::Sorted, Distribution::Random, Distribution::Skewed,
+                                          Distribution::Duplicates};
+
+const char* distribution_name(Distribution d) {
+    switch (d) {
+        case Distribution::Sorted: return "sorted";
+        case Distribution::Random: return "random";
+        case Distribution::Skewed: return "skewed";
+        default: return "duplicates";
+    }
+}
+
+// Sorted and random: uniform over [-1e9, 1e9]. Skewed: magnitudes crowd towards zero
+// (u^4 scaling), with random signs. Duplicates: only 16 distinct values.
+vector<int> make_ints(size_t n, Distribution d, unsigned long long seed) {
+    mt19937_64 rng(seed);
+    uniform_real_distribution<double> unit(0.0, 1.0);
+    vector<int> values(n);
+    for (size_t i = 0; i < n; ++i) {
+        if (d == Distribution::Duplicates) {
+            values[i] = static_cast<int>(rng() % 16) * 1000;
+        } else if (d == Distribution::Skewed) {
+            double u = unit(rng);
+            int magnitude = static_cast<int>(u * u * u * u * 1e9);
+            values[i] = (rng() & 1) ? magnitude : -magnitude;
+        } else {
+            values[i] = static_cast<int>(rng() % 2000000001ULL) - 1000000000;
+        }
+    }
+    if (d == Distribution::Sorted) sort(values.begin(), values.end());
+    return values;
+}
+
+template <typename T>
+vector<T> to_floating(const vector<int>& ints) {
+    vector<T> values(ints.size());
+    for (size_t i = 0; i < ints.size(); ++i) values[i] = static_cast<T>(ints[i]) * static_cast<T>(0.001);
+    return values;
+}
+
+// Seven lowercase letters per value, in the same order as the values
+vector<string> to_words(const vector<int>& ints) {
+    vector<string> words(ints.size());
+    for (size_t i = 0; i < ints.size(); ++i) {
+        unsigned long long v = static_cast<unsigned long long>(static_cast<long long>(ints[i]) + 2147483648LL);
+        string word(7, 'a');
+        for (int k = 6; k >= 0; --k) {
+            word[k] = static_cast<char>('a' + v % 26);
+            v /= 26;
+        }
+        words[i] = word;
+    }
+    return words;
+}
+
+string join_lines(const vector<string>& fields, char separator) {
+    string text;
+    for (const string& f : fields) {
+        text += f;
+        text += separator;
+    }
+    return text;
+}
+
+// --- Suite ---
+// The string and parse benchmarks hold every element several times over as std::string
+// (words, a scratch copy, tokens, split results) plus the joined text: over 100 bytes per
+// element. At 1e8 that is more than 10 GB, so those families stop here.
+const size_t TEXT_MAX_SIZE = 10000000;
+
+struct SuiteConfig {
+    size_t max_size = 1000000;
+    string filter;
+    string json_path;
+    string baseline_path;
+    double tolerance = 0.10;
+    BenchmarkOptions options;
+};
+
+class Suite {
+public:
+    explicit Suite(const SuiteConfig& config) : config_(config), runner_(config.options) {}
+
+    bool wants(const string& name) const {
+        return config_.filter.empty() || name.find(config_.filter) != string::npos;
+    }
+
+    // Lets a group skip generating its input when none of its benchmarks is selected
+    bool wants_any(const string& prefix, initializer_list<const char*> functions, const string& suffix) const {
+        for (const char* f : functions) {
+            if (wants(prefix + f + suffix)) return true;
+        }
+        return false;
+    }
+
+    template <typename Fn>
+    void run(const string& name, Fn&& fn, double items, double bytes = 0.0) {
+        if (!wants(name)) return;
+        print_benchmark_result(runner_.run(name, fn, items, bytes));
+    }
+
+    const BenchmarkRunner& runner() const { return runner_; }
+
+private:
+    SuiteConfig config_;
+    BenchmarkRunner runner_;
+};
+
+// Sorting or reversing in place would change the input for the next iteration, so mutating
+// benchmarks copy into a scratch buffer first; the copy is part of what they time.
+void bench_int_functions(Suite& suite, size_t n, Distribution d) {
+    string suffix = string("/") + distribution_name(d) + "/" + to_string(n);
+    if (!suite.wants_any("int/", {"array_sum", "array_max", "array_contains_int", "array_count_occurrence",
+                                  "array_has_pair_sum", "array_has_pair_difference", "sort_array",
+                                  "array_unique_int", "array_reverse_int"}, suffix)) {
+        return;
+    }
+    vector<int> data = make_ints(n, d, 1000 + n);
+    vector<int> scratch(n);
+    const double bytes = static_cast<double>(n * sizeof(int));
+    suite.run("int/array_sum" + suffix, [&] {
+        long long sum = 0;
+        array_sum(data.data(), n, &sum);
+        do_not_optimize(sum);
+    }, n, bytes);
+    suite.run("int/array_max" + suffix, [&] {
+        int max_val = 0;
+        array_max(data.data(), n, &max_val);
+        do_not_optimize(max_val);
+    }, n, bytes);
+    suite.run("int/array_contains_int" + suffix, [&] {
+        bool found = array_contains_int(data.data(), n, 1000000001); // Absent: a full scan
+        do_not_optimize(found);
+    }, n, bytes);
+    suite.run("int/array_count_occurrence" + suffix, [&] {
+        size_t count = array_count_occurrence(data.data(), n, data[n / 2]);
+        do_not_optimize(count);
+    }, n, bytes);
+    suite.run("int/array_has_pair_sum" + suffix, [&] {
+        bool found = array_has_pair_sum(data.data(), n, 2000000001); // Out of reach: every element is visited
+        do_not_optimize(found);
+    }, n, bytes);
+    suite.run("int/array_has_pair_difference" + suffix, [&] {
+        bool found = array_has_pair_difference(data.data(), n, 2000000001);
+        do_not_optimize(found);
+    }, n, bytes);
+    suite.run("int/sort_array" + suffix, [&] {
+        copy(data.begin(), data.end(), scratch.begin());
+        sort_array(scratch.data(), n);
+        clobber_memory();
+    }, n, bytes);
+    suite.run("int/array_unique_int" + suffix, [&] {
+        size_t unique_size = 0;
+        int* unique = array_unique_int(data.data(), n, &unique_size);
+        do_not_optimize(unique_size);
+        delete[] unique;
+    }, n, bytes);
+    suite.run("int/array_reverse_int" + suffix, [&] {
+        array_reverse_int(scratch.data(), n);
+        clobber_memory();
+    }, n, bytes);
+}
+
+template <typename T>
+void bench_floating_functions(Suite& suite, const char* family, size_t n, Distribution d) {
+    string prefix = string(family) + "/";
+    string suffix = string("/") + distribution_name(d) + "/" + to_string(n);
+    if (!suite.wants_any(prefix, {"sum", "max", "index_of", "sort"}, suffix)) return;
+    vector<T> data = to_floating<T>(make_ints(n, d, 2000 + n));
+    vector<T> scratch(n);
+    const double bytes = static_cast<double>(n * sizeof(T));
+    suite.run(prefix + "sum" + suffix, [&] {
+        double sum = 0.0;
+        if constexpr (is_same<T, float>::value) array_sum_float(data, &sum);
+        else array_sum_double(data, &sum);
+        do_not_optimize(sum);
+    }, n, bytes);
+    suite.run(prefix + "max" + suffix, [&] {
+        T max_val = 0;
+        if constexpr (is_same<T, float>::value) array_max_float(data, &max_val);
+        else array_max_double(data, &max_val);
+        do_not_optimize(max_val);
+    }, n, bytes);
+    suite.run(prefix + "index_of" + suffix, [&] {
+        long long index;
+        if constexpr (is_same<T, float>::value) index = array_index_of_float(data, 7e6f); // Absent
+        else index = array_index_of_double(data, 7e6);
+        do_not_optimize(index);
+    }, n, bytes);
+    suite.run(prefix + "sort" + suffix, [&] {
+        copy(data.begin(), data.end(), scratch.begin());
+        if constexpr (is_same<T, float>::value) array_sort_float(scratch);
+        else array_sort_double(scratch);
+        clobber_memory();
+    }, n, bytes);
+}
+
+void bench_string_functions(Suite& suite, size_t n, Distribution d) {
+    string suffix = string("/") + distribution_name(d) + "/" + to_string(n);
+    if (!suite.wants_any("string/", {"array_sort_string", "string_split", "string_split_view", "string_join",
+                                     "string_to_lower", "string_find_substring", "string_replace_all"}, suffix)) {
+        return;
+    }
+    vector<string> words = to_words(make_ints(n, d, 3000 + n));
+    vector<string> scratch(n);
+    string text = join_lines(words, ',');
+    const double bytes = static_cast<double>(text.size());
+    suite.run("string/array_sort_string" + suffix, [&] {
+        copy(words.begin(), words.end(), scratch.begin());
+        array_sort_string(scratch);
+        clobber_memory();
+    }, n, bytes);
+    suite.run("string/string_split" + suffix, [&] {
+        vector<string> parts = string_split(text, ',');
+        do_not_optimize(parts.data());
+    }, n, bytes);
+    suite.run("string/string_split_view" + suffix, [&] {
+        vector<string_view> parts = string_split_view(text, ',');
+        do_not_optimize(parts.data());
+    }, n, bytes);
+    suite.run("string/string_join" + suffix, [&] {
+        string joined = string_join(words, ",");
+        do_not_optimize(joined.data());
+    }, n, bytes);
+    suite.run("string/string_to_lower" + suffix, [&] {
+        string lower = string_to_lower(text);
+        do_not_optimize(lower.data());
+    }, n, bytes);
+    suite.run("string/string_find_substring" + suffix, [&] {
+        long long pos = string_find_substring(text, "zzzzzzzz"); // Absent: at least 8 letters, never generated
+        do_not_optimize(pos);
+    }, n, bytes);
+    suite.run("string/string_replace_all" + suffix, [&] {
+        string replaced = string_replace_all(text, ",", ";\t");
+        do_not_optimize(replaced.data());
+    }, n, bytes);
+}
+
+void bench_parsing_functions(Suite& suite, size_t n, Distribution d) {
+    string suffix = string("/") + distribution_name(d) + "/" + to_string(n);
+    if (!suite.wants_any("parse/", {"string_to_int", "string_to_double", "parse_int_column",
+                                    "parse_double_column", "DelimitedReader"}, suffix)) {
+        return;
+    }
+    vector<int> ints = make_ints(n, d, 4000 + n);
+    vector<double> doubles = to_floating<double>(ints);
+    vector<string> int_tokens(n), double_tokens(n);
+    string csv;
+    for (size_t i = 0; i < n; ++i) {
+        int_tokens[i] = to_string(ints[i]);
+        double_tokens[i] = to_string(doubles[i]);
+        csv += int_tokens[i] + "," + double_tokens[i] + ",w" + to_string(ints[i] & 1023) + "\n";
+    }
+    string int_text = join_lines(int_tokens, '\n');
+    string double_text = join_lines(double_tokens, '\n');
+    vector<int> int_out;
+    vector<double> double_out;
+    suite.run("parse/string_to_int" + suffix, [&] {
+        long long sum = 0;
+        for (const string& token : int_tokens) {
+            int value = 0;
+            string_to_int(token, &value);
+            sum += value;
+        }
+        do_not_optimize(sum);
+    }, n, static_cast<double>(int_text.size()));
+    suite.run("parse/string_to_double" + suffix, [&] {
+        double sum = 0.0;
+        for (const string& token : double_tokens) {
+            double value = 0.0;
+            string_to_double(token, &value);
+            sum += value;
+        }
+        do_not_optimize(sum);
+    }, n, static_cast<double>(double_text.size()));
+    suite.run("parse/parse_int_column" + suffix, [&] {
+        parse_int_column(int_text, '\n', int_out, nullptr, 1);
+        do_not_optimize(int_out.data());
+    }, n, static_cast<double>(int_text.size()));
+    suite.run("parse/parse_double_column" + suffix, [&] {
+        parse_double_column(double_text, '\n', double_out, nullptr, 1);
+        do_not_optimize(double_out.data());
+    }, n, static_cast<double>(double_text.size()));
+    DelimitedOptions options;
+    options.num_threads = 1;
+    DelimitedReader reader({ColumnType::Int, ColumnType::Double, ColumnType::String}, options);
+    ColumnTable table;
+    suite.run("parse/DelimitedReader" + suffix, [&] {
+        reader.read_buffer(csv, table);
+        do_not_optimize(table.row_count());
+    }, n, static_cast<double>(csv.size()));
+}
+
+// Random numbers do not depend on the input distribution: sizes only
+void bench_random_functions(Suite& suite, size_t n) {
+    string suffix = "/" + to_string(n);
+    if (!suite.wants_any("random/", {"get_random_int", "fill_random_normal", "fill_random_exponential",
+                                     "fill_random_poisson", "array_shuffle_int", "array_parallel_shuffle_int"},
+                         suffix)) {
+        return;
+    }
+    vector<double> d_buf(n);
+    vector<int> i_buf = make_ints(n, Distribution::Random, 5000 + n);
+    const double bytes = static_cast<double>(n * sizeof(double));
+    suite.run("random/get_random_int" + suffix, [&] {
+        for (size_t i = 0; i < n; ++i) i_buf[i] = get_random_int(0, 1000);
+        clobber_memory();
+    }, n, static_cast<double>(n * sizeof(int)));
+    suite.run("random/fill_random_normal" + suffix, [&] {
+        fill_random_normal(d_buf.data(), n);
+        clobber_memory();
+    }, n, bytes);
+    suite.run("random/fill_random_exponential" + suffix, [&] {
+        fill_random_exponential(d_buf.data(), n, 1.0);
+        clobber_memory();
+    }, n, bytes);
+    suite.run("random/fill_random_poisson" + suffix, [&] {
+        fill_random_poisson(i_buf.data(), n, 4.0);
+        clobber_memory();
+    }, n, static_cast<double>(n * sizeof(int)));
+    suite.run("random/array_shuffle_int" + suffix, [&] {
+        array_shuffle_int(i_buf.data(), n);
+        clobber_memory();
+    }, n, static_cast<double>(n * sizeof(int)));
+    suite.run("random/array_parallel_shuffle_int" + suffix, [&] {
+        array_parallel_shuffle_int(i_buf.data(), n, 42);
+        clobber_memory();
+    }, n, static_cast<double>(n * sizeof(int)));
+}
+
+// --- Baseline Comparison ---
+// Prints every change and returns how many benchmarks slowed down past the tolerance or
+// started allocating more
+size_t report_comparison(const vector<BenchmarkResult>& baseline, const vector<BenchmarkResult>& current,
+                         double tolerance) {
+    cout << "\n--- Comparison with baseline (tolerance " << tolerance * 100 << "%) ---" << endl;
+    size_t regressions = 0;
+    char line[256];
+    for (const BenchmarkComparison& c : compare_benchmarks(baseline, current)) {
+        if (c.current_ns == 0.0) continue; // Not run this time (filtered out or retired)
+        const char* verdict = "";
+        if (c.baseline_ns == 0.0) {
+            verdict = "new";
+        } else if (c.change > tolerance) {
+            verdict = "REGRESSION";
+            ++regressions;
+        } else if (c.change < -tolerance) {
+            verdict = "improved";
+        }
+        bool allocations_tracked = c.baseline_allocations >= 0.0 && c.current_allocations >= 0.0;
+        if (allocations_tracked && c.current_allocations >= c.baseline_allocations + 0.5) {
+            if (c.change <= tolerance) ++regressions; // Count each benchmark once
+            verdict = "ALLOCATION REGRESSION";
+        }
+        snprintf(line, sizeof(line), "%-52s %12.1f ns %12.1f ns %+8.1f%%  %s", c.name.c_str(), c.baseline_ns,
+                 c.current_ns, c.change * 100.0, verdict);
+        cout << line;
+        if (allocations_tracked && c.current_allocations != c.baseline_allocations) {
+            snprintf(line, sizeof(line), " (allocations per call %.2f -> %.2f)", c.baseline_allocations,
+                     c.current_allocations);
+            cout << line;
+        }
+        cout << endl;
+    }
+    cout << regressions << " regression(s)" << endl;
+    return regressions;
+}
+
+// --- Main Function ---
+void print_usage() {
+    cerr << "Usage: bench_suite [--max-size N] [--filter TEXT] [--json FILE] [--baseline FILE]"
+            " [--tolerance FRACTION] [--quick] [--perf]" << endl;
+}
+
+int main(int argc, char** argv) {
+    SuiteConfig config;
+    config.options.samples = 15;
+    config.options.min_sample_seconds = 0.005;
+    config.options.warmup_seconds = 0.01;
+    config.options.max_seconds = 2.0;
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        double number = 0.0;
+        if (strcmp(arg, "--quick") == 0) {
+            config.options.samples = 5;
+            config.options.min_sample_seconds = 0.001;
+            config.options.warmup_seconds = 0.0;
+            config.options.max_seconds = 0.5;
+            continue;
+        }
+        if (strcmp(arg, "--perf") == 0) {
+            config.options.perf_counters = true;
+            continue;
+        }
+        if (value == nullptr) {
+            print_usage();
+            return 2;
+        }
+        ++i;
+        if (strcmp(arg, "--max-size") == 0 && string_to_double(value, &number) && number >= 1000 && number <= 1e9) {
+            config.max_size = static_cast<size_t>(number);
+        } else if (strcmp(arg, "--tolerance") == 0 && string_to_double(value, &number) && number >= 0) {
+            config.tolerance = number;
+        } else if (strcmp(arg, "--filter") == 0) {
+            config.filter = value;
+        } else if (strcmp(arg, "--json") == 0) {
+            config.json_path = value;
+        } else if (strcmp(arg, "--baseline") == 0) {
+            config.baseline_path = value;
+        } else {
+            print_usage();
+            return 2;
+        }
+    }
+
+    vector<BenchmarkResult> baseline;
+    if (!config.baseline_path.empty() && !read_benchmark_json(config.baseline_path, baseline)) {
+        return 2;
+    }
+
+    cout << "===== Atomix Benchmark Suite =====" << endl;
+    cout << "(name, then min / median / p99 per call)" << endl;
+    if (config.options.perf_counters && !PerfCounterGroup().has_hardware_counters()) {
+        cout << "(hardware counters unavailable: no PMU, or perf_event_paranoid forbids them)" << endl;
+    }
+    seed_random(12345);
+    if (config.max_size > TEXT_MAX_SIZE) {
+        cout << "(string/ and parse/ benchmarks stop at " << TEXT_MAX_SIZE << " elements: larger inputs do not fit in memory)"
+             << endl;
+    }
+    Suite suite(config);
+    for (size_t n = 1000; n <= config.max_size; n *= 10) {
+        for (Distribution d : ALL_DISTRIBUTIONS) {
+            bench_int_functions(suite, n, d);
+            bench_floating_functions<float>(suite, "float", n, d);
+            bench_floating_functions<double>(suite, "double", n, d);
+            if (n <= TEXT_MAX_SIZE) {
+                bench_string_functions(suite, n, d);
+                bench_parsing_functions(suite, n, d);
+            }
+        }
+        bench_random_functions(suite, n);
+    }
+
+    if (!config.json_path.empty() && !suite.runner().write_json(config.json_path)) {
+        return 2;
+    }
+    if (!config.baseline_path.empty() &&
+        report_comparison(baseline, suite.runner().results(), config.tolerance) > 0) {
+        return 1;
+    }
+    return 0;
+}
@@ -5,13 +5,20 @@
 #include <iostream>
 #include <vector>
 #include <string>
+#include <string_view> // For string_split_view results
 #include <cmath>     // For fabs, NAN
 #include <limits>    // For numeric_limits
 #include <cassert>   // For basic assertions (optional, can use if/else)
 #include <cstring>   // For memcmp
 #include <thread>    // For std::this_thread::sleep_for (testing timer)
+#include <atomic>    // Counting diagnostics from several threads
 #include <chrono>    // For std::chrono::milliseconds
 #include <algorithm> // For std::sort, std::equal (used in unique test)
+#include <fstream>   // Reading back the trace file
+#include <sstream>   // std::stringstream for whole-file reads
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>  // pipe, dup2 to feed stdin in the batch input test
+#endif
 
 // Use standard namespace for brevity
 using namespace std;
@@ -89,6 +96,187 @@ void test_get_functions_interactive() {
 
 // --- Automated Test Functions ---
 
+// Runs every get_* function, retries included, over scripted input instead of the keyboard
+void test_get_functions() {
+    const char script[] =
+        "hello world\n"           // get_string
+        "ab\nx\n"                 // get_char: two characters, then one
+        "abc\n 42 \n"             // get_int: not a number, then padded
+        "99999999999999999999\n-5\n" // get_long: out of range, then valid
+        "1e39\n2.5\n"             // get_float: overflow, then valid
+        "nan\n-0.125\n"           // get_double: NaN is rejected
+        "11\n0\n7\n"              // get_int_range(1, 10)
+        "\n\nfilled\n"            // get_string_non_empty
+        "12";                     // get_int on a last line without '\n'
+    MemorySource source(script);
+    set_input_source(&source);
+    bool source_ok = &get_input_source() == &source && !source.interactive();
+    string s = get_string();
+    char c = get_char();
+    int i = get_int();
+    long l = get_long();
+    float f = get_float();
+    double d = get_double();
+    int r = get_int_range("Rating", 1, 10);
+    string ne = get_string_non_empty();
+    int last = get_int();
+    bool before_eof = !cin.eof();
+    int at_eof = get_int();
+    bool eof_ok = at_eof == 0 && cin.eof();
+    print_test_result("get_* over MemorySource", source_ok && s == "hello world" && c == 'x' && i == 42 && l == -5 &&
+                      f == 2.5f && d == -0.125 && r == 7 && ne == "filled" && last == 12 && before_eof && eof_ok);
+
+    // Bulk readers
+    MemorySource numbers("3\n10 -20\t30 99\n1.5, 2e3 ,-0.25\n7 8\n12 abc 13\n5 500\n");
+    set_input_source(&numbers);
+    int n_values = get_int();
+    vector<int> ints;
+    size_t got_ints = get_ints(ints, n_values); // "99" is on the third value's line and is dropped
+    vector<double> doubles;
+    size_t got_doubles = get_doubles(doubles, 3, ',');
+    long longs[4] = {0, 0, 0, 0};
+    size_t got_longs = get_longs(longs, 4); // Runs into "abc" after 7 8 12
+    bool bulk_ok = got_ints == 3 && ints == vector<int>({10, -20, 30}) && got_doubles == 3 &&
+                   doubles == vector<double>({1.5, 2000.0, -0.25}) && got_longs == 3 && longs[2] == 12 && longs[3] == 0;
+    vector<int> ranged;
+    size_t got_ranged = get_ints(ranged, 0, ' ', 1, 100); // 500 is out of range
+    vector<int> rest;
+    size_t got_rest = get_ints(rest); // Nothing left: stops at EOF without complaint
+    print_test_result("get_ints/get_longs/get_doubles", bulk_ok && got_ranged == 1 && ranged[0] == 5 && got_rest == 0 && cin.eof());
+
+    source.rewind();
+    set_input_source(&source); // Clears the EOF state left by the last source
+    print_test_result("MemorySource (rewind)", !cin.eof() && get_line_view() == "hello world");
+
+    const string path = "atomix_test_input.txt";
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file) {
+        fputs("3\r\n4\n\nend", file);
+        fclose(file);
+    }
+    {
+        MappedFileSource mapped(path);
+        set_input_source(&mapped);
+        int a = get_int();
+        int b = get_int();
+        string_view blank = get_line_view();
+        string_view end = get_line_view();
+        bool done = get_line_view().empty() && cin.eof();
+        print_test_result("get_* over MappedFileSource", mapped.is_open() && a == 3 && b == 4 && blank.empty() && end == "end" && done);
+        set_input_source(nullptr);
+    }
+    remove(path.c_str());
+    MappedFileSource missing("atomix_no_such_input.txt");
+    print_test_result("MappedFileSource (missing file)", !missing.is_open() && &get_input_source() != &source && !cin.eof());
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+// Batch input: feeds stdin from a pipe, so the get_* functions run without a keyboard
+void test_batch_input() {
+    const char script[] = "12\nabc\n  7 \nnot a number\n3.5\n\nx\nlast line";
+    int fds[2];
+    int saved_stdin = dup(STDIN_FILENO);
+    if (pipe(fds) != 0 || saved_stdin < 0) {
+        print_test_result("batch input (pipe setup)", false);
+        return;
+    }
+    bool written = write(fds[1], script, sizeof(script) - 1) == static_cast<ssize_t>(sizeof(script) - 1);
+    close(fds[1]);
+    dup2(fds[0], STDIN_FILENO);
+    close(fds[0]);
+
+    set_input_mode(InputMode::Batch);
+    bool mode_ok = get_input_mode() == InputMode::Batch;
+    int i = get_int();
+    string_view view = get_line_view();
+    bool view_ok = view == "abc";
+    long l = get_long();
+    double d = get_double(); // Skips "not a number" with a retry message
+    string non_empty = get_string_non_empty(); // Skips the blank line
+    string last = get_string();
+    bool last_ok = last == "last line" && !cin.eof();
+    string after_end = get_string();
+    bool eof_ok = after_end.empty() && cin.eof() && cin.fail();
+    cin.clear();
+
+    dup2(saved_stdin, STDIN_FILENO);
+    close(saved_stdin);
+    set_input_mode(InputMode::Auto);
+    print_test_result("batch input (get_* over a pipe)", written && mode_ok && i == 12 && view_ok && l == 7 && d == 3.5 &&
+                      non_empty == "x" && last_ok && eof_ok);
+}
+
+// Timed input: a pipe whose writer we control stands in for a stalled producer
+void test_timed_input() {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        print_test_result("timed input (pipe setup)", false);
+        return;
+    }
+    auto send = [&](const char* text) { return write(fds[1], text, strlen(text)) == static_cast<ssize_t>(strlen(text)); };
+    LineReader reader(fds[0]);
+    string_view line;
+    bool sent = send("first\npart");
+    bool first_ok = reader.read_line(line, chrono::steady_clock::now() + chrono::seconds(5)) == InputStatus::Ok && line == "first";
+    bool poll_waits = reader.poll_line(line) == InputStatus::Timeout; // "part" has no newline yet
+
+    auto start = chrono::steady_clock::now();
+    bool timed_out = reader.read_line(line, start + chrono::milliseconds(30)) == InputStatus::Timeout;
+    bool waited = chrono::steady_clock::now() - start >= chrono::milliseconds(30);
+
+    sent = send("ial\nx\ny\n") && sent;
+    vector<string> pumped;
+    InputStatus open_status = reader.pump([&](string_view l) { pumped.push_back(string(l)); });
+    close(fds[1]);
+    InputStatus end_status = reader.pump([&](string_view l) { pumped.push_back(string(l)); });
+    print_test_result("LineReader (deadline, poll, pump)", sent && first_ok && poll_waits && timed_out && waited &&
+                      open_status == InputStatus::Ok && end_status == InputStatus::Eof &&
+                      pumped == vector<string>({"partial", "x", "y"}));
+    close(fds[0]);
+
+    // get_* timeouts on stdin
+    int saved_stdin = dup(STDIN_FILENO);
+    if (pipe(fds) != 0 || saved_stdin < 0) {
+        print_test_result("timed get_* (pipe setup)", false);
+        return;
+    }
+    dup2(fds[0], STDIN_FILENO);
+    close(fds[0]);
+    set_input_source(nullptr);
+    int value = -1;
+    bool stdin_timeout = get_int(&value, chrono::milliseconds(20)) == InputStatus::Timeout && value == -1;
+    sent = send("oops\n 5 \n");
+    bool stdin_ok = get_int(&value, chrono::milliseconds(1000)) == InputStatus::Ok && value == 5; // Retries past "oops"
+    close(fds[1]);
+    double d = 0.0;
+    bool stdin_eof = get_double(&d, chrono::milliseconds(1000)) == InputStatus::Eof && cin.eof();
+    cin.clear();
+    dup2(saved_stdin, STDIN_FILENO);
+
+    // Interactive mode: an untimed read after a timed one goes on from the same buffer
+    bool mixed_ok = false;
+    if (pipe(fds) == 0) {
+        dup2(fds[0], STDIN_FILENO);
+        close(fds[0]);
+        set_input_mode(InputMode::Interactive);
+        sent = send("7\n8\n") && sent;
+        close(fds[1]);
+        mixed_ok = get_int(&value, chrono::milliseconds(1000)) == InputStatus::Ok && value == 7 && get_int() == 8;
+        set_input_mode(InputMode::Auto);
+        dup2(saved_stdin, STDIN_FILENO);
+    }
+    close(saved_stdin);
+
+    MemorySource memory("2.5\n");
+    set_input_source(&memory);
+    float f = 0.0f;
+    bool memory_ok = get_float(&f, chrono::milliseconds(0)) == InputStatus::Ok && f == 2.5f; // Buffered data never waits
+    set_input_source(nullptr);
+    print_test_result("timed get_* (timeout, retry, EOF)", sent && stdin_timeout && stdin_ok && stdin_eof && memory_ok);
+    print_test_result("timed get_* (then untimed, Interactive mode)", mixed_ok);
+}
+#endif
+
 void test_integer_array_functions() {
     cout << "\n--- Testing Integer Array Functions ---" << endl;
     int arr1[] = {5, -2, 10, 0, 5, 8};
@@ -194,6 +382,18 @@ void test_integer_array_functions() {
     print_test_result("array_shuffle_int (elements preserved)", shuf_before == shuf_after);
     // Note: Verifying *true* randomness is complex and beyond this basic test.
 
+    // Parallel shuffle: large enough to take the bucketed path
+    vector<int> big(300000);
+    for (size_t i = 0; i < big.size(); ++i) big[i] = static_cast<int>(i);
+    vector<int> big_a = big, big_b = big, big_c = big;
+    array_parallel_shuffle_int(big_a.data(), big_a.size(), 42, 1);
+    array_parallel_shuffle_int(big_b.data(), big_b.size(), 42, 4);
+    array_parallel_shuffle_int(big_c.data(), big_c.size(), 43, 4);
+    print_test_result("array_parallel_shuffle_int (same seed, any thread count)", big_a == big_b);
+    print_test_result("array_parallel_shuffle_int (different seed differs)", big_a != big_c && big_a != big);
+    sort(big_a.begin(), big_a.end());
+    print_test_result("array_parallel_shuffle_int (elements preserved)", big_a == big);
+
     // --- Printing ---
     cout << "array_print demo: ";
     print_array(arr_single, size_single); // Expected: [42]
@@ -306,6 +506,15 @@ void test_string_vector_functions() { // Renamed from test_string_array_function
     sort(s_shuf_after.begin(), s_shuf_after.end());
     print_test_result("array_shuffle_string (elements preserved)", s_shuf_before == s_shuf_after);
 
+    vector<string> s_big(300000);
+    for (size_t i = 0; i < s_big.size(); ++i) s_big[i] = to_string(i);
+    vector<string> s_big_shuf = s_big;
+    array_parallel_shuffle_string(s_big_shuf, 7);
+    bool s_moved = s_big_shuf != s_big;
+    sort(s_big_shuf.begin(), s_big_shuf.end());
+    sort(s_big.begin(), s_big.end());
+    print_test_result("array_parallel_shuffle_string (elements preserved)", s_moved && s_big_shuf == s_big);
+
     vector<string> s_cat1 = {"x"}, s_cat2 = {"y", "z"};
     vector<string> s_cat_res = array_concat_string(s_cat1, s_cat2); // Creates new vector
     print_test_result("array_concat_string", s_cat_res.size()==3 && s_cat_res[0]=="x" && s_cat_res[2]=="z");
@@ -364,6 +573,28 @@ void test_string_manipulation_functions() {
     // Case Conversion
     print_test_result("string_to_lower", string_to_lower("HeLLo") == "hello");
     print_test_result("string_to_upper", string_to_upper("HeLLo") == "HELLO");
+    string header = "Content-Type: Application/JSON; charset=UTF-8 [0x40 @ 0x5B [ 0x60 ` 0x7B {]";
+    string lowered = header;
+    string_to_lower_inplace(lowered);
+    print_test_result("string_to_lower_inplace (ASCII, long input)",
+                      lowered == "content-type: application/json; charset=utf-8 [0x40 @ 0x5b [ 0x60 ` 0x7b {]");
+    char buf[16] = "MiXeD";
+    string_to_upper_inplace(buf, 5);
+    string into;
+    string_to_lower_into("ABC", into);
+    print_test_result("string_to_*_inplace (char*) / _into", string(buf) == "MIXED" && into == "abc" &&
+                      string_to_upper_into("abc", buf, 2) == 0 && string_to_upper_into("abc", buf, 3) == 3);
+    print_test_result("string_to_upper (UTF-8 mode)",
+                      string_to_upper("straße ÿ ž ελλάς привет", CaseMode::Utf8) == "STRAßE Ÿ Ž ΕΛΛΆΣ ПРИВЕТ" &&
+                      string_to_upper("ÿ") == "ÿ"); // ASCII mode leaves non-ASCII bytes alone
+    print_test_result("string_to_lower (UTF-8 mode)", string_to_lower("ÀÉÎ ŁÓDŹ ΣΩ ЁЖ", CaseMode::Utf8) == "àéî łódź σω ёж");
+    print_test_result("string_equals_ignore_case", string_equals_ignore_case("Content-Length", "content-LENGTH") &&
+                      !string_equals_ignore_case("Content-Length", "Content-Lengt") && !string_equals_ignore_case("[", "{"));
+    print_test_result("string_starts_with_ignore_case", string_starts_with_ignore_case("Accept-Encoding: gzip", "ACCEPT-") &&
+                      !string_starts_with_ignore_case("Acc", "accept"));
+    string headers = "Host: example.com\r\nUser-Agent: test\r\nCONTENT-LENGTH: 42\r\n";
+    print_test_result("string_find_ignore_case", string_find_ignore_case(headers, "content-length:") == 37 &&
+                      string_find_ignore_case(headers, "host", 1) == -1LL && string_find_ignore_case(headers, "") == 0);
 
     // Substring & Finding
     print_test_result("string_substring", string_substring(s2, 5, 5) == "World");
@@ -371,12 +602,111 @@ void test_string_manipulation_functions() {
     print_test_result("string_find_char (not found)", string_find_char(s1, 'z') == -1LL);
     print_test_result("string_find_substring (found)", string_find_substring(s1, "World") == 8);
     print_test_result("string_find_substring (not found)", string_find_substring(s1, "Atomix") == -1LL);
+    print_test_result("string_find_substring (start_pos past match)", string_find_substring(s1, "World", 9) == -1LL &&
+                      string_find_substring(s1, "", 3) == 3);
+    string long_needle = "needle-" + string(40, 'x') + "-end";
+    string hay = string(100, 'x') + long_needle + string(50, 'x') + long_needle;
+    Searcher long_searcher(long_needle); // Long needle takes the Two-Way path
+    print_test_result("Searcher (long needle, reused)", long_searcher.find(hay) == 100 &&
+                      long_searcher.find(hay, 101) == 100 + long_needle.size() + 50 && long_searcher.find("short") == string_view::npos);
+    string periodic(200, 'a');
+    print_test_result("Searcher (periodic needle)", Searcher(string(40, 'a') + "b").find(periodic + "b") == 160 &&
+                      Searcher(string(40, 'a') + "b").find(periodic) == string_view::npos);
+    vector<size_t> all = string_find_all("abababa", "aba");
+    vector<size_t> all_overlap = string_find_all("abababa", "aba", true);
+    print_test_result("string_find_all (non-overlapping / overlapping)", all.size() == 2 && all[1] == 4 &&
+                      all_overlap.size() == 3 && all_overlap[1] == 2 && string_find_all("abc", "").empty());
+    print_test_result("string_count_substring", string_count_substring("aaaa", "aa") == 2 &&
+                      string_count_substring("aaaa", "aa", true) == 3 && string_count_substring("abc", "zz") == 0);
+
+    // Multi-pattern matching
+    MultiPatternMatcher keywords({"he", "she", "his", "hers", ""});
+    vector<PatternMatch> kw = keywords.find_all("ushers");
+    bool kw_ok = kw.size() == 3 && kw[0].pattern_id == 1 && kw[0].offset == 1 && // "she" and "he" both end at 3
+                 kw[1].pattern_id == 0 && kw[1].offset == 2 && kw[2].pattern_id == 3 && kw[2].offset == 2;
+    print_test_result("MultiPatternMatcher::find_all (overlapping, empty pattern ignored)", kw_ok);
+    print_test_result("MultiPatternMatcher::contains_any", keywords.contains_any("this") && !keywords.contains_any("xyz") &&
+                      !MultiPatternMatcher().contains_any("anything"));
+    MultiPatternMatcher::StreamState stream;
+    vector<PatternMatch> streamed;
+    keywords.scan_chunk(stream, "us", streamed);
+    keywords.scan_chunk(stream, "h", streamed); // "she" spans all three chunks
+    keywords.scan_chunk(stream, "ers", streamed);
+    print_test_result("MultiPatternMatcher::scan_chunk (match across chunks)", streamed.size() == 3 && streamed[0].offset == 1 &&
+                      streamed[2].pattern_id == 3);
 
     // Modification & Split/Join
     print_test_result("string_replace_char", string_replace_char("banana", 'a', 'o') == "bonono");
+    print_test_result("string_replace_all", string_replace_all("a-b-c", "-", "::") == "a::b::c" &&
+                      string_replace_all("aaaa", "aa", "b") == "bb" && string_replace_all("abc", "", "x") == "abc");
+    char replace_buf[8];
+    size_t needed = string_replace_all_into("x.y.z", ".", "--", replace_buf, sizeof(replace_buf));
+    print_test_result("string_replace_all_into (fits / too small)", needed == 7 && string(replace_buf, needed) == "x--y--z" &&
+                      string_replace_all_into("x.y.z", ".", "--", replace_buf, 6) == 7);
+    string shrink = "one, two, three";
+    const char* shrink_data = shrink.data();
+    size_t shrink_count = string_replace_all_inplace(shrink, ", ", ",");
+    string grow = "a.b";
+    print_test_result("string_replace_all_inplace (shrinks in place / grows)", shrink_count == 2 && shrink == "one,two,three" &&
+                      shrink.data() == shrink_data && string_replace_all_inplace(grow, ".", "...") == 1 && grow == "a...b");
+    StringRewriter escaper({{"&", "&amp;"}, {"<", "&lt;"}, {">", "&gt;"}});
+    StringRewriter longest({{"ab", "1"}, {"abc", "2"}, {"bcd", "3"}});
+    string redacted = "user=alice pass=hunter2";
+    StringRewriter redactor({{"alice", "*****"}, {"hunter2", "*******"}});
+    print_test_result("StringRewriter (rules, leftmost-longest, in place)",
+                      escaper.rewrite("<a & b>") == "&lt;a &amp; b&gt;" && longest.rewrite("abcd") == "2d" &&
+                      redactor.rewrite_inplace(redacted) == 2 && redacted == "user=***** pass=*******");
     vector<string> split_res = string_split(s_csv, ',');
     print_test_result("string_split", split_res.size()==3 && split_res[0]=="a" && split_res[1]=="b" && split_res[2]=="c");
     print_test_result("string_join", string_join(v_str, "-") == "x-y-z");
+    StringBuilder record(64);
+    size_t reserved = record.capacity();
+    record.append("id=").append(42).append(',').append(string_view("temp=")).append(-3.5).append(",n=").append(18446744073709551615ULL);
+    print_test_result("StringBuilder (strings, chars, numbers, no regrowth)",
+                      record.view() == "id=42,temp=-3.5,n=18446744073709551615" && record.capacity() == reserved);
+    vector<string_view> view_parts = {"a", "bb", "ccc"};
+    const char* c_parts[] = {"x", "y"};
+    StringBuilder joined;
+    joined.append('[').append_join(view_parts, ", ").append(']');
+    print_test_result("StringBuilder::append_join / string_join_range", joined.release() == "[a, bb, ccc]" && joined.empty() &&
+                      string_join_range(c_parts, "+") == "x+y" && string_join_range(vector<string>(), ",").empty());
+    print_test_result("string_split (trailing delimiter, legacy)", string_split("a,b,", ',').size() == 2 && string_split("", ',').empty());
+
+    // Zero-copy splitting
+    string log_line = "2024-01-01 12:00:00,INFO,,worker-3,done";
+    vector<string_view> views = string_split_view(log_line, ',');
+    bool views_ok = views.size() == 5 && views[1] == "INFO" && views[2].empty() && views[4] == "done" &&
+                    views[0].data() == log_line.data(); // Points into the original buffer
+    print_test_result("string_split_view (single delimiter)", views_ok);
+    vector<string_view> multi = string_split_view("a b\tc  d", " \t", true);
+    print_test_result("string_split_view (multiple delimiters, skip empty)", multi.size() == 4 && multi[2] == "c" && multi[3] == "d");
+    print_test_result("string_split_view (trailing/empty input)", string_split_view("a,", ',').size() == 2 && string_split_view("", ',').empty());
+    size_t lazy_count = 0;
+    string lazy_joined;
+    for (string_view token : string_split_range("x;;y;z;", ';', true)) {
+        lazy_count++;
+        lazy_joined += token;
+    }
+    print_test_result("string_split_range (lazy, skip empty)", lazy_count == 3 && lazy_joined == "xyz");
+
+    // Byte scanning (vector paths need inputs longer than 32 bytes)
+    print_test_result("string_find_any_of (found)", string_find_any_of("key=value;next", "=;") == 3);
+    print_test_result("string_find_any_of (start_pos)", string_find_any_of("key=value;next", "=;", 4) == 9);
+    print_test_result("string_find_any_of (not found)", string_find_any_of("plain text", ",;|") == -1LL);
+    bool scan_ok = true;
+    for (size_t len = 1; len <= 100 && scan_ok; ++len) {
+        for (size_t hit = 0; hit < len && scan_ok; ++hit) {
+            string buf(len, 'a');
+            buf[hit] = '\xE9'; // Second set fits the nibble lookup, third has too many high nibbles
+            scan_ok = string_find_char(buf, '\xE9') == static_cast<long long>(hit) &&
+                      string_find_any_of(buf, "\t\xE9|") == static_cast<long long>(hit) &&
+                      string_find_any_of(buf, "\x01\x91\xA1!,:@[`{\xE9") == static_cast<long long>(hit);
+        }
+    }
+    string long_line(70, 'x');
+    print_test_result("string_find_char / string_find_any_of (every length and offset)", scan_ok &&
+                      string_find_char(long_line, 'y') == -1LL && string_find_any_of(long_line, ",;") == -1LL &&
+                      string_find_char(long_line, 'x', 70) == -1LL);
 
     // Prefix/Suffix
     print_test_result("string_starts_with (true)", string_starts_with("prefix_text", "prefix"));
@@ -391,7 +721,106 @@ void test_string_manipulation_functions() {
     print_test_result("string_to_float (invalid)", !string_to_float(s_float_invalid, &f_val));
     bool d_ok = string_to_double(" -1.23456789e+5 ", &d_val);
     print_test_result("string_to_double (valid)", d_ok && doubles_are_close(d_val, -123456.789, d_eps));
-    print_test_result("string_to_double (invalid)", !string_to_double("nan", &d_val)); // Does not parse nan/inf currently
+    print_test_result("string_to_double (invalid)", !string_to_double("nan", &d_val)); // NaN is rejected
+    bool inf_ok = string_to_double("-inf", &d_val) && std::isinf(d_val) && d_val < 0;
+    print_test_result("string_to_double (inf, '+', underflow, overflow)", inf_ok && string_to_double(" +2.5\n", &d_val) && d_val == 2.5 &&
+                      string_to_double("1e-400", &d_val) && d_val == 0.0 && !string_to_double("1e400", &d_val) &&
+                      !string_to_double("+-1", &d_val) && !string_to_double("1.5x", &d_val) && !string_to_double("", &d_val));
+    print_test_result("string_to_float (overflow)", !string_to_float("1e39", &f_val));
+    int i_val = -1;
+    long l_val = -1;
+    print_test_result("string_to_int", string_to_int(" +42 ", &i_val) && i_val == 42 && !string_to_int("2147483648", &i_val) &&
+                      !string_to_int("4 2", &i_val) && i_val == 42); // Failures leave the output alone
+    print_test_result("string_to_long", string_to_long("-9000000000", &l_val) == (sizeof(long) == 8) && !string_to_long("abc", &l_val));
+
+    // Bulk column parsing
+    vector<int> int_column;
+    vector<ColumnParseError> column_errors;
+    size_t int_parsed = parse_int_column("1,-22,+333\r\n123456789, 1234567890123456 ,x\n\n2147483648,7,", ',', int_column, &column_errors);
+    print_test_result("parse_int_column", int_parsed == 5 && int_column == vector<int>({1, -22, 333, 123456789, 0, 0, 0, 7}) &&
+                      column_errors.size() == 3 && column_errors[0].field_index == 4 && column_errors[1].text == "x" &&
+                      column_errors[2].field_index == 6 && column_errors[2].offset == 44);
+    vector<long> long_column;
+    print_test_result("parse_long_column", parse_long_column("-123456789012345678\t9\t", '\t', long_column) == 2 &&
+                      long_column[0] == (sizeof(long) == 8 ? -123456789012345678L : 0L) && long_column[1] == 9);
+    vector<double> double_column;
+    print_test_result("parse_double_column", parse_double_column("1.5;-2e3;;nan\n", ';', double_column, &column_errors) == 2 &&
+                      double_column == vector<double>({1.5, -2000.0, 0.0, 0.0}) && column_errors.size() == 2);
+    string big_column;
+    for (int i = 0; i < 400000; ++i) big_column += (i % 1000 == 999 ? "bad" : to_string(i * 37 - 5000000)) + (i % 8 == 7 ? "\n" : ",");
+    vector<float> serial_floats, parallel_floats;
+    vector<ColumnParseError> serial_errors, parallel_errors;
+    size_t serial_parsed = parse_float_column(big_column, ',', serial_floats, &serial_errors, 1);
+    size_t parallel_parsed = parse_float_column(big_column, ',', parallel_floats, &parallel_errors, 4);
+    bool same_errors = serial_errors.size() == parallel_errors.size();
+    for (size_t i = 0; same_errors && i < serial_errors.size(); ++i) {
+        same_errors = serial_errors[i].field_index == parallel_errors[i].field_index && serial_errors[i].offset == parallel_errors[i].offset;
+    }
+    print_test_result("parse_float_column (parallel matches serial)", serial_parsed == 399600 && parallel_parsed == serial_parsed &&
+                      serial_floats == parallel_floats && same_errors && serial_floats[1] == -4999963.0f);
+
+    // Delimited record reading
+    DelimitedOptions csv_options;
+    csv_options.has_header = true;
+    DelimitedReader csv_reader({ColumnType::Int, ColumnType::String, ColumnType::Double}, csv_options);
+    ColumnTable table;
+    csv_reader.read_buffer("id,name,score\r\n1,plain,2.5\r\n\r\n2,\"a, \"\"quoted\"\"\nline\",-1e3\n3,x\n4,bad,oops\n5,,7", table);
+    const vector<DelimitedError>& csv_errors = table.errors();
+    print_test_result("DelimitedReader (quotes, header, errors)", table.row_count() == 5 && table.column_count() == 3 &&
+                      table.column_name(1) == "name" && table.int_column(0) == vector<int>({1, 2, 0, 4, 5}) &&
+                      table.string_at(1, 1) == "a, \"quoted\"\nline" && table.string_at(1, 4).empty() &&
+                      table.double_column(2) == vector<double>({2.5, -1000.0, 0.0, 0.0, 7.0}) && table.string_at(0, 0).empty() &&
+                      csv_errors.size() == 2 && csv_errors[0].record == 2 && csv_errors[0].column == string::npos &&
+                      csv_errors[1].record == 3 && csv_errors[1].column == 2 && csv_errors[1].text == "oops");
+
+    string csv_text;
+    for (int i = 0; i < 20000; ++i) {
+        csv_text += to_string(i) + (i % 3 ? ",\"row\n" : ",\"r\"\"") + to_string(i) + "\"," + to_string(i * 0.25) + "\n";
+    }
+    string csv_path = "atomix_test_records.csv";
+    FILE* csv_file = fopen(csv_path.c_str(), "wb");
+    bool csv_written = csv_file && fwrite(csv_text.data(), 1, csv_text.size(), csv_file) == csv_text.size();
+    if (csv_file) fclose(csv_file);
+    DelimitedOptions stream_options;
+    stream_options.chunk_size = 4096; // Many chunks, with records and quoted newlines across their edges
+    ColumnTable chunked_table, whole_table;
+    bool read_ok = csv_written && DelimitedReader({ColumnType::Long, ColumnType::String, ColumnType::Float}, stream_options).read_file(csv_path, chunked_table);
+    DelimitedOptions parallel_options;
+    parallel_options.num_threads = 4; // Several runs of records parsed on worker threads
+    DelimitedReader({ColumnType::Long, ColumnType::String, ColumnType::Float}, parallel_options).read_buffer(csv_text, whole_table);
+    bool same_rows = chunked_table.row_count() == 20000 && whole_table.row_count() == 20000 && chunked_table.errors().empty() &&
+                     chunked_table.long_column(0) == whole_table.long_column(0) && chunked_table.float_column(2) == whole_table.float_column(2);
+    for (size_t r = 0; same_rows && r < 20000; ++r) same_rows = chunked_table.string_at(1, r) == whole_table.string_at(1, r);
+    print_test_result("DelimitedReader (chunked file matches buffer)", read_ok && same_rows && whole_table.long_column(0)[19999] == 19999 &&
+                      whole_table.string_at(1, 3) == "r\"3" && whole_table.string_at(1, 4) == "row\n4" && whole_table.float_column(2)[2] == 0.5f);
+    remove(csv_path.c_str());
+
+    ColumnTable stray_table;
+    DelimitedReader({ColumnType::Int, ColumnType::String, ColumnType::Int}).read_buffer("1,5\" disk,2\n3,ok,4\n5,ok,6\n", stray_table);
+    print_test_result("DelimitedReader (stray quote)", stray_table.row_count() == 3 && stray_table.int_column(0) == vector<int>({1, 3, 5}) &&
+                      stray_table.int_column(2) == vector<int>({2, 4, 6}) && stray_table.string_at(1, 2) == "ok" &&
+                      stray_table.errors().size() == 1 && stray_table.errors()[0].record == 0 && stray_table.errors()[0].column == 1);
+
+    string long_text = "1,a\n2," + string(300, 'x') + "\n3,\"q\nq\"\n4,5\" disk\n";
+    for (int i = 5; i < 40; ++i) long_text += to_string(i) + ",r\n";
+    csv_file = fopen(csv_path.c_str(), "wb");
+    csv_written = csv_file && fwrite(long_text.data(), 1, long_text.size(), csv_file) == long_text.size();
+    if (csv_file) fclose(csv_file);
+    DelimitedOptions small_options;
+    small_options.chunk_size = 64;       // The long record spans several chunks
+    small_options.max_record_size = 100; // The stray quote stays open for more than this
+    DelimitedReader small_reader({ColumnType::Int, ColumnType::String}, small_options);
+    ColumnTable long_file_table, long_buffer_table;
+    read_ok = csv_written && small_reader.read_file(csv_path, long_file_table);
+    small_reader.read_buffer(long_text, long_buffer_table);
+    remove(csv_path.c_str());
+    const vector<DelimitedError>& long_errors = long_file_table.errors();
+    print_test_result("DelimitedReader (record longer than a chunk)", read_ok && long_file_table.row_count() == 39 &&
+                      long_file_table.int_column(0)[1] == 0 && long_file_table.int_column(0)[2] == 3 && long_file_table.string_at(1, 2) == "q\nq" &&
+                      long_file_table.int_column(0)[38] == 39 && long_file_table.int_column(0) == long_buffer_table.int_column(0) &&
+                      long_errors.size() == 2 && long_buffer_table.errors().size() == 2 && long_errors[0].record == 1 &&
+                      long_errors[0].column == string::npos && long_errors[0].text.size() == 64 && long_errors[1].record == 3 && long_errors[1].column == 1);
+    print_test_result("DelimitedReader (missing file)", !csv_reader.read_file("atomix_no_such_file.csv", table) && table.row_count() == 0);
 }
 
 void test_utility_functions() {
@@ -419,6 +848,39 @@ void test_utility_functions() {
      print_test_result("get_random_float (range check)", rand_float_ok);
      print_test_result("get_random_double (range check)", rand_double_ok);
 
+     // Non-uniform distributions (sample moments over a large batch)
+     const size_t n_samples = 200000;
+     vector<double> normals(n_samples);
+     bool fill_ok = fill_random_normal(normals.data(), n_samples, 5.0, 2.0);
+     double n_mean = 0.0, n_var = 0.0;
+     for (double v : normals) n_mean += v;
+     n_mean /= n_samples;
+     for (double v : normals) n_var += (v - n_mean) * (v - n_mean);
+     n_var /= n_samples;
+     print_test_result("fill_random_normal (mean/stddev)", fill_ok && fabs(n_mean - 5.0) < 0.03 && fabs(sqrt(n_var) - 2.0) < 0.03);
+
+     vector<double> exps(n_samples);
+     fill_ok = fill_random_exponential(exps.data(), n_samples, 4.0);
+     double e_mean = 0.0;
+     bool e_nonneg = true;
+     for (double v : exps) { e_mean += v; if (v < 0.0) e_nonneg = false; }
+     e_mean /= n_samples;
+     print_test_result("fill_random_exponential (mean 1/lambda)", fill_ok && e_nonneg && fabs(e_mean - 0.25) < 0.005);
+     print_test_result("fill_random_exponential (invalid lambda)", !fill_random_exponential(exps.data(), n_samples, 0.0));
+
+     vector<int> small_pois(n_samples), large_pois(n_samples);
+     bool pois_ok = fill_random_poisson(small_pois.data(), n_samples, 3.5) &&
+                    fill_random_poisson(large_pois.data(), n_samples, 250.0);
+     double ps_mean = 0.0, pl_mean = 0.0;
+     for (size_t i = 0; i < n_samples; ++i) { ps_mean += small_pois[i]; pl_mean += large_pois[i]; }
+     ps_mean /= n_samples;
+     pl_mean /= n_samples;
+     print_test_result("fill_random_poisson (mean, small and large)", pois_ok && fabs(ps_mean - 3.5) < 0.03 && fabs(pl_mean - 250.0) < 0.3);
+
+     double single_normal = get_random_normal(0.0, 1.0);
+     print_test_result("get_random_normal (finite)", std::isfinite(single_normal));
+     print_test_result("get_random_poisson (zero mean)", get_random_poisson(0.0) == 0);
+
      // Timer check
      auto start = start_timer();
      this_thread::sleep_for(chrono::milliseconds(15)); // Sleep briefly (adjust if needed)
@@ -426,11 +888,384 @@ void test_utility_functions() {
      // Check if elapsed time is roughly positive and reasonable (e.g., > 0.01 seconds)
      print_test_result("start/stop_timer (check > ~0.01s)", elapsed > 0.01 && elapsed < 0.1); // Adjust bounds based on system speed/load
 
+    // Cycle timer: ticks convert to about the same interval as steady_clock measures
+    auto timer_start = start_timer();
+    unsigned long long cycles_start = start_cycles();
+    this_thread::sleep_for(chrono::milliseconds(15));
+    unsigned long long cycles_end = stop_cycles();
+    double steady_ns = stop_timer(timer_start) * 1e9;
+    double cycle_ns = cycles_to_ns(cycles_end - cycles_start);
+    print_test_result("start/stop_cycles (agrees with steady_clock)",
+                      cycles_end > cycles_start && cycle_ns > 0.01e9 && cycle_ns <= steady_ns * 1.01 && cycle_ns >= steady_ns * 0.9);
+    print_test_result("cycles_per_ns (1 without TSC, else plausible)",
+                      cycle_timer_uses_tsc() ? (cycles_per_ns() > 0.1 && cycles_per_ns() < 10.0) : cycles_per_ns() == 1.0);
+
+    // Benchmark harness: short runs, statistics in order, JSON round trip
+    BenchmarkOptions bench_options;
+    bench_options.min_sample_seconds = 0.001;
+    bench_options.warmup_seconds = 0.001;
+    bench_options.samples = 10;
+    BenchmarkRunner runner(bench_options);
+    vector<int> bench_data(256, 3);
+    BenchmarkResult summed = runner.run("sum \"256\" ints", [&] {
+        int total = 0;
+        for (int v : bench_data) total += v;
+        do_not_optimize(total);
+    }, 256.0, 256.0 * sizeof(int));
+    print_test_result("BenchmarkRunner (auto-scaled, ordered stats)",
+                      summed.iterations > 1 && summed.samples + summed.outliers == 10 && summed.min_ns > 0.0 &&
+                      summed.min_ns <= summed.median_ns && summed.median_ns <= summed.p99_ns &&
+                      summed.p99_ns <= summed.max_ns && summed.items_per_second > 0.0 &&
+                      doubles_are_close(summed.bytes_per_second, summed.items_per_second * sizeof(int), 1e-3 * summed.bytes_per_second));
+    runner.run("sleep 2ms", [] { this_thread::sleep_for(chrono::milliseconds(2)); });
+    print_test_result("BenchmarkRunner (slow body, one iteration per sample)",
+                      runner.results().back().iterations == 1 && runner.results().back().median_ns > 1.5e6);
+    vector<BenchmarkResult> loaded;
+    bool parsed = parse_benchmark_json(runner.to_json(), loaded);
+    print_test_result("parse_benchmark_json (round trip)",
+                      parsed && loaded.size() == 2 && loaded[0].name == "sum \"256\" ints" &&
+                      loaded[0].iterations == summed.iterations && loaded[0].median_ns == summed.median_ns &&
+                      loaded[1].p99_ns == runner.results()[1].p99_ns);
+    loaded[0].median_ns *= 0.5; // Pretend the baseline was twice as fast
+    loaded[1].name = "retired";
+    vector<BenchmarkComparison> changes = compare_benchmarks(loaded, runner.results());
+    print_test_result("compare_benchmarks (change, missing and new)",
+                      changes.size() == 3 && doubles_are_close(changes[0].change, 1.0, 1e-9) &&
+                      changes[1].name == "retired" && changes[1].current_ns == 0.0 &&
+                      changes[2].name == "sleep 2ms" && changes[2].baseline_ns == 0.0);
+
+    // Performance counters: whatever opens must count; anything refused reads -1
+    PerfCounterGroup perf;
+    perf.start();
+    vector<char> touched(64 << 20); // Fresh pages fault on first touch (fewer with huge pages)
+    for (size_t i = 0; i < touched.size(); i += 4096) touched[i] = 1;
+    PerfCounts counted = perf.stop();
+    bool counts_sane = true;
+    if (!perf.available()) {
+        counts_sane = counted.cycles == -1.0 && counted.page_faults == -1.0 && counted.ipc() == -1.0;
+    } else {
+        if (counted.page_faults != -1.0) counts_sane = counted.page_faults > 0.0;
+        if (perf.has_hardware_counters() && counted.instructions != -1.0) counts_sane = counts_sane && counted.instructions > 16384.0;
+    }
+    print_test_result("PerfCounterGroup (counts or degrades to -1)", counts_sane);
+    PerfCounts halved = counted.per_operation(2.0);
+    print_test_result("PerfCounts::per_operation",
+                      (counted.page_faults < 0.0 ? halved.page_faults == counted.page_faults
+                                                 : doubles_are_close(halved.page_faults * 2.0, counted.page_faults)) &&
+                      (counted.cycles < 0.0 ? halved.cycles == -1.0 : doubles_are_close(halved.cycles * 2.0, counted.cycles)));
+    bench_options.perf_counters = true;
+    BenchmarkRunner counting_runner(bench_options);
+    counting_runner.run("fresh vector", [] {
+        vector<int> fresh(1024, 1);
+        do_not_optimize(fresh.data());
+    });
+    const PerfCounts& per_call = counting_runner.results()[0].counters;
+    vector<BenchmarkResult> counted_loaded;
+    parse_benchmark_json(counting_runner.to_json(), counted_loaded);
+    print_test_result("BenchmarkRunner (perf counters per iteration, JSON)",
+                      counted_loaded.size() == 1 && counted_loaded[0].counters.page_faults == per_call.page_faults &&
+                      counted_loaded[0].counters.instructions == per_call.instructions &&
+                      (per_call.page_faults == -1.0 || per_call.page_faults >= 0.0));
+
     // Memory helpers are tested implicitly via C-style array tests needing cleanup,
     // but direct testing is harder without known allocated pointers.
 }
 
 
+void test_profiling_zones() {
+    cout << "\n--- Testing Profiling Zones ---" << endl;
+    vector<ProfileEvent> events;
+    drain_profile_events(events); // Start from empty rings
+    events.clear();
+
+    { ScopedZone zone("disabled"); }
+    drain_profile_events(events);
+    print_test_result("ScopedZone (disabled: nothing recorded)", events.empty() && !profiling_enabled());
+
+    set_profiling_enabled(true);
+    {
+        ScopedZone outer("outer");
+        ScopedZone inner("inner");
+    }
+    thread worker([] {
+        ScopedZone zone("worker");
+        this_thread::sleep_for(chrono::milliseconds(2));
+    });
+    worker.join();
+    drain_profile_events(events);
+    bool nested = events.size() == 3 && string(events[0].name) == "inner" && string(events[1].name) == "outer" &&
+                  events[1].start_cycles <= events[0].start_cycles && events[0].end_cycles <= events[1].end_cycles;
+    bool threads = events.size() == 3 && string(events[2].name) == "worker" && events[2].thread_id != events[0].thread_id &&
+                   cycles_to_ns(events[2].end_cycles - events[2].start_cycles) > 1.5e6;
+    print_test_result("ScopedZone (nested, ordered by end)", nested);
+    print_test_result("ScopedZone (other thread, duration)", threads);
+
+    size_t dropped_before = profile_events_dropped();
+    for (int i = 0; i < 10000; ++i) {
+        ScopedZone zone("flood");
+    }
+    events.clear();
+    size_t drained = drain_profile_events(events);
+    print_test_result("ScopedZone (full ring drops, never blocks)",
+                      drained == 8192 && profile_events_dropped() - dropped_before == 10000 - 8192);
+
+    const char* trace_path = "atomix_test_trace.json";
+    {
+        TraceWriter writer(trace_path);
+        writer.start_background_flush(chrono::milliseconds(1));
+        for (int i = 0; i < 100; ++i) {
+            ScopedZone zone("traced \"zone\"");
+        }
+        this_thread::sleep_for(chrono::milliseconds(20));
+        { ScopedZone zone("last"); }
+        print_test_result("TraceWriter (open, close)", writer.is_open() && writer.close() && !writer.is_open());
+    }
+    set_profiling_enabled(false);
+    ifstream trace_file(trace_path);
+    stringstream trace;
+    trace << trace_file.rdbuf();
+    string json = trace.str();
+    size_t zones = string_count_substring(json, "\"ph\": \"X\"");
+    print_test_result("TraceWriter (Chrome trace JSON)",
+                      string_starts_with(json, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [") &&
+                      string_ends_with(json, "]}\n") && zones == 101 &&
+                      json.find("\"traced \\\"zone\\\"\"") != string::npos && json.find("\"last\"") != string::npos);
+    remove(trace_path);
+}
+
+void test_latency_histograms() {
+    cout << "\n--- Testing Latency Histograms ---" << endl;
+    LatencyHistogram histogram(1000000000ULL, 3);
+    for (unsigned long long v = 1; v <= 100000; ++v) histogram.record(v);
+    bool within = true;
+    for (double p : {1.0, 50.0, 90.0, 99.0, 99.9}) {
+        double exact = p * 1000.0;
+        within = within && fabs(static_cast<double>(histogram.value_at_percentile(p)) - exact) <= exact * 1e-3;
+    }
+    print_test_result("LatencyHistogram (percentiles within 0.1%)",
+                      within && histogram.value_at_percentile(100.0) == 100000 && histogram.value_at_percentile(0.0) == 1);
+    print_test_result("LatencyHistogram (count, min, max, mean)",
+                      histogram.count() == 100000 && histogram.min() == 1 && histogram.max() == 100000 &&
+                      fabs(histogram.mean() - 50000.5) < 50.0);
+
+    LatencyHistogram small(1000, 2);
+    small.record(5000);
+    small.record(0, 3);
+    print_test_result("LatencyHistogram (clamps above highest, repeat counts)",
+                      small.count() == 4 && small.max() == 1000 && small.value_at_percentile(75.0) == 0);
+
+    LatencyHistogram other(1000000000ULL, 3);
+    other.record(200000, 100000); // A slow tail as large as the whole first histogram
+    LatencyHistogram coarse(1000000ULL, 2);
+    coarse.record(777, 10);
+    bool merged = histogram.merge(other) && histogram.merge(coarse);
+    print_test_result("LatencyHistogram::merge (same and different layouts)",
+                      merged && histogram.count() == 200010 && histogram.max() == 200000 &&
+                      histogram.value_at_percentile(40.0) <= 80080 && histogram.value_at_percentile(60.0) >= 199800);
+    histogram.reset();
+    print_test_result("LatencyHistogram::reset", histogram.count() == 0 && histogram.value_at_percentile(50.0) == 0);
+
+    ConcurrentLatencyHistogram shared(1000000000ULL, 3);
+    vector<thread> recorders;
+    for (int t = 0; t < 4; ++t) {
+        recorders.emplace_back([&shared, t] {
+            for (unsigned long long v = 1; v <= 50000; ++v) shared.record(v * (t + 1));
+        });
+    }
+    for (thread& recorder : recorders) recorder.join();
+    LatencyHistogram snapshot = shared.snapshot();
+    print_test_result("ConcurrentLatencyHistogram (4 threads, snapshot)",
+                      shared.count() == 200000 && snapshot.count() == 200000 && snapshot.min() == 1 &&
+                      snapshot.max() == 200000 && fabs(static_cast<double>(snapshot.value_at_percentile(100.0)) - 200000.0) < 1.0);
+
+    LatencyHistogram timed;
+    {
+        ScopedLatency latency(timed);
+        this_thread::sleep_for(chrono::milliseconds(2));
+    }
+    print_test_result("ScopedLatency (records nanoseconds)", timed.count() == 1 && timed.min() >= 1500000 && timed.max() < 1000000000ULL);
+}
+
+void test_sampling_functions() {
+    cout << "\n--- Testing Streaming Sampling ---" << endl;
+
+    // Every item of 0..99 should land in a size-10 reservoir ~10% of the time
+    const int trials = 20000;
+    vector<int> stream(100);
+    for (int i = 0; i < 100; ++i) stream[i] = i;
+    vector<int> hits(100, 0), merged_hits(100, 0);
+    bool sizes_ok = true;
+    for (int t = 0; t < trials; ++t) {
+        ReservoirSampler<int> sampler(10, 1000 + t);
+        sampler.offer(stream); // Batched ingestion
+        if (sampler.sample().size() != 10 || sampler.seen() != 100) sizes_ok = false;
+        for (int v : sampler.sample()) hits[v]++;
+
+        // Two per-thread style reservoirs over disjoint halves, merged
+        ReservoirSampler<int> left(10, 5000000 + t), right(10, 9000000 + t);
+        left.offer(stream.data(), 30);
+        for (int i = 30; i < 100; ++i) right.offer(stream[i]); // Single-item ingestion
+        left.merge(right);
+        if (left.sample().size() != 10 || left.seen() != 100) sizes_ok = false;
+        for (int v : left.sample()) merged_hits[v]++;
+    }
+    int worst = 0, worst_merged = 0;
+    for (int i = 0; i < 100; ++i) {
+        worst = max(worst, abs(hits[i] - trials / 10));
+        worst_merged = max(worst_merged, abs(merged_hits[i] - trials / 10));
+    }
+    // Binomial stddev is ~42 here, so 200 is a > 4.5 sigma bound
+    print_test_result("ReservoirSampler (sizes and seen count)", sizes_ok);
+    print_test_result("ReservoirSampler (uniform inclusion)", worst < 200);
+    print_test_result("ReservoirSampler::merge (uniform inclusion)", worst_merged < 200);
+
+    ReservoirSampler<string> small(5, 1);
+    small.offer(string("only"));
+    print_test_result("ReservoirSampler (fewer items than capacity)", small.sample().size() == 1 && small.sample()[0] == "only");
+    ReservoirSampler<int> other_capacity(6, 1);
+    ReservoirSampler<int> base_capacity(5, 1);
+    print_test_result("ReservoirSampler::merge (capacity mismatch rejected)", !base_capacity.merge(other_capacity));
+
+    // Weighted: with capacity 1, item i is chosen with probability w_i / sum(w)
+    const char items[] = {'a', 'b', 'c'};
+    const double weights[] = {1.0, 2.0, 7.0};
+    int w_hits[3] = {0, 0, 0};
+    for (int t = 0; t < trials; ++t) {
+        WeightedReservoirSampler<char> ws(1, 77 + t);
+        ws.offer(items, weights, 3);
+        w_hits[ws.sample()[0] - 'a']++;
+    }
+    bool weighted_ok = abs(w_hits[0] - trials / 10) < 300 && abs(w_hits[1] - trials / 5) < 300 &&
+                       abs(w_hits[2] - trials * 7 / 10) < 300;
+    print_test_result("WeightedReservoirSampler (selection proportional to weight)", weighted_ok);
+
+    // Merged weighted samplers keep the capacity and ignore non-positive weights
+    WeightedReservoirSampler<int> wa(4, 1), wb(4, 2);
+    for (int i = 0; i < 50; ++i) wa.offer(i, 1.0 + i);
+    for (int i = 50; i < 100; ++i) wb.offer(i, 1.0 + i);
+    wb.offer(-1, 0.0);
+    wa.merge(wb);
+    vector<int> w_sample = wa.sample();
+    bool merge_ok = w_sample.size() == 4 && wa.seen() == 101 &&
+                    find(w_sample.begin(), w_sample.end(), -1) == w_sample.end();
+    print_test_result("WeightedReservoirSampler::merge", merge_ok);
+}
+
+
+void test_allocation_tracking() {
+    cout << "\n--- Testing Allocation Tracking ---" << endl;
+    CountingResource counting;
+    {
+        std::pmr::vector<int> values(&counting);
+        values.reserve(100);
+        for (int i = 0; i < 100; ++i) values.push_back(i);
+    }
+    AllocationStats pmr = counting.stats();
+    print_test_result("CountingResource (pmr vector)",
+                      pmr.allocations == 1 && pmr.deallocations == 1 && pmr.bytes == 100 * sizeof(int));
+    counting.reset();
+    print_test_result("CountingResource::reset", counting.stats().allocations == 0 && counting.stats().bytes == 0);
+
+    AllocationStats split;
+    {
+        AllocationScope scope;
+        vector<string> parts = string_split("alpha,beta,gamma,delta", ',');
+        split = scope.stats();
+    }
+    if (allocation_tracking_enabled()) {
+        print_test_result("AllocationScope (string_split allocates)", split.allocations >= 1 && split.bytes >= 4 * sizeof(string));
+        AllocationStats none;
+        {
+            AllocationScope scope;
+            int data[] = {3, 1, 2};
+            long long sum = 0;
+            bool summed = array_sum(data, 3, &sum);
+            none = scope.stats();
+            print_test_result("array_sum (inside an AllocationScope)", summed && sum == 6);
+        }
+        print_test_result("AllocationScope (array_sum does not allocate)", none.allocations == 0 && none.bytes == 0);
+
+        AllocationStats other_thread;
+        AllocationScope outer;
+        thread worker([&other_thread] {
+            AllocationScope scope;
+            vector<int> v(1000);
+            other_thread = scope.stats();
+        });
+        worker.join();
+        AllocationStats here = outer.stats();
+        print_test_result("AllocationScope (per thread)", other_thread.allocations >= 1 && other_thread.bytes >= 1000 * sizeof(int) &&
+                                                          here.bytes < 1000 * sizeof(int));
+    } else {
+        print_test_result("AllocationScope (zero without ATOMIX_TRACK_ALLOCATIONS)", split.allocations == 0 && split.bytes == 0);
+    }
+}
+
+// Collects diagnostics on the reporting thread for test_diagnostics
+static vector<Diagnostic> captured_diagnostics;
+static atomic<size_t> counted_diagnostics{0};
+
+void test_diagnostics() {
+    cout << "\n--- Testing Diagnostics ---" << endl;
+    set_diagnostic_sink([](const Diagnostic& d) { captured_diagnostics.push_back(d); });
+    clear_last_error();
+    print_test_result("last_error (None initially)", last_error() == ErrorCode::None);
+
+    string text = "Hello";
+    bool substring_failed = string_substring(text, 10, 2).empty() && last_error() == ErrorCode::OutOfRange;
+    int values[] = {1, 2, 2};
+    bool unique_failed = array_unique_int(values, 3, nullptr) == nullptr && last_error() == ErrorCode::NullArgument;
+    long long sum = 0;
+    bool sum_ok = array_sum(values, 3, &sum) && sum == 5 && last_error() == ErrorCode::NullArgument; // Success leaves it alone
+    bool exponential_failed = get_random_exponential(-1.0) == 0.0 && last_error() == ErrorCode::InvalidArgument;
+    print_test_result("Diagnostics (error codes via last_error)", substring_failed && unique_failed && sum_ok && exponential_failed);
+
+    bool captured = captured_diagnostics.size() == 3 && captured_diagnostics[0].code == ErrorCode::OutOfRange &&
+                    string(captured_diagnostics[0].function) == "string_substring" &&
+                    format_diagnostic(captured_diagnostics[0]) ==
+                        "Error in string_substring: start position (10) is out of range for a string of length 5." &&
+                    captured_diagnostics[2].code == ErrorCode::InvalidArgument;
+    print_test_result("Diagnostics (custom sink, format_diagnostic)", captured);
+
+    // Null and empty arguments set the code without a diagnostic
+    int max_val = 0;
+    bool max_null = !array_max(nullptr, 3, &max_val) && last_error() == ErrorCode::NullArgument;
+    clear_last_error();
+    bool sum_null = !array_sum(values, 3, nullptr) && last_error() == ErrorCode::NullArgument;
+    double average = 1.0;
+    bool average_empty = !array_average_double(vector<double>(), &average) && last_error() == ErrorCode::InvalidArgument;
+    clear_last_error();
+    bool not_found = array_index_of_int(values, 3, 7) == -1 && last_error() == ErrorCode::None;
+    print_test_result("Diagnostics (silent argument checks)", max_null && sum_null && average_empty && not_found &&
+                      captured_diagnostics.size() == 3);
+    print_test_result("error_code_name", string(error_code_name(ErrorCode::OutOfRange)) == "OutOfRange");
+    clear_last_error();
+    print_test_result("clear_last_error", last_error() == ErrorCode::None);
+
+    set_diagnostic_sink([](const Diagnostic&) { counted_diagnostics.fetch_add(1); });
+    vector<thread> workers;
+    vector<ErrorCode> worker_errors(4, ErrorCode::None);
+    for (int t = 0; t < 4; ++t) {
+        workers.emplace_back([t, &worker_errors] {
+            string s = "abc";
+            for (int i = 0; i < 1000; ++i) string_substring(s, 4, 1);
+            worker_errors[t] = last_error();
+        });
+    }
+    for (thread& worker : workers) worker.join();
+    bool per_thread = last_error() == ErrorCode::None;
+    for (ErrorCode code : worker_errors) per_thread = per_thread && code == ErrorCode::OutOfRange;
+    print_test_result("Diagnostics (4 threads, per-thread last_error)", counted_diagnostics.load() == 4000 && per_thread);
+
+    set_diagnostic_sink(nullptr); // Back to the rings and the stderr writer
+    size_t dropped_before = diagnostics_dropped();
+    clear_last_error();
+    bool ring_failed = string_substring(text, 6, 1).empty() && last_error() == ErrorCode::OutOfRange;
+    flush_diagnostics();
+    print_test_result("Diagnostics (default ring, flush_diagnostics)", ring_failed && diagnostics_dropped() == dropped_before);
+    clear_last_error();
+}
+
 // --- Main Function ---
 int main() {
     cout << "===== Atomix Library Test Suite v1.2.0 =====" << endl;
@@ -443,9 +1278,20 @@ int main() {
     test_string_vector_functions(); // Covers string vectors and C-style find_string
     test_string_manipulation_functions();
     test_utility_functions();
+    test_profiling_zones();
+    test_latency_histograms();
+    test_allocation_tracking();
+    test_diagnostics();
+    test_sampling_functions();
+    test_get_functions();
+#if defined(__unix__) || defined(__APPLE__)
+    test_batch_input();
+    test_timed_input();
+#endif
 
     // --- Run Interactive Tests (Optional) ---
-    // Uncomment the following line to manually test the get_* input functions.
+    // test_get_functions covers the same paths automatically; uncomment the following line
+    // to also try the get_* input functions by hand.
     // test_get_functions_interactive();
 
     cout << "\n===== Test Suite Finished =====" << endl;